@@ -1,5 +1,5 @@
 // cluster-lighting-system.js - Complete WASM clustered lighting system
-import { Color, Vector3, Vector4, Vector2, BufferGeometry, Float32BufferAttribute, WebGLRenderTarget, RGBAFormat, FloatType, NearestFilter, UnsignedByteType, RedIntegerFormat, UnsignedShortType, UnsignedIntType, MeshBasicMaterial, Scene, Mesh, DataTexture, MathUtils, PlaneGeometry, PerspectiveCamera, Matrix4 } from 'three';
+import { Color, Vector3, Vector4, Vector2, BufferGeometry, Float32BufferAttribute, WebGLRenderTarget, RGBAFormat, FloatType, NearestFilter, UnsignedByteType, RedIntegerFormat, UnsignedIntType, MeshBasicMaterial, Scene, Mesh, DataTexture, MathUtils, PlaneGeometry, PerspectiveCamera, Matrix4 } from 'three';
 import { getListMaterial, getMasterMaterial, getSuperMasterMaterial, ShaderVariants, lights_physical_pars_fragment } from './cluster-shaders.js';
 import { GPUQuery } from '../performance/performance-metrics.js';
 
@@ -59,6 +59,56 @@ class FullscreenTriangleGeometry extends BufferGeometry {
 const tempColor = new Color();
 const zeroColor = new Color(0);
 
+// Texture record layout the shaders decode; must match TEXTURE_LAYOUT_VERSION
+// in cluster-lights.c
+const TEXTURE_LAYOUT_VERSION = 4;
+
+// Texels per light record in each type's light texture
+const LightTexels = {
+  point: 3,
+  spot: 3,
+  rect: 4
+};
+
+// Derived work deferred by batches (see beginBatch)
+const Refresh = {
+  LIGHTS: 1,    // Counts, textures, proxy, cluster params, features, resolution
+  TEXTURES: 2,  // Light textures only
+  FEATURES: 4   // Shader feature flags only
+};
+
+// Light slots in the cluster index space. Each type starts on a 32-light
+// batch boundary so that no list-texture word mixes light types; the
+// padding slots between types are culled like invisible lights.
+function lightSlotCount(pointCount, spotCount, rectCount) {
+  return (((pointCount + 31) >> 5) + ((spotCount + 31) >> 5)) * 32 + rectCount;
+}
+
+// Slot indices of the core's light layout table (see getLightLayout in cluster-lights.c)
+const LightLayout = {
+  STRIDE: 0,
+  POSITION: 1,
+  COLOR: 2,
+  DECAY: 3,
+  VISIBLE: 4,
+  GROUP_MASK: 5,
+  LAYER_MASK: 6,
+  CASTS_SHADOW: 7,
+  SHADOW_INTENSITY: 8,
+  ANIM: 9,
+  DIRECTION: 10,
+  ANGLE: 11,
+  PENUMBRA: 12,
+  SIZE: 13,
+  NORMAL: 14,
+  ANIM_CIRCULAR: 15,
+  ANIM_LINEAR: 16,
+  ANIM_WAVE: 17,
+  ANIM_FLICKER: 18,
+  ANIM_PULSE: 19,
+  ANIM_ROTATION: 20
+};
+
 // Calculate optimal cluster resolution based on light count
 function calculateOptimalClusterResolution(lightCount) {
   if (lightCount > 2000) {
@@ -80,6 +130,14 @@ export class ClusterLightingSystem {
     this.wasm = ws.instance;
     this.performanceMode = performanceMode;
 
+    // Binaries built before the current record layouts decode as garbage
+    const exports = this.wasm.exports;
+    const layoutVersion = exports.getTextureLayoutVersion ? exports.getTextureLayoutVersion() : 1;
+    if (layoutVersion !== TEXTURE_LAYOUT_VERSION) {
+      throw new Error(`[ClusterLightingSystem] WASM core uses texture layout ${layoutVersion}, ` +
+        `expected ${TEXTURE_LAYOUT_VERSION}; rebuild it with npm run build:all`);
+    }
+
     // 2D texture layout configuration - adaptive based on GPU capability
     // Check GPU texture size limit
     const gl = renderer.getContext();
@@ -92,12 +150,20 @@ export class ClusterLightingSystem {
     const LIGHT_TEXTURE_WIDTH = this.maxTextureSize >= 16384 ? 2048 :
                                 this.maxTextureSize >= 8192 ? 1024 : 512;
 
-    // Calculate max lights using 2D texture layout (width × height / 2 texels per light)
+    // Calculate max lights using 2D texture layout (width × height / widest record)
     // Cap at 32,800 lights for stable performance across all systems
-    const theoretical2DMax = Math.floor((LIGHT_TEXTURE_WIDTH * this.maxTextureSize) / 2);
+    const theoretical2DMax = Math.floor((LIGHT_TEXTURE_WIDTH * this.maxTextureSize) / LightTexels.rect);
     this.maxSafeLights = Math.min(theoretical2DMax, 32800);
     this.lightTextureWidth = LIGHT_TEXTURE_WIDTH;
 
+    // Lights per texture row for each type, as a shift: the largest power of
+    // two whose records fit in LIGHT_TEXTURE_WIDTH texels
+    this.lightRowShifts = {
+      point: Math.floor(Math.log2(LIGHT_TEXTURE_WIDTH / LightTexels.point)),
+      spot: Math.floor(Math.log2(LIGHT_TEXTURE_WIDTH / LightTexels.spot)),
+      rect: Math.floor(Math.log2(LIGHT_TEXTURE_WIDTH / LightTexels.rect))
+    };
+
     // Pre-allocate WASM memory for max capacity
     const memoryMB = (this.maxSafeLights * 488 / 1024 / 1024).toFixed(2);
 
@@ -106,14 +172,18 @@ export class ClusterLightingSystem {
     // Set view frustum parameters
     this.wasm.exports.setViewFrustum(near, far);
     
-    // Light data arrays by type
+    // Light data arrays by type (JS mirrors of the core's records; see setLightMirrors)
+    this.mirrorLights = true;
     this.pointLights = [];
     this.spotLights = [];
     this.rectLights = [];
+    this._lightLayouts = null;
     
     // Track light indices for removal/update
     this.lightTypeMap = new Map(); // Maps global index to {type, typeIndex}
+    this._lightSlots = { point: [], spot: [], rect: [] }; // Same mappings, by typeIndex
     this.globalLightIndex = 0;
+    this.lightOrderVersion = 0; // Bumped whenever core indices move (command targets go stale)
     
     // Track camera movement with version number
     this.cameraMatrixVersion = 0;
@@ -137,6 +207,10 @@ export class ClusterLightingSystem {
     // Deferred sorting optimization
     this.deferSorting = true; // Don't sort after every operation (faster)
     this.sortDeferred = false; // Track if sort is needed
+    this._patching = false; // Batch in progress: skip per-light refreshes
+    this._batchDepth = 0; // Open beginBatch() calls
+    this._pendingRefresh = 0; // Refresh bits deferred by batching
+    this.autoBatch = false; // Defer derived work to the next update()
 
     // Object pooling for light objects to reduce GC pressure
     this.lightObjectPool = {
@@ -223,11 +297,20 @@ export class ClusterLightingSystem {
     this.spotLightTexture = { value: null };
     this.rectLightTexture = { value: null };
     this.lightCounts = { value: new Vector3(0, 0, 0) };
+    this.lightBatchBases = { value: new Vector2(0, 0) }; // First batch of spot (x) and rect (y) lights
+    this.lightSlotCount = 0;
+    this.staticPointLightCount = 0; // Compact static point lights, after the dynamic point records
+
+    // 2D texture layout uniforms: lights per row as a shift, per type
+    this.pointLightRowShift = { value: this.lightRowShifts.point };
+    this.spotLightRowShift = { value: this.lightRowShifts.spot };
+    this.rectLightRowShift = { value: this.lightRowShifts.rect };
+    this._lightTextureData = { point: null, spot: null, rect: null, unified: null }; // Padded copies (copy mode)
 
-    // 2D texture layout uniforms (separate for each light type)
-    this.pointLightTextureWidth = { value: this.lightTextureWidth };
-    this.spotLightTextureWidth = { value: this.lightTextureWidth };
-    this.rectLightTextureWidth = { value: this.lightTextureWidth };
+    // Unified mode (setUnifiedLightTexture): one texture for every light type
+    this.unifiedLights = false;
+    this.lightTexture = { value: null };
+    this.lightRowBases = { value: new Vector2(0, 0) }; // First row of spot (x) and rect (y) records
     
     this.masterTexture = { value: null };
     this.superMasterTexture = { value: null };
@@ -252,8 +335,9 @@ export class ClusterLightingSystem {
 
     this.proxy = new Mesh(proxyGeometry, getListMaterial());
     
-    ["pointLightTexture", "spotLightTexture", "rectLightTexture", "lightCounts",
-     "pointLightTextureWidth", "spotLightTextureWidth", "rectLightTextureWidth",
+    ["pointLightTexture", "spotLightTexture", "rectLightTexture", "lightTexture", "lightRowBases",
+     "lightCounts", "lightBatchBases",
+     "pointLightRowShift", "spotLightRowShift", "rectLightRowShift",
      "batchCount", "sliceParams", "clusterParams", "nearZ", "projectionMatrix", "viewMatrix", "maxTileSpan"].forEach((k) => {
       this.proxy.material.uniforms[k] = this[k];
     });
@@ -333,19 +417,82 @@ export class ClusterLightingSystem {
     }
   }
 
+  // Enable/disable the unified light texture: the core writes every light type
+  // into one texture (one upload and one sampler per frame) instead of three.
+  // Patched materials recompile with CLUSTER_UNIFIED_LIGHTS.
+  setUnifiedLightTexture(enabled) {
+    const exports = this.wasm.exports;
+    if (enabled && !exports.setUnifiedLightTexture) {
+      console.warn('[ClusterLightingSystem] WASM build has no unified light texture; keeping per-type textures');
+      return;
+    }
+    if (this.unifiedLights === enabled) return;
+
+    this.unifiedLights = exports.setUnifiedLightTexture(enabled ? 1 : 0) === 1;
+
+    // Release the textures of the mode no longer in use
+    const unused = this.unifiedLights
+      ? [this.pointLightTexture, this.spotLightTexture, this.rectLightTexture]
+      : [this.lightTexture];
+    for (const uniform of unused) {
+      if (uniform.value) uniform.value.dispose();
+      uniform.value = null;
+    }
+
+    // Per-type rows follow LIGHT_TEXTURE_WIDTH; unified shifts come from the
+    // core's layout on the next texture update
+    if (!this.unifiedLights) {
+      this.pointLightRowShift.value = this.lightRowShifts.point;
+      this.spotLightRowShift.value = this.lightRowShifts.spot;
+      this.rectLightRowShift.value = this.lightRowShifts.rect;
+    }
+
+    const listMaterial = this.proxy.material;
+    if (this.unifiedLights) {
+      listMaterial.defines.CLUSTER_UNIFIED_LIGHTS = '';
+    } else {
+      delete listMaterial.defines.CLUSTER_UNIFIED_LIGHTS;
+    }
+    listMaterial.needsUpdate = true;
+    this._updateAllMaterials(this._currentFragmentShader);
+  }
+
+  // Enable/disable the JS-side light mirrors. With mirrors off, light properties
+  // are read from WASM memory on demand (getLight, exportLights) and no per-light
+  // JS objects are kept, which saves heap and GC time with large light counts.
+  setLightMirrors(enabled) {
+    if (this.mirrorLights === enabled) return;
+    if (!enabled && !this._getLightLayout('point')) {
+      console.warn('[ClusterLightingSystem] WASM build has no light layout table; keeping JS light mirrors');
+      return;
+    }
+
+    this.mirrorLights = enabled;
+    if (enabled) {
+      // Rebuild from the core, which always holds the authoritative copy
+      this.pointLights = this._readLights('point');
+      this.spotLights = this._readLights('spot');
+      this.rectLights = this._readLights('rect');
+    } else {
+      this.pointLights = [];
+      this.spotLights = [];
+      this.rectLights = [];
+    }
+  }
+
   // Enable/disable deferred sorting (sort once before render, not after every operation)
   setDeferredSorting(enabled) {
     this.deferSorting = enabled;
     // If disabling and sort is pending, do it now
     if (!enabled && this.sortDeferred) {
-      this.wasm.exports.sort();
+      this._sortLights();
       this.sortDeferred = false;
     }
   }
 
   // Manually trigger sort (useful when deferred sorting is enabled)
   sortNow() {
-    this.wasm.exports.sort();
+    this._sortLights();
     this.sortDeferred = false;
   }
 
@@ -353,7 +500,7 @@ export class ClusterLightingSystem {
   _updateClusterResolution() {
     if (!this._dynamicClusters) return;
 
-    const totalLights = this.pointLightCount + this.spotLightCount + this.rectLightCount;
+    const totalLights = this.pointLightCount + this.staticPointLightCount + this.spotLightCount + this.rectLightCount;
     const resolution = calculateOptimalClusterResolution(totalLights);
 
     if (this.sliceParams.value.x !== resolution.x ||
@@ -365,7 +512,7 @@ export class ClusterLightingSystem {
       // At 32K lights: 1024 batch = ~31 rows (vs 63 with 512) = 50% fewer iterations
       const batchSize = totalLights > 8000 ? 1024 : 512;
       this.sliceParams.value.set(resolution.x, resolution.y, resolution.z,
-                                  Math.ceil(Math.max(1, totalLights) / batchSize));
+                                  Math.ceil(Math.max(1, this.lightSlotCount) / batchSize));
       this._computeClusterParams();
 
       // Clear render targets to force recreation
@@ -385,10 +532,10 @@ export class ClusterLightingSystem {
 
     // Select best shader variant
     const lights = {
-      pointCount: this.pointLightCount,
+      pointCount: this.pointLightCount + this.staticPointLightCount,
       spotCount: this.spotLightCount,
       rectCount: this.rectLightCount,
-      totalCount: this.pointLightCount + this.spotLightCount + this.rectLightCount,
+      totalCount: this.pointLightCount + this.staticPointLightCount + this.spotLightCount + this.rectLightCount,
       ...features
     };
     
@@ -448,17 +595,29 @@ export class ClusterLightingSystem {
     v.w = this.sliceParams.value.z * Math.log(this._near) / fnl;
   }
 
-  patchMaterial(material) {
+  // options.lightLayers: bitmask of light layers (0-7) this material receives
+  patchMaterial(material, options = {}) {
     // Track material for updates
     this.materialsToUpdate.add(material);
+
+    // Per-material uniform (everything else is shared between materials)
+    const lightLayerMask = { value: (options.lightLayers !== undefined ? options.lightLayers : 0xFF) >>> 0 };
+    material.userData.lightLayerMask = lightLayerMask;
     
     material.onBeforeCompile = (s) => {
       this._patchShader(s);
+      s.uniforms.lightLayerMask = lightLayerMask;
       material.uniforms = s.uniforms;
     }
     material.needsUpdate = true;
   }
 
+  // Change which light layers a patched material receives (no recompile)
+  setMaterialLightLayers(material, layers) {
+    const uniform = material.userData.lightLayerMask;
+    if (uniform) uniform.value = layers >>> 0;
+  }
+
   _patchShader(s) {
     const u = s.uniforms;
     u.clusterParams = this.clusterParams;
@@ -466,13 +625,23 @@ export class ClusterLightingSystem {
     u.pointLightTexture = this.pointLightTexture;
     u.spotLightTexture = this.spotLightTexture;
     u.rectLightTexture = this.rectLightTexture;
+    u.lightTexture = this.lightTexture;
+    u.lightRowBases = this.lightRowBases;
     u.lightCounts = this.lightCounts;
+    u.lightBatchBases = this.lightBatchBases;
     u.masterTexture = this.masterTexture;
     u.superMasterTexture = this.superMasterTexture;
     u.listTexture = this.listTexture;
-    u.pointLightTextureWidth = this.pointLightTextureWidth;
-    u.spotLightTextureWidth = this.spotLightTextureWidth;
-    u.rectLightTextureWidth = this.rectLightTextureWidth;
+    u.pointLightRowShift = this.pointLightRowShift;
+    u.spotLightRowShift = this.spotLightRowShift;
+    u.rectLightRowShift = this.rectLightRowShift;
+
+    s.defines = s.defines || {};
+    if (this.unifiedLights) {
+      s.defines.CLUSTER_UNIFIED_LIGHTS = '';
+    } else {
+      delete s.defines.CLUSTER_UNIFIED_LIGHTS;
+    }
 
     // Enable super-master early-out if texture is present
     if (this.superMasterTexture.value) {
@@ -596,7 +765,7 @@ export class ClusterLightingSystem {
       : this.wasm.exports.add(p.x, p.y, p.z, radius, c.r, c.g, c.b, 1.0, 0, 0, intensity);
     
     if (typeIndex >= 0) {
-      this.pointLights.push({
+      if (this.mirrorLights) this.pointLights.push({
         position: p,
         color: c,
         intensity,
@@ -607,7 +776,7 @@ export class ClusterLightingSystem {
       });
       
       const globalIndex = this.globalLightIndex++;
-      this.lightTypeMap.set(globalIndex, { type: 'point', typeIndex });
+      this._registerLight(globalIndex, 'point', typeIndex);
       
       this.hasPointLights = true;
       
@@ -627,6 +796,9 @@ export class ClusterLightingSystem {
     if (this.performanceMode && 
         light.type === 'point' && 
         !light.animation &&
+        !light.groups &&
+        light.layers === undefined &&
+        !light.castsShadow &&
         this.pointLightCount > 100) {
       return this.addFastLight(light);
     }
@@ -639,6 +811,10 @@ export class ClusterLightingSystem {
     const type = light.type || 'point';
     const visible = light.visible !== undefined ? light.visible : true;
     const animation = light.animation || null;
+    const groups = light.groups || 0;
+    const layers = light.layers !== undefined ? light.layers : 1;
+    const castsShadow = !!light.castsShadow;
+    const shadowIntensity = light.shadowIntensity !== undefined ? light.shadowIntensity : 0.3;
     
     let typeIndex = -1;
     const globalIndex = this.globalLightIndex++;
@@ -669,13 +845,17 @@ export class ClusterLightingSystem {
       }
       
       if (typeIndex >= 0) {
-        this.pointLights.push({
+        if (this.mirrorLights) this.pointLights.push({
           position: p,
           color: c,
           intensity,
           radius,
           decay,
           visible,
+          groups,
+          layers,
+          castsShadow,
+          shadowIntensity,
           animation
         });
 
@@ -717,7 +897,7 @@ export class ClusterLightingSystem {
       }
 
       if (typeIndex >= 0) {
-        this.spotLights.push({
+        if (this.mirrorLights) this.spotLights.push({
           position: p,
           color: c,
           intensity,
@@ -727,6 +907,10 @@ export class ClusterLightingSystem {
           angle,
           penumbra,
           visible,
+          groups,
+          layers,
+          castsShadow,
+          shadowIntensity,
           animation
         });
         
@@ -764,7 +948,7 @@ export class ClusterLightingSystem {
       }
 
       if (typeIndex >= 0) {
-        this.rectLights.push({
+        if (this.mirrorLights) this.rectLights.push({
           position: p,
           color: c,
           intensity,
@@ -774,6 +958,10 @@ export class ClusterLightingSystem {
           height,
           normal,
           visible,
+          groups,
+          layers,
+          castsShadow,
+          shadowIntensity,
           animation
         });
         
@@ -784,36 +972,171 @@ export class ClusterLightingSystem {
     }
     
     if (typeIndex >= 0) {
-      this.lightTypeMap.set(globalIndex, { type, typeIndex });
-      this.updateLightCounts();
-      this.updateLightTextures();
-      this.updateProxyGeometry();
-      this._computeClusterParams();
+      this._registerLight(globalIndex, type, typeIndex);
+      // Must run before sort() moves the new light
+      if (groups) this._setGroupMask(type, typeIndex, groups);
+      if (layers !== 1) this._setLightLayers(type, typeIndex, layers);
+      if (castsShadow) this._setLightShadow(type, typeIndex, castsShadow, shadowIntensity);
+      if (!this._patching) this._lightsChanged();
+    }
 
-      // Mark clusters as dirty
-      this.clusterDirtyFlags.lightCountChanged = true;
-      this.clusterDirtyFlags.lightPositionsChanged = true;
+    return globalIndex;
+  }
 
-      // Update feature flags and cluster resolution
-      this._updateFeatureFlags();
-      this._updateClusterResolution();
+  // ──────────────────────────────────────────────────────────────
+  //                   BATCHING
+  // ──────────────────────────────────────────────────────────────
+  // Inside a batch, adds, removes and updates only change the core; the
+  // derived work (counts, textures, proxy, cluster params, feature flags,
+  // cluster resolution) runs once at commitBatch(). Batches nest. With
+  // autoBatch on, it runs at the start of the next update() instead.
 
-      // Defer sorting until render (performance optimization)
-      if (this.deferSorting) {
-        this.sortDeferred = true;
-      } else {
-        this.wasm.exports.sort();
-      }
+  beginBatch() {
+    this._batchDepth++;
+  }
+
+  commitBatch() {
+    if (this._batchDepth === 0) return;
+    if (--this._batchDepth === 0 && !this.autoBatch) this._flushRefresh();
+  }
+
+  // Run fn inside a batch
+  batch(fn) {
+    this.beginBatch();
+    try {
+      return fn();
+    } finally {
+      this.commitBatch();
+    }
+  }
+
+  setAutoBatch(enabled) {
+    this.autoBatch = enabled;
+    if (!enabled && this._batchDepth === 0) this._flushRefresh();
+  }
+
+  // Record deferred work; false when it should run now
+  _deferRefresh(bits) {
+    if (this._batchDepth === 0 && !this.autoBatch) return false;
+    this._pendingRefresh |= bits;
+    return true;
+  }
+
+  _flushRefresh() {
+    const pending = this._pendingRefresh;
+    this._pendingRefresh = 0;
+    if (pending & Refresh.LIGHTS) {
+      this._refreshLights();
+      return;
     }
+    if (pending & Refresh.TEXTURES) this.updateLightTextures();
+    if (pending & Refresh.FEATURES) this._updateFeatureFlags();
+  }
 
-    return globalIndex;
+  _lightTexturesChanged() {
+    if (!this._deferRefresh(Refresh.TEXTURES)) this.updateLightTextures();
+  }
+
+  _featuresChanged() {
+    if (!this._deferRefresh(Refresh.FEATURES)) this._updateFeatureFlags();
+  }
+
+  // Refresh counts, textures and cluster state after lights were added or removed
+  _lightsChanged() {
+    if (!this._deferRefresh(Refresh.LIGHTS)) this._refreshLights();
+  }
+
+  _refreshLights() {
+    this.updateLightCounts();
+    this.updateLightTextures();
+    this.updateProxyGeometry();
+    this._computeClusterParams();
+
+    // Mark clusters as dirty
+    this.clusterDirtyFlags.lightCountChanged = true;
+    this.clusterDirtyFlags.lightPositionsChanged = true;
+
+    // Update feature flags and cluster resolution
+    this._updateFeatureFlags();
+    this._updateClusterResolution();
+
+    // Defer sorting until render (performance optimization)
+    if (this.deferSorting) {
+      this.sortDeferred = true;
+    } else {
+      this._sortLights();
+    }
+  }
+
+  _registerLight(globalIndex, type, typeIndex) {
+    const mapping = { type, typeIndex };
+    this.lightTypeMap.set(globalIndex, mapping);
+    this._lightSlots[type][typeIndex] = mapping;
+  }
+
+  // Sort in the core, then follow any lights it moved
+  _sortLights() {
+    this.wasm.exports.sort();
+    this._syncLightOrder();
+  }
+
+  // Re-point typeIndex mappings (and mirrors) after the core reordered lights.
+  // The core reports the previous index of every surviving light.
+  _syncLightOrder() {
+    const exports = this.wasm.exports;
+    if (!exports.syncLightOrder) return;
+
+    const changed = exports.getLightOrderChanges();
+    if (!changed) return;
+    this.lightOrderVersion++;
+
+    ['point', 'spot', 'rect'].forEach((type, t) => {
+      if (!(changed & (1 << t))) return;
+
+      const count = type === 'spot' ? exports.getSpotLightCount() :
+                    type === 'rect' ? exports.getRectLightCount() :
+                    exports.getPointLightCount();
+      const slots = this._lightSlots[type];
+      const lights = this._mirrorArray(type);
+
+      if (!exports.syncLightOrder(t)) {
+        // Only trailing lights were removed
+        slots.length = count;
+        if (this.mirrorLights) lights.length = count;
+        return;
+      }
+
+      const order = new Uint32Array(exports.memory.buffer, exports.getLightOrder(), count);
+      const nextSlots = new Array(count);
+      for (let i = 0; i < count; i++) {
+        const mapping = slots[order[i]];
+        if (mapping) mapping.typeIndex = i;
+        nextSlots[i] = mapping;
+      }
+      this._lightSlots[type] = nextSlots;
+
+      if (this.mirrorLights) {
+        const nextLights = new Array(count);
+        for (let i = 0; i < count; i++) nextLights[i] = lights[order[i]];
+        if (type === 'spot') this.spotLights = nextLights;
+        else if (type === 'rect') this.rectLights = nextLights;
+        else this.pointLights = nextLights;
+      }
+    });
   }
 
   removeLight(globalIndex) {
     const mapping = this.lightTypeMap.get(globalIndex);
     if (!mapping) return;
 
+    if (this.wasm.exports.removeLights) {
+      this._removeLights([globalIndex]);
+      this._lightsChanged();
+      return;
+    }
+
     const { type, typeIndex } = mapping;
+    this._lightSlots[type].splice(typeIndex, 1);
 
     if (type === 'point') {
       this.wasm.exports.removePointLight(typeIndex);
@@ -838,25 +1161,31 @@ export class ClusterLightingSystem {
       }
     }
     
-    this.updateLightCounts();
-    this.updateLightTextures();
-    this.updateProxyGeometry();
-    this._computeClusterParams();
-
-    // Mark clusters as dirty
-    this.clusterDirtyFlags.lightCountChanged = true;
-    this.clusterDirtyFlags.lightPositionsChanged = true;
+    if (!this._patching) this._lightsChanged();
+  }
 
-    // Update feature flags and cluster resolution
-    this._updateFeatureFlags();
-    this._updateClusterResolution();
+  // Batch removal through the core: one compaction pass per light type
+  // instead of one memmove and one mapping scan per light
+  _removeLights(globalIndices) {
+    const exports = this.wasm.exports;
+    const byType = { point: [], spot: [], rect: [] };
 
-    // Defer sorting until render (performance optimization)
-    if (this.deferSorting) {
-      this.sortDeferred = true;
-    } else {
-      this.wasm.exports.sort();
+    for (const globalIndex of globalIndices) {
+      const mapping = this.lightTypeMap.get(globalIndex);
+      if (!mapping) continue;
+      byType[mapping.type].push(mapping.typeIndex);
+      this.lightTypeMap.delete(globalIndex);
     }
+
+    ['point', 'spot', 'rect'].forEach((type, t) => {
+      const list = byType[type];
+      if (list.length === 0) return;
+      new Uint32Array(exports.memory.buffer, exports.getPatchIndices(), list.length).set(list);
+      exports.removeLights(t, list.length);
+    });
+
+    this._syncLightOrder();
+    this.hasAnimatedLights = exports.getHasAnimatedLights() > 0;
   }
 
   updateLightPosition(globalIndex, position) {
@@ -867,13 +1196,13 @@ export class ClusterLightingSystem {
 
     if (type === 'point') {
       this.wasm.exports.updatePointLightPosition(typeIndex, position.x, position.y, position.z);
-      this.pointLights[typeIndex].position = position;
+      if (this.mirrorLights) this.pointLights[typeIndex].position = position;
     } else if (type === 'spot') {
       this.wasm.exports.updateSpotLightPosition(typeIndex, position.x, position.y, position.z);
-      this.spotLights[typeIndex].position = position;
+      if (this.mirrorLights) this.spotLights[typeIndex].position = position;
     } else if (type === 'rect') {
       this.wasm.exports.updateRectLightPosition(typeIndex, position.x, position.y, position.z);
-      this.rectLights[typeIndex].position = position;
+      if (this.mirrorLights) this.rectLights[typeIndex].position = position;
     }
 
     // Mark position change for cluster update
@@ -881,7 +1210,7 @@ export class ClusterLightingSystem {
 
     // Defer sorting until render (performance optimization)
     // Skip sorting entirely if we have very few lights (sorting is pointless and causes index corruption)
-    const totalLights = this.pointLightCount + this.spotLightCount + this.rectLightCount;
+    const totalLights = this.pointLightCount + this.staticPointLightCount + this.spotLightCount + this.rectLightCount;
     if (totalLights <= 2) {
       // Don't sort - with 2 or fewer lights, Morton ordering provides no benefit
       // and causes light index corruption issues
@@ -889,7 +1218,7 @@ export class ClusterLightingSystem {
     } else if (this.deferSorting) {
       this.sortDeferred = true;
     } else {
-      this.wasm.exports.sort();
+      this._sortLights();
     }
   }
 
@@ -901,13 +1230,13 @@ export class ClusterLightingSystem {
     
     if (type === 'point') {
       this.wasm.exports.updatePointLightColor(typeIndex, color.r, color.g, color.b);
-      this.pointLights[typeIndex].color = color;
+      if (this.mirrorLights) this.pointLights[typeIndex].color = color;
     } else if (type === 'spot') {
       this.wasm.exports.updateSpotLightColor(typeIndex, color.r, color.g, color.b);
-      this.spotLights[typeIndex].color = color;
+      if (this.mirrorLights) this.spotLights[typeIndex].color = color;
     } else if (type === 'rect') {
       this.wasm.exports.updateRectLightColor(typeIndex, color.r, color.g, color.b);
-      this.rectLights[typeIndex].color = color;
+      if (this.mirrorLights) this.rectLights[typeIndex].color = color;
     }
   }
 
@@ -919,13 +1248,13 @@ export class ClusterLightingSystem {
     
     if (type === 'point') {
       this.wasm.exports.updatePointLightIntensity(typeIndex, intensity);
-      this.pointLights[typeIndex].intensity = intensity;
+      if (this.mirrorLights) this.pointLights[typeIndex].intensity = intensity;
     } else if (type === 'spot') {
       this.wasm.exports.updateSpotLightIntensity(typeIndex, intensity);
-      this.spotLights[typeIndex].intensity = intensity;
+      if (this.mirrorLights) this.spotLights[typeIndex].intensity = intensity;
     } else if (type === 'rect') {
       this.wasm.exports.updateRectLightIntensity(typeIndex, intensity);
-      this.rectLights[typeIndex].intensity = intensity;
+      if (this.mirrorLights) this.rectLights[typeIndex].intensity = intensity;
     }
   }
 
@@ -937,13 +1266,13 @@ export class ClusterLightingSystem {
     
     if (type === 'point') {
       this.wasm.exports.updatePointLightRadius(typeIndex, radius);
-      this.pointLights[typeIndex].radius = radius;
+      if (this.mirrorLights) this.pointLights[typeIndex].radius = radius;
     } else if (type === 'spot') {
       this.wasm.exports.updateSpotLightRadius(typeIndex, radius);
-      this.spotLights[typeIndex].radius = radius;
+      if (this.mirrorLights) this.spotLights[typeIndex].radius = radius;
     } else if (type === 'rect') {
       this.wasm.exports.updateRectLightRadius(typeIndex, radius);
-      this.rectLights[typeIndex].radius = radius;
+      if (this.mirrorLights) this.rectLights[typeIndex].radius = radius;
     }
   }
 
@@ -955,13 +1284,13 @@ export class ClusterLightingSystem {
     
     if (type === 'point') {
       this.wasm.exports.updatePointLightDecay(typeIndex, decay);
-      this.pointLights[typeIndex].decay = decay;
+      if (this.mirrorLights) this.pointLights[typeIndex].decay = decay;
     } else if (type === 'spot') {
       this.wasm.exports.updateSpotLightDecay(typeIndex, decay);
-      this.spotLights[typeIndex].decay = decay;
+      if (this.mirrorLights) this.spotLights[typeIndex].decay = decay;
     } else if (type === 'rect') {
       this.wasm.exports.updateRectLightDecay(typeIndex, decay);
-      this.rectLights[typeIndex].decay = decay;
+      if (this.mirrorLights) this.rectLights[typeIndex].decay = decay;
     }
   }
 
@@ -973,13 +1302,93 @@ export class ClusterLightingSystem {
     
     if (type === 'point') {
       this.wasm.exports.updatePointLightVisibility(typeIndex, visible ? 1 : 0);
-      this.pointLights[typeIndex].visible = visible;
+      if (this.mirrorLights) this.pointLights[typeIndex].visible = visible;
     } else if (type === 'spot') {
       this.wasm.exports.updateSpotLightVisibility(typeIndex, visible ? 1 : 0);
-      this.spotLights[typeIndex].visible = visible;
+      if (this.mirrorLights) this.spotLights[typeIndex].visible = visible;
     } else if (type === 'rect') {
       this.wasm.exports.updateRectLightVisibility(typeIndex, visible ? 1 : 0);
-      this.rectLights[typeIndex].visible = visible;
+      if (this.mirrorLights) this.rectLights[typeIndex].visible = visible;
+    }
+  }
+
+  // Replace a light's group membership (bit g = member of group g)
+  updateLightGroups(globalIndex, groups) {
+    const mapping = this.lightTypeMap.get(globalIndex);
+    if (!mapping) return;
+
+    const { type, typeIndex } = mapping;
+    this._setGroupMask(type, typeIndex, groups);
+
+    const lights = type === 'spot' ? this.spotLights : type === 'rect' ? this.rectLights : this.pointLights;
+    if (lights[typeIndex]) lights[typeIndex].groups = groups;
+  }
+
+  _setGroupMask(type, typeIndex, groups) {
+    const exports = this.wasm.exports;
+    if (!exports.updatePointLightGroupMask) return;
+
+    const mask = groups >>> 0;
+    if (type === 'point') {
+      exports.updatePointLightGroupMask(typeIndex, mask);
+    } else if (type === 'spot') {
+      exports.updateSpotLightGroupMask(typeIndex, mask);
+    } else if (type === 'rect') {
+      exports.updateRectLightGroupMask(typeIndex, mask);
+    }
+  }
+
+  // Replace the light layers a light is on (bit n = layer n, 8 layers)
+  updateLightLayers(globalIndex, layers) {
+    const mapping = this.lightTypeMap.get(globalIndex);
+    if (!mapping) return;
+
+    const { type, typeIndex } = mapping;
+    this._setLightLayers(type, typeIndex, layers);
+
+    const lights = type === 'spot' ? this.spotLights : type === 'rect' ? this.rectLights : this.pointLights;
+    if (lights[typeIndex]) lights[typeIndex].layers = layers;
+  }
+
+  _setLightLayers(type, typeIndex, layers) {
+    const exports = this.wasm.exports;
+    if (!exports.updatePointLightLayers) return;
+
+    const mask = layers & 0xFF;
+    if (type === 'point') {
+      exports.updatePointLightLayers(typeIndex, mask);
+    } else if (type === 'spot') {
+      exports.updateSpotLightLayers(typeIndex, mask);
+    } else if (type === 'rect') {
+      exports.updateRectLightLayers(typeIndex, mask);
+    }
+  }
+
+  updateLightShadow(globalIndex, castsShadow, shadowIntensity = 0.3) {
+    const mapping = this.lightTypeMap.get(globalIndex);
+    if (!mapping) return;
+
+    const { type, typeIndex } = mapping;
+    this._setLightShadow(type, typeIndex, castsShadow, shadowIntensity);
+
+    const lights = type === 'spot' ? this.spotLights : type === 'rect' ? this.rectLights : this.pointLights;
+    if (lights[typeIndex]) {
+      lights[typeIndex].castsShadow = !!castsShadow;
+      lights[typeIndex].shadowIntensity = shadowIntensity;
+    }
+  }
+
+  _setLightShadow(type, typeIndex, castsShadow, shadowIntensity) {
+    const exports = this.wasm.exports;
+    if (!exports.updatePointLightShadow) return;
+
+    const casts = castsShadow ? 1 : 0;
+    if (type === 'point') {
+      exports.updatePointLightShadow(typeIndex, casts, shadowIntensity);
+    } else if (type === 'spot') {
+      exports.updateSpotLightShadow(typeIndex, casts, shadowIntensity);
+    } else if (type === 'rect') {
+      exports.updateRectLightShadow(typeIndex, casts, shadowIntensity);
     }
   }
 
@@ -1001,7 +1410,7 @@ export class ClusterLightingSystem {
         animParams.flickerSpeed, animParams.flickerIntensity, animParams.flickerSeed,
         animParams.pulseSpeed, animParams.pulseAmount, animParams.pulseTarget
       );
-      this.pointLights[typeIndex].animation = animation;
+      if (this.mirrorLights) this.pointLights[typeIndex].animation = animation;
     } else if (type === 'spot') {
       this.wasm.exports.updateSpotLightAnimation(
         typeIndex, animParams.flags,
@@ -1012,7 +1421,7 @@ export class ClusterLightingSystem {
         animParams.flickerSpeed, animParams.flickerIntensity, animParams.flickerSeed,
         animParams.pulseSpeed, animParams.pulseAmount, animParams.pulseTarget
       );
-      this.spotLights[typeIndex].animation = animation;
+      if (this.mirrorLights) this.spotLights[typeIndex].animation = animation;
     } else if (type === 'rect') {
       this.wasm.exports.updateRectLightAnimation(
         typeIndex, animParams.flags,
@@ -1023,11 +1432,11 @@ export class ClusterLightingSystem {
         animParams.flickerSpeed, animParams.flickerIntensity, animParams.flickerSeed,
         animParams.pulseSpeed, animParams.pulseAmount, animParams.pulseTarget
       );
-      this.rectLights[typeIndex].animation = animation;
+      if (this.mirrorLights) this.rectLights[typeIndex].animation = animation;
     }
     
     this.hasAnimatedLights = this.wasm.exports.getHasAnimatedLights() > 0;
-    this._updateFeatureFlags();
+    this._featuresChanged();
   }
 
   updateLightAnimationProperty(globalIndex, animationType, property, value) {
@@ -1035,9 +1444,7 @@ export class ClusterLightingSystem {
     if (!mapping) return;
     
     const { type, typeIndex } = mapping;
-    const light = type === 'point' ? this.pointLights[typeIndex] :
-                  type === 'spot' ? this.spotLights[typeIndex] :
-                  type === 'rect' ? this.rectLights[typeIndex] : null;
+    const light = this._lightRecord(type, typeIndex);
     
     if (!light || !light.animation) return;
     
@@ -1100,7 +1507,7 @@ export class ClusterLightingSystem {
     if (!mapping || mapping.type !== 'spot') return;
     
     this.wasm.exports.updateSpotLightDirection(mapping.typeIndex, direction.x, direction.y, direction.z);
-    this.spotLights[mapping.typeIndex].direction = direction;
+    if (this.mirrorLights) this.spotLights[mapping.typeIndex].direction = direction;
   }
 
   updateSpotAngle(globalIndex, angle, penumbra) {
@@ -1111,8 +1518,10 @@ export class ClusterLightingSystem {
     const validPenumbra = Math.min(penumbra, angle * 0.99);
     
     this.wasm.exports.updateSpotLightAngle(mapping.typeIndex, angle, validPenumbra);
-    this.spotLights[mapping.typeIndex].angle = angle;
-    this.spotLights[mapping.typeIndex].penumbra = validPenumbra;
+    if (this.mirrorLights) {
+      this.spotLights[mapping.typeIndex].angle = angle;
+      this.spotLights[mapping.typeIndex].penumbra = validPenumbra;
+    }
   }
 
   updateRectSize(globalIndex, width, height) {
@@ -1120,13 +1529,15 @@ export class ClusterLightingSystem {
     if (!mapping || mapping.type !== 'rect') return;
     
     this.wasm.exports.updateRectLightSize(mapping.typeIndex, width, height);
-    this.rectLights[mapping.typeIndex].width = width;
-    this.rectLights[mapping.typeIndex].height = height;
+    if (this.mirrorLights) {
+      this.rectLights[mapping.typeIndex].width = width;
+      this.rectLights[mapping.typeIndex].height = height;
+    }
     
     // Recalculate radius based on new dimensions
     const newRadius = Math.max(width, height) * 3;
     this.wasm.exports.updateRectLightRadius(mapping.typeIndex, newRadius);
-    this.rectLights[mapping.typeIndex].radius = newRadius;
+    if (this.mirrorLights) this.rectLights[mapping.typeIndex].radius = newRadius;
   }
 
   updateRectNormal(globalIndex, normal) {
@@ -1134,7 +1545,7 @@ export class ClusterLightingSystem {
     if (!mapping || mapping.type !== 'rect') return;
 
     this.wasm.exports.updateRectLightNormal(mapping.typeIndex, normal.x, normal.y, normal.z);
-    this.rectLights[mapping.typeIndex].normal = normal;
+    if (this.mirrorLights) this.rectLights[mapping.typeIndex].normal = normal;
   }
 
   // Bulk update multiple lights by their indices without clearing
@@ -1142,57 +1553,132 @@ export class ClusterLightingSystem {
   bulkUpdateLights(updates) {
     if (!updates || updates.length === 0) return;
 
-    updates.forEach(update => {
-      const { index, properties } = update;
+    const rectNormals = [];
+    updates.forEach(({ index, properties }) => this._applyLightProperties(index, properties, rectNormals));
+    this._updateRectNormals(rectNormals);
 
-      if (properties.position) {
-        this.updateLightPosition(index, properties.position);
-      }
-      if (properties.color) {
-        this.updateLightColor(index, properties.color);
-      }
-      if (properties.intensity !== undefined) {
-        this.updateLightIntensity(index, properties.intensity);
-      }
-      if (properties.radius !== undefined) {
-        this.updateLightRadius(index, properties.radius);
-      }
-      if (properties.decay !== undefined) {
-        this.updateLightDecay(index, properties.decay);
-      }
-      if (properties.visible !== undefined) {
-        this.updateLightVisibility(index, properties.visible);
-      }
-      if (properties.animation !== undefined) {
-        this.updateLightAnimation(index, properties.animation);
-      }
+    // Single texture update at the end
+    this._lightTexturesChanged();
+  }
 
-      // Type-specific updates
-      const mapping = this.lightTypeMap.get(index);
-      if (mapping) {
-        if (mapping.type === 'spot') {
-          if (properties.direction) {
-            this.updateSpotDirection(index, properties.direction);
-          }
-          if (properties.angle !== undefined) {
-            const penumbra = properties.penumbra !== undefined ? properties.penumbra : this.spotLights[mapping.typeIndex].penumbra;
-            this.updateSpotAngle(index, properties.angle, penumbra);
-          }
-        } else if (mapping.type === 'rect') {
-          if (properties.width !== undefined || properties.height !== undefined) {
-            const width = properties.width !== undefined ? properties.width : this.rectLights[mapping.typeIndex].width;
-            const height = properties.height !== undefined ? properties.height : this.rectLights[mapping.typeIndex].height;
-            this.updateRectSize(index, width, height);
-          }
-          if (properties.normal) {
+  // rectNormals, when given, collects rect normal changes for one batched
+  // _updateRectNormals call instead of applying them one by one
+  _applyLightProperties(index, properties, rectNormals = null) {
+    if (properties.position) {
+      this.updateLightPosition(index, properties.position);
+    }
+    if (properties.color) {
+      this.updateLightColor(index, properties.color);
+    }
+    if (properties.intensity !== undefined) {
+      this.updateLightIntensity(index, properties.intensity);
+    }
+    if (properties.radius !== undefined) {
+      this.updateLightRadius(index, properties.radius);
+    }
+    if (properties.decay !== undefined) {
+      this.updateLightDecay(index, properties.decay);
+    }
+    if (properties.visible !== undefined) {
+      this.updateLightVisibility(index, properties.visible);
+    }
+    if (properties.animation !== undefined) {
+      this.updateLightAnimation(index, properties.animation);
+    }
+
+    // Type-specific updates
+    const mapping = this.lightTypeMap.get(index);
+    if (mapping) {
+      if (mapping.type === 'spot') {
+        if (properties.direction) {
+          this.updateSpotDirection(index, properties.direction);
+        }
+        if (properties.angle !== undefined) {
+          const penumbra = properties.penumbra !== undefined ? properties.penumbra : this._lightRecord('spot', mapping.typeIndex).penumbra;
+          this.updateSpotAngle(index, properties.angle, penumbra);
+        }
+      } else if (mapping.type === 'rect') {
+        if (properties.width !== undefined || properties.height !== undefined) {
+          const current = this._lightRecord('rect', mapping.typeIndex);
+          const width = properties.width !== undefined ? properties.width : current.width;
+          const height = properties.height !== undefined ? properties.height : current.height;
+          this.updateRectSize(index, width, height);
+        }
+        if (properties.normal) {
+          if (rectNormals && this.wasm.exports.updateRectLightNormals) {
+            rectNormals.push({ typeIndex: mapping.typeIndex, normal: properties.normal });
+          } else {
             this.updateRectNormal(index, properties.normal);
           }
         }
       }
+    }
+  }
+
+  // Set many rect normals in one core call, so tangent frames are built in
+  // a single batch
+  _updateRectNormals(rectNormals) {
+    if (rectNormals.length === 0) return;
+    const exports = this.wasm.exports;
+
+    const indices = new Uint32Array(exports.memory.buffer, exports.getPatchIndices(), rectNormals.length);
+    const vectors = new Float32Array(exports.memory.buffer, exports.getPatchVectors(), rectNormals.length * 3);
+    rectNormals.forEach(({ typeIndex, normal }, k) => {
+      indices[k] = typeIndex;
+      vectors[k * 3] = normal.x;
+      vectors[k * 3 + 1] = normal.y;
+      vectors[k * 3 + 2] = normal.z;
     });
+    exports.updateRectLightNormals(rectNormals.length);
 
-    // Single texture update at the end
-    this.updateLightTextures();
+    if (this.mirrorLights) {
+      rectNormals.forEach(({ typeIndex, normal }) => { this.rectLights[typeIndex].normal = normal; });
+    }
+  }
+
+  // Apply a scene diff in one batch, keyed by the stable global index addLight
+  // returns: { remove: [id], update: [{ id, properties }], add: [config] }.
+  // Removals compact once per light type in the core, new lights are merged
+  // into the sorted order incrementally, and counts/textures/cluster state
+  // are refreshed once. Returns the ids assigned to `add`, in order.
+  patchLights(diff) {
+    const { remove = [], update = [], add = [] } = diff || {};
+    const exports = this.wasm.exports;
+
+    if (remove.length > 0) {
+      if (exports.removeLights) {
+        this._removeLights(remove);
+      } else {
+        this._patching = true;
+        try {
+          remove.forEach(id => this.removeLight(id));
+        } finally {
+          this._patching = false;
+        }
+      }
+    }
+
+    const rectNormals = [];
+    update.forEach(({ id, properties }) => this._applyLightProperties(id, properties, rectNormals));
+    this._updateRectNormals(rectNormals);
+
+    const ids = [];
+    if (add.length > 0) {
+      this._patching = true;
+      try {
+        add.forEach(light => ids.push(this.addLight(light)));
+      } finally {
+        this._patching = false;
+      }
+    }
+
+    if (remove.length > 0 || add.length > 0) {
+      this._lightsChanged();
+    } else if (update.length > 0) {
+      this._lightTexturesChanged();
+    }
+
+    return ids;
   }
 
   clearLights() {
@@ -1207,7 +1693,9 @@ export class ClusterLightingSystem {
     this.spotLights = [];
     this.rectLights = [];
     this.lightTypeMap.clear();
+    this._lightSlots = { point: [], spot: [], rect: [] };
     this.globalLightIndex = 0;
+    this.lightOrderVersion++;
     this.hasAnimatedLights = false;
 
     // Dispose old textures properly to prevent memory leaks
@@ -1232,6 +1720,7 @@ export class ClusterLightingSystem {
 
     // Reset dirty flags
     this.sortDeferred = false;
+    this._pendingRefresh = 0;
     this.clusterDirtyFlags.lightCountChanged = false;
     this.clusterDirtyFlags.lightPositionsChanged = false;
     this._loggedUpdate = false; // Reset debug flag
@@ -1256,25 +1745,39 @@ export class ClusterLightingSystem {
     }
   }
 
+  // Point texture records: dynamic lights followed by static lights
+  _pointRecordCount() {
+    const exports = this.wasm.exports;
+    return exports.getPointRecordCount ? exports.getPointRecordCount() : exports.getPointLightCount();
+  }
+
   updateLightCounts() {
-    const pointCount = this.wasm.exports.getPointLightCount();
+    const pointCount = this._pointRecordCount();
     const spotCount = this.wasm.exports.getSpotLightCount();
     const rectCount = this.wasm.exports.getRectLightCount();
     
     this.lightCounts.value.set(pointCount, spotCount, rectCount);
-    
+
+    // Batches are counted in light slots: types are padded to 32-light
+    // boundaries so the shaders resolve a light's type once per batch
+    const spotBatch = (pointCount + 31) >> 5;
+    this.lightBatchBases.value.set(spotBatch, spotBatch + ((spotCount + 31) >> 5));
+    const slotCount = this.lightSlotCount = lightSlotCount(pointCount, spotCount, rectCount);
+
     const totalCount = pointCount + spotCount + rectCount;
-    this.batchCount.value = Math.ceil(Math.max(1, totalCount) / 32);
+    this.batchCount.value = Math.ceil(Math.max(1, slotCount) / 32);
     
     // Adaptive batch size: use 1024 for high counts to reduce master rows
     // At 32K lights: 1024 batch = ~31 rows (vs 63 with 512) = 50% reduction in fragment shader loops
     const batchSize = totalCount > 8000 ? 1024 : 512;
     const oldW = this.sliceParams.value.w;
-    const newW = Math.ceil(Math.max(1, totalCount) / batchSize);
+    const newW = Math.ceil(Math.max(1, slotCount) / batchSize);
     this.sliceParams.value.w = newW;
     
-    // Store counts for easy access
-    this.pointLightCount = pointCount;
+    // Store counts for easy access (pointLightCount excludes static lights)
+    this.staticPointLightCount = this.wasm.exports.getStaticPointLightCount ?
+      this.wasm.exports.getStaticPointLightCount() : 0;
+    this.pointLightCount = pointCount - this.staticPointLightCount;
     this.spotLightCount = spotCount;
     this.rectLightCount = rectCount;
     
@@ -1285,300 +1788,343 @@ export class ClusterLightingSystem {
   }
 
   updateLightTextures() {
-    const pointCount = this.wasm.exports.getPointLightCount();
-    const spotCount = this.wasm.exports.getSpotLightCount();
-    const rectCount = this.wasm.exports.getRectLightCount();
-
-    // Calculate 2D texture dimensions
-    const TEXTURE_WIDTH = this.lightTextureWidth;
-    const texelsNeeded = pointCount * 2;
-    const textureHeight = Math.ceil(texelsNeeded / TEXTURE_WIDTH);
-
-    // WASM allocates exactly pointCount * 2 texels (no padding)
-    const actualFloats = pointCount * 2 * 4; // Actual WASM allocation
-
-    // Only recreate textures if size changed significantly (avoid thrashing)
-    const recreatePoint = !this.pointLightTexture.value ||
-      (pointCount > 0 && (
-        this.pointLightTexture.value.image.width !== TEXTURE_WIDTH ||
-        this.pointLightTexture.value.image.height !== textureHeight
-      ));
-    const recreateSpot = !this.spotLightTexture.value ||
-      (spotCount > 0 && this.spotLightTexture.value.image.width !== spotCount * 4);
-    const recreateRect = !this.rectLightTexture.value ||
-      (rectCount > 0 && this.rectLightTexture.value.image.width !== rectCount * 5);
-
-    // Point light texture - 2D layout
-    if (recreatePoint) {
-      if (this.pointLightTexture.value) {
-        this.pointLightTexture.value.dispose();
-        this.pointLightTexture.value = null;
-      }
+    const exports = this.wasm.exports;
+    if (this.unifiedLights) {
+      this._updateUnifiedLightTexture();
+      return;
     }
+    this._updateLightTexture('point', this._pointRecordCount(), exports.getPointLightTexture());
+    this._updateLightTexture('spot', exports.getSpotLightCount(), exports.getSpotLightTexture());
+    this._updateLightTexture('rect', exports.getRectLightCount(), exports.getRectLightTexture());
+  }
 
-    if (pointCount > 0 && recreatePoint) {
-      // Get WASM data pointer and create a view of the actual allocated memory
-      const wasmDataPtr = this.wasm.exports.getPointLightTexture();
-
-      // Verify alignment
-      if (wasmDataPtr % 4 !== 0) {
-        console.error(`[ClusterLightingSystem] WASM pointer not aligned: ${wasmDataPtr}`);
-        return;
-      }
+  // Create or refresh one light texture. Records fill rows of
+  // 1 << lightRowShifts[type] lights (the last row padded), so the core's
+  // buffer is already in texture order and can be used in place when it
+  // covers the texture's rows.
+  _updateLightTexture(type, count, wasmDataPtr) {
+    if (count === 0) return;
 
-      const wasmData = new Float32Array(
-        this.wasm.exports.memory.buffer,
-        wasmDataPtr,
-        actualFloats  // Only the actual allocated data
-      );
-      // Zero-copy mode: Use WASM memory directly when possible
-      const paddedFloats = TEXTURE_WIDTH * textureHeight * 4;
-      const canUseZeroCopy = this.useZeroCopy && (actualFloats === paddedFloats);
+    const exports = this.wasm.exports;
+    const uniform = this[`${type}LightTexture`];
+    const shift = this.lightRowShifts[type];
+    const width = (1 << shift) * LightTexels[type];
+    const rows = (count + (1 << shift) - 1) >> shift;
+    // The point buffer also holds the reserved static lights
+    const capacity = type === 'point' && exports.getPointTextureCapacity ? exports.getPointTextureCapacity() :
+      exports.getLightTextureCapacity ? exports.getLightTextureCapacity() : count;
+    const height = this._lightTextureRows(uniform.value, width, rows, this.useZeroCopy ? capacity >> shift : Infinity);
+    const zeroCopy = this.useZeroCopy && (height << shift) <= capacity;
+    this._refreshLightTexture(type, uniform, wasmDataPtr, width, height, rows,
+      zeroCopy, count * LightTexels[type] * 4);
+  }
+
+  // Texture rows for `rows` live rows. Textures are sized in powers of two
+  // and kept while the live rows fit and use at least a quarter of them, so
+  // adding and removing lights reuses the texture; the shaders only read
+  // below lightCounts. `limit` caps growth at what the core's buffer covers.
+  _lightTextureRows(texture, width, rows, limit) {
+    const current = texture && texture.image.width === width ? texture.image.height : 0;
+    if (current >= rows && current <= limit && current < rows * 4) return current;
+    let height = 1;
+    while (height < rows) height <<= 1;
+    return Math.max(rows, Math.min(height, limit));
+  }
+
+  // Create or refresh the unified light texture. The core lays the types out
+  // on whole rows and sizes its buffer to them, so it is always used in place
+  // in zero-copy mode.
+  _updateUnifiedLightTexture() {
+    const exports = this.wasm.exports;
+    const layout = new Int32Array(exports.memory.buffer, exports.getUnifiedLightLayout(), 7);
+    const width = layout[0];
+    const rows = layout[3];
+    this.lightRowBases.value.set(layout[1], layout[2]);
+    if (rows === 0) return;
+
+    // Unified rows are always the core's width, whatever the GPU's texture limit
+    this.pointLightRowShift.value = layout[4];
+    this.spotLightRowShift.value = layout[5];
+    this.rectLightRowShift.value = layout[6];
+
+    // The core grows its row capacity geometrically; the texture follows it
+    const capacity = exports.getUnifiedLightRowCapacity ? exports.getUnifiedLightRowCapacity() : rows;
+    const height = this._lightTextureRows(this.lightTexture.value, width, rows, capacity);
+    this._refreshLightTexture('unified', this.lightTexture, exports.getUnifiedLightTexture(), width, height, rows,
+      this.useZeroCopy, width * rows * 4);
+  }
+
+  // Shared by both texture modes. Only the first `rows` rows are uploaded to
+  // an existing texture; copyFloats is how much of the core's buffer to copy
+  // when not zero-copy.
+  _refreshLightTexture(key, uniform, wasmDataPtr, width, height, rows, zeroCopy, copyFloats) {
+    if (wasmDataPtr % 4 !== 0) {
+      console.error(`[ClusterLightingSystem] ${key} light WASM pointer not aligned: ${wasmDataPtr}`);
+      if (uniform.value) uniform.value.needsUpdate = true;
+      return;
+    }
 
-      if (canUseZeroCopy) {
+    const memory = this.wasm.exports.memory.buffer;
 
-        // Store reference to current buffer version
+    // Recreate on size or mode changes. A zero-copy view left behind by
+    // memory growth (detached or replaced buffer) or by a moved core buffer
+    // is re-pointed instead, keeping the texture and its GPU allocation.
+    let texture = uniform.value;
+    if (texture) {
+      const data = texture.image.data;
+      const inPlace = data.buffer === memory && data.byteOffset === wasmDataPtr;
+      const sameSize = texture.image.width === width && texture.image.height === height;
+      if (sameSize && zeroCopy && !inPlace && data !== this._lightTextureData[key]) {
+        texture.image.data = new Float32Array(memory, wasmDataPtr, width * height * 4);
         this.wasmMemoryBufferVersion++;
-        this.pointLightTextureData = wasmData; // Direct reference
-
-        this.pointLightTexture.value = new DataTexture(
-          wasmData, // ← Direct WASM memory reference
-          TEXTURE_WIDTH,
-          textureHeight,
-          RGBAFormat,
-          FloatType
-        );
-      } else {
-        // COPY MODE: Need padding or zero-copy disabled
-
-        // Reuse existing buffer if size matches
-        if (!this.pointLightTextureData || this.pointLightTextureData.length !== paddedFloats) {
-          this.pointLightTextureData = new Float32Array(paddedFloats);
-        }
-
-        // Copy WASM data into padded array
-        this.pointLightTextureData.set(wasmData);
-
-        this.pointLightTexture.value = new DataTexture(
-          this.pointLightTextureData,
-          TEXTURE_WIDTH,
-          textureHeight,
-          RGBAFormat,
-          FloatType
-        );
+      } else if (!sameSize || inPlace !== zeroCopy) {
+        texture.dispose();
+        texture = uniform.value = null;
       }
+    }
 
-      this.pointLightTexture.value.minFilter = NearestFilter;
-      this.pointLightTexture.value.magFilter = NearestFilter;
-      this.pointLightTexture.value.needsUpdate = true;
-
-    } else if (this.pointLightTexture.value && pointCount > 0) {
-      // Update existing texture with fresh WASM data
-      const wasmDataPtr = this.wasm.exports.getPointLightTexture();
-
-      if (wasmDataPtr % 4 !== 0) {
-        console.error(`[ClusterLightingSystem] WASM pointer not aligned in update: ${wasmDataPtr}`);
-        this.pointLightTexture.value.needsUpdate = true;
-        return;
+    const created = !texture;
+    if (!texture) {
+      let data;
+      if (zeroCopy) {
+        data = new Float32Array(memory, wasmDataPtr, width * height * 4);
+      } else {
+        // Reuse the padded copy when its size still matches
+        data = this._lightTextureData[key];
+        if (!data || data.length !== width * height * 4) {
+          data = this._lightTextureData[key] = new Float32Array(width * height * 4);
+        }
       }
+      if (zeroCopy) this.wasmMemoryBufferVersion++;
 
-      const wasmData = new Float32Array(
-        this.wasm.exports.memory.buffer,
-        wasmDataPtr,
-        actualFloats
-      );
+      texture = uniform.value = new DataTexture(data, width, height, RGBAFormat, FloatType);
+      texture.minFilter = NearestFilter;
+      texture.magFilter = NearestFilter;
+    }
 
-      // Copy into texture's data array
-      this.pointLightTexture.value.image.data.set(wasmData);
-      this.pointLightTexture.value.needsUpdate = true;
+    if (!zeroCopy) {
+      texture.image.data.set(new Float32Array(memory, wasmDataPtr, copyFloats));
     }
 
-    // Spot light texture
-    if (recreateSpot) {
-      if (this.spotLightTexture.value) {
-        this.spotLightTexture.value.dispose();
-        this.spotLightTexture.value = null;
+    // Textures keep headroom rows past the live ones (see _lightTextureRows);
+    // skip uploading them. One range per row: three.js uploads each range as
+    // a single texture row.
+    if (texture.addUpdateRange) {
+      texture.clearUpdateRanges();
+      if (!created && rows < height) {
+        for (let row = 0; row < rows; row++) texture.addUpdateRange(row * width * 4, width * 4);
       }
     }
+    texture.needsUpdate = true;
+  }
 
-    if (spotCount > 0 && recreateSpot) {
-      const wasmDataPtr = this.wasm.exports.getSpotLightTexture();
-      const spotFloats = spotCount * 4 * 4;
-
-      const wasmView = new Float32Array(
-        this.wasm.exports.memory.buffer,
-        wasmDataPtr,
-        spotFloats
-      );
+  updateProxyGeometry() {
+    const exports = this.wasm.exports;
+    // One instance per light slot, including the batch padding between types
+    this.proxy.geometry.instanceCount = lightSlotCount(
+      this._pointRecordCount(), exports.getSpotLightCount(), exports.getRectLightCount());
+  }
 
-      this.spotLightTexture.value = new DataTexture(
-        wasmView,
-        spotCount * 4,
-        1,
-        RGBAFormat,
-        FloatType
-      );
-      this.spotLightTexture.value.minFilter = NearestFilter;
-      this.spotLightTexture.value.magFilter = NearestFilter;
-      this.spotLightTexture.value.needsUpdate = true;
-    } else if (this.spotLightTexture.value && spotCount > 0) {
-      // Update existing texture with fresh WASM data
-      const wasmDataPtr = this.wasm.exports.getSpotLightTexture();
-      const spotFloats = spotCount * 4 * 4;
-
-      if (wasmDataPtr % 4 !== 0) {
-        console.error(`[ClusterLightingSystem] Spot light WASM pointer not aligned in update: ${wasmDataPtr}`);
-        this.spotLightTexture.value.needsUpdate = true;
-        return;
-      }
+  // ──────────────────────────────────────────────────────────────
+  //                   LIGHT EXPORT/QUERY
+  // ──────────────────────────────────────────────────────────────
+  exportLights() {
+    const lightData = [];
 
-      // Check if the texture data buffer is detached (happens when WASM memory grows)
-      const textureData = this.spotLightTexture.value.image.data;
-      if (textureData.buffer.byteLength === 0 || textureData.buffer !== this.wasm.exports.memory.buffer) {
-        // Buffer is detached or from old memory, recreate texture
-        const wasmView = new Float32Array(
-          this.wasm.exports.memory.buffer,
-          wasmDataPtr,
-          spotFloats
-        );
-        this.spotLightTexture.value = new DataTexture(
-          wasmView,
-          spotCount * 4,
-          1,
-          RGBAFormat,
-          FloatType
-        );
-        this.spotLightTexture.value.minFilter = NearestFilter;
-        this.spotLightTexture.value.magFilter = NearestFilter;
-      } else {
-        // Buffer is still valid, just update it
-        const wasmData = new Float32Array(
-          this.wasm.exports.memory.buffer,
-          wasmDataPtr,
-          spotFloats
-        );
-        textureData.set(wasmData);
-      }
-      this.spotLightTexture.value.needsUpdate = true;
+    // Reverse the global index map once instead of searching it per light
+    const globalIndices = { point: [], spot: [], rect: [] };
+    for (const [globalIndex, m] of this.lightTypeMap.entries()) {
+      globalIndices[m.type][m.typeIndex] = globalIndex;
     }
 
-    // Rect light texture
-    if (recreateRect) {
-      if (this.rectLightTexture.value) {
-        this.rectLightTexture.value.dispose();
-        this.rectLightTexture.value = null;
-      }
+    for (const type of ['point', 'spot', 'rect']) {
+      const lights = this.mirrorLights ? this._mirrorArray(type) : this._readLights(type);
+      lights.forEach((light, index) => {
+        lightData.push({
+          ...light,
+          type,
+          globalIndex: globalIndices[type][index]
+        });
+      });
     }
+    
+    return lightData;
+  }
 
-    if (rectCount > 0 && recreateRect) {
-      const wasmDataPtr = this.wasm.exports.getRectLightTexture();
-      const rectFloats = rectCount * 5 * 4;
+  // Current properties of a light: the JS mirror when enabled, otherwise read from WASM memory
+  getLight(globalIndex) {
+    const mapping = this.lightTypeMap.get(globalIndex);
+    if (!mapping) return null;
+    return this._lightRecord(mapping.type, mapping.typeIndex);
+  }
 
-      const wasmView = new Float32Array(
-        this.wasm.exports.memory.buffer,
-        wasmDataPtr,
-        rectFloats
-      );
+  _mirrorArray(type) {
+    return type === 'spot' ? this.spotLights : type === 'rect' ? this.rectLights : this.pointLights;
+  }
 
-      this.rectLightTexture.value = new DataTexture(
-        wasmView,
-        rectCount * 5,
-        1,
-        RGBAFormat,
-        FloatType
-      );
-      this.rectLightTexture.value.minFilter = NearestFilter;
-      this.rectLightTexture.value.magFilter = NearestFilter;
-      this.rectLightTexture.value.needsUpdate = true;
-    } else if (this.rectLightTexture.value && rectCount > 0) {
-      // Update existing texture with fresh WASM data
-      const wasmDataPtr = this.wasm.exports.getRectLightTexture();
-      const rectFloats = rectCount * 5 * 4;
-
-      if (wasmDataPtr % 4 !== 0) {
-        console.error(`[ClusterLightingSystem] Rect light WASM pointer not aligned in update: ${wasmDataPtr}`);
-        this.rectLightTexture.value.needsUpdate = true;
-        return;
-      }
+  _lightRecord(type, typeIndex) {
+    if (this.mirrorLights) return this._mirrorArray(type)[typeIndex] || null;
+    return this._readLight(type, typeIndex);
+  }
 
-      // Check if the texture data buffer is detached (happens when WASM memory grows)
-      const textureData = this.rectLightTexture.value.image.data;
-      if (textureData.buffer.byteLength === 0 || textureData.buffer !== this.wasm.exports.memory.buffer) {
-        // Buffer is detached or from old memory, recreate texture
-        const wasmView = new Float32Array(
-          this.wasm.exports.memory.buffer,
-          wasmDataPtr,
-          rectFloats
-        );
-        this.rectLightTexture.value = new DataTexture(
-          wasmView,
-          rectCount * 5,
-          1,
-          RGBAFormat,
-          FloatType
-        );
-        this.rectLightTexture.value.minFilter = NearestFilter;
-        this.rectLightTexture.value.magFilter = NearestFilter;
-      } else {
-        // Buffer is still valid, just update it
-        const wasmData = new Float32Array(
-          this.wasm.exports.memory.buffer,
-          wasmDataPtr,
-          rectFloats
-        );
-        textureData.set(wasmData);
-      }
-      this.rectLightTexture.value.needsUpdate = true;
+  // Byte layout of the core's light records (null on builds without getLightLayout)
+  _getLightLayout(type) {
+    const exports = this.wasm.exports;
+    if (!exports.getLightLayout) return null;
+
+    if (!this._lightLayouts) {
+      const slots = exports.getLightLayoutSlots();
+      const read = (t) => new Int32Array(exports.memory.buffer, exports.getLightLayout(t), slots).slice();
+      this._lightLayouts = {
+        point: read(LightType.POINT),
+        spot: read(LightType.SPOT),
+        rect: read(LightType.RECT)
+      };
     }
+    return this._lightLayouts[type];
   }
 
-  updateProxyGeometry() {
-    const totalCount = this.pointLights.length + this.spotLights.length + this.rectLights.length;
-    this.proxy.geometry.instanceCount = totalCount;
+  _lightArrayBase(type) {
+    const exports = this.wasm.exports;
+    const ptr = type === 'spot' ? exports.getSpotLightsArrayPtr() :
+                type === 'rect' ? exports.getRectLightsArrayPtr() :
+                exports.getPointLightsArrayPtr();
+    return new Uint32Array(exports.memory.buffer, ptr, 1)[0];
   }
 
-  // ──────────────────────────────────────────────────────────────
-  //                   LIGHT EXPORT/QUERY
-  // ──────────────────────────────────────────────────────────────
-  exportLights() {
-    const lightData = [];
+  _readLights(type) {
+    const layout = this._getLightLayout(type);
+    if (!layout) return [];
 
-    // Export point lights
-    this.pointLights.forEach((light, index) => {
-      lightData.push({
-        ...light,
-        type: 'point',
-        globalIndex: Array.from(this.lightTypeMap.entries()).find(([_, m]) => m.type === 'point' && m.typeIndex === index)?.[0]
-      });
-    });
+    const exports = this.wasm.exports;
+    const count = type === 'spot' ? exports.getSpotLightCount() :
+                  type === 'rect' ? exports.getRectLightCount() :
+                  exports.getPointLightCount();
+    const view = new DataView(exports.memory.buffer);
+    const base = this._lightArrayBase(type);
 
-    // Export spot lights
-    this.spotLights.forEach((light, index) => {
-      lightData.push({
-        ...light,
-        type: 'spot',
-        globalIndex: Array.from(this.lightTypeMap.entries()).find(([_, m]) => m.type === 'spot' && m.typeIndex === index)?.[0]
-      });
-    });
+    const lights = new Array(count);
+    for (let i = 0; i < count; i++) {
+      lights[i] = this._decodeLight(view, base + i * layout[LightLayout.STRIDE], layout);
+    }
+    return lights;
+  }
+
+  _readLight(type, typeIndex) {
+    const layout = this._getLightLayout(type);
+    if (!layout) return null;
+
+    const exports = this.wasm.exports;
+    const count = type === 'spot' ? exports.getSpotLightCount() :
+                  type === 'rect' ? exports.getRectLightCount() :
+                  exports.getPointLightCount();
+    if (typeIndex < 0 || typeIndex >= count) return null;
+
+    const view = new DataView(exports.memory.buffer);
+    const base = this._lightArrayBase(type);
+    return this._decodeLight(view, base + typeIndex * layout[LightLayout.STRIDE], layout);
+  }
+
+  // Decode one light record into the same shape addLight() accepts
+  _decodeLight(view, ptr, layout) {
+    const f32 = (offset) => view.getFloat32(ptr + offset, true);
+    const vec3 = (offset) => new Vector3(f32(offset), f32(offset + 4), f32(offset + 8));
+
+    const pos = layout[LightLayout.POSITION];
+    const col = layout[LightLayout.COLOR];
+    const light = {
+      position: vec3(pos),
+      color: new Color(f32(col), f32(col + 4), f32(col + 8)),
+      intensity: f32(col + 12),
+      radius: f32(pos + 12),
+      decay: f32(layout[LightLayout.DECAY]),
+      visible: view.getUint8(ptr + layout[LightLayout.VISIBLE]) !== 0,
+      groups: view.getUint32(ptr + layout[LightLayout.GROUP_MASK], true),
+      layers: view.getUint8(ptr + layout[LightLayout.LAYER_MASK]),
+      castsShadow: view.getUint8(ptr + layout[LightLayout.CASTS_SHADOW]) !== 0,
+      shadowIntensity: f32(layout[LightLayout.SHADOW_INTENSITY]),
+      animation: this._decodeAnimation(view, ptr + layout[LightLayout.ANIM], layout)
+    };
 
-    // Export rect lights
-    this.rectLights.forEach((light, index) => {
-      lightData.push({
-        ...light,
-        type: 'rect',
-        globalIndex: Array.from(this.lightTypeMap.entries()).find(([_, m]) => m.type === 'rect' && m.typeIndex === index)?.[0]
-      });
-    });
-    
-    return lightData;
+    if (layout[LightLayout.DIRECTION] >= 0) {
+      light.direction = vec3(layout[LightLayout.DIRECTION]);
+      light.angle = f32(layout[LightLayout.ANGLE]);
+      light.penumbra = f32(layout[LightLayout.PENUMBRA]);
+    }
+    if (layout[LightLayout.SIZE] >= 0) {
+      light.width = f32(layout[LightLayout.SIZE]);
+      light.height = f32(layout[LightLayout.SIZE] + 4);
+      light.normal = vec3(layout[LightLayout.NORMAL]);
+    }
+    return light;
+  }
+
+  // Inverse of _packAnimationParams. Field order follows the *Params structs in cluster-lights.c
+  _decodeAnimation(view, ptr, layout) {
+    const flags = view.getUint32(ptr, true);
+    if (!flags) return null;
+
+    const f32 = (offset) => view.getFloat32(ptr + offset, true);
+    const u8 = (offset) => view.getUint8(ptr + offset);
+    const vec3 = (offset) => new Vector3(f32(offset), f32(offset + 4), f32(offset + 8));
+    const animation = {};
+
+    if (flags & Animation.CIRCULAR) {
+      const o = layout[LightLayout.ANIM_CIRCULAR];
+      animation.circular = { speed: f32(o), radius: f32(o + 4) };
+    }
+    if (flags & Animation.LINEAR) {
+      const o = layout[LightLayout.ANIM_LINEAR];
+      const mode = u8(o + 24);
+      animation.linear = {
+        to: vec3(o),
+        duration: f32(o + 16),
+        delay: f32(o + 20),
+        mode: mode === LinearMode.LOOP ? 'loop' : mode === LinearMode.PINGPONG ? 'pingpong' : 'once'
+      };
+    }
+    if (flags & Animation.WAVE) {
+      const o = layout[LightLayout.ANIM_WAVE];
+      animation.wave = { axis: vec3(o), speed: f32(o + 16), amplitude: f32(o + 20), phase: f32(o + 24) };
+    }
+    if (flags & Animation.FLICKER) {
+      const o = layout[LightLayout.ANIM_FLICKER];
+      animation.flicker = { speed: f32(o), intensity: f32(o + 4), seed: f32(o + 8) };
+    }
+    if (flags & Animation.PULSE) {
+      const o = layout[LightLayout.ANIM_PULSE];
+      const target = u8(o + 8);
+      animation.pulse = {
+        speed: f32(o),
+        amount: f32(o + 4),
+        target: target === PulseTarget.BOTH ? 'both' : target === PulseTarget.RADIUS ? 'radius' : 'intensity'
+      };
+    }
+    if (flags & Animation.ROTATE) {
+      const o = layout[LightLayout.ANIM_ROTATION];
+      animation.rotation = {
+        axis: vec3(o),
+        speed: f32(o + 16),
+        angle: f32(o + 20),
+        mode: u8(o + 24) === RotateMode.SWING ? 'swing' : 'continuous'
+      };
+    }
+    return animation;
   }
 
   importLights(lightData) {
     this.clearLights();
     
-    lightData.forEach(light => {
-      this.addLight(light);
-    });
+    // Refresh counts/textures once for the whole set, not per light
+    this._patching = true;
+    try {
+      lightData.forEach(light => {
+        this.addLight(light);
+      });
+    } finally {
+      this._patching = false;
+    }
+    this._lightsChanged();
     
     if (this.pointLightTexture.value) this.pointLightTexture.value.needsUpdate = true;
     if (this.spotLightTexture.value) this.spotLightTexture.value.needsUpdate = true;
@@ -1603,6 +2149,548 @@ export class ClusterLightingSystem {
     return -1;
   }
 
+  // ──────────────────────────────────────────────────────────────
+  //                   LIGHT GROUPS
+  // ──────────────────────────────────────────────────────────────
+  // Up to 32 groups. Group state is applied by the core when packing light
+  // data, so each call is O(1) no matter how many lights are in the group.
+  // A light in several groups is hidden if any of them is disabled, and
+  // takes the product of their intensity multipliers and tints.
+  setLightGroupEnabled(group, enabled) {
+    if (this.wasm.exports.setLightGroupEnabled) {
+      this.wasm.exports.setLightGroupEnabled(group, enabled ? 1 : 0);
+    }
+  }
+
+  setLightGroupIntensity(group, intensity) {
+    if (this.wasm.exports.setLightGroupIntensity) {
+      this.wasm.exports.setLightGroupIntensity(group, intensity);
+    }
+  }
+
+  setLightGroupTint(group, color) {
+    if (this.wasm.exports.setLightGroupTint) {
+      this.wasm.exports.setLightGroupTint(group, color.r, color.g, color.b);
+    }
+  }
+
+  resetLightGroups() {
+    if (this.wasm.exports.resetLightGroups) {
+      this.wasm.exports.resetLightGroups();
+    }
+  }
+
+  // ──────────────────────────────────────────────────────────────
+  //                   SHADOW CASTER SELECTION
+  // ──────────────────────────────────────────────────────────────
+  // Each update() the core picks the `count` most important rendered lights
+  // with castsShadow set (intensity x projected size, with a bonus for last
+  // frame's picks so the set does not flicker). 0 disables selection.
+  setShadowBudget(count) {
+    if (this.wasm.exports.setShadowBudget) {
+      this.wasm.exports.setShadowBudget(count);
+    }
+  }
+
+  // Score multiplier (>= 1) for lights selected last frame
+  setShadowHysteresis(factor) {
+    if (this.wasm.exports.setShadowHysteresis) {
+      this.wasm.exports.setShadowHysteresis(factor);
+    }
+  }
+
+  // Fixed-size shadow atlas the core plans tiles in (size is rounded down to
+  // a power of two). Point lights get six cube-face tiles, spot/rect one.
+  setShadowAtlas(size, minTile = 128) {
+    if (this.wasm.exports.setShadowAtlas) {
+      this.wasm.exports.setShadowAtlas(size, minTile);
+    }
+  }
+
+  // Tile texels per unit of projected size (radius / distance)
+  setShadowTileScale(scale) {
+    if (this.wasm.exports.setShadowTileScale) {
+      this.wasm.exports.setShadowTileScale(scale);
+    }
+  }
+
+  // Casters picked by the last update(), most important first. Positions and
+  // directions are in view space; typeIndex refers to that update's order.
+  // tiles holds the caster's atlas rects in texels (empty if it did not fit).
+  getShadowCasters() {
+    const exports = this.wasm.exports;
+    if (!exports.getShadowCasters) return [];
+
+    const count = exports.getShadowCasterCount();
+    if (count === 0) return [];
+
+    // 48 bytes per caster: vec4 viewPos, vec4 viewDir, score, shadowIntensity, uint32 index, uint32 type
+    const ptr = exports.getShadowCasters();
+    const f32 = new Float32Array(exports.memory.buffer, ptr, count * 12);
+    const u32 = new Uint32Array(exports.memory.buffer, ptr, count * 12);
+    const typeNames = ['point', 'spot', 'rect'];
+    const casters = new Array(count);
+
+    for (let i = 0; i < count; i++) {
+      const o = i * 12;
+      casters[i] = {
+        type: typeNames[u32[o + 11]],
+        typeIndex: u32[o + 10],
+        position: new Vector3(f32[o], f32[o + 1], f32[o + 2]),
+        radius: f32[o + 3],
+        direction: new Vector3(f32[o + 4], f32[o + 5], f32[o + 6]),
+        angle: f32[o + 7],
+        score: f32[o + 8],
+        shadowIntensity: f32[o + 9],
+        tiles: []
+      };
+    }
+
+    if (exports.getShadowTiles) {
+      // 8 bytes per tile: uint16 x, y, size, uint8 caster, uint8 face
+      const tileCount = exports.getShadowTileCount();
+      const u16 = new Uint16Array(exports.memory.buffer, exports.getShadowTiles(), tileCount * 4);
+      for (let i = 0; i < tileCount; i++) {
+        const o = i * 4;
+        const caster = casters[u16[o + 3] & 0xFF];
+        if (caster) caster.tiles.push({ x: u16[o], y: u16[o + 1], size: u16[o + 2], face: u16[o + 3] >>> 8 });
+      }
+    }
+
+    return casters;
+  }
+
+  // ──────────────────────────────────────────────────────────────
+  //                   LIGHT GENERATORS
+  // ──────────────────────────────────────────────────────────────
+  // Procedural point-light fields built by the core straight into its light
+  // arrays. All generators share the style options:
+  //   seed, palette (colors, hex or CSS), paletteBlend (0..1),
+  //   radius, intensity ([min, max] or a number), decay, groups, layers,
+  //   animation: { none, circular, wave, flicker, pulse } where `none` is a
+  //   weight and the others are { weight, ...param ranges } (see README).
+  // Each returns the global indices of the new lights ([] on older builds).
+
+  // nx * ny * nz lights at cell centres of the box; jitter (0..1) displaces
+  // each light within its cell
+  generateGridLights({ counts = [10, 1, 10], min, max, jitter = 0, ...style } = {}) {
+    const [nx, ny, nz] = counts;
+    const lo = this._generatorVec(min, -50);
+    const hi = this._generatorVec(max, 50);
+    return this._runGenerator('generateGridLights', style, 0, null, (seed) =>
+      this.wasm.exports.generateGridLights(nx, ny, nz, lo[0], lo[1], lo[2], hi[0], hi[1], hi[2], jitter, seed));
+  }
+
+  // Up to `count` lights in the box, none closer than minDistance. A box
+  // thinner than minDistance on an axis gives a flat (2D) distribution.
+  generatePoissonLights({ count = 1000, minDistance = 1, min, max, attempts = 30, ...style } = {}) {
+    const lo = this._generatorVec(min, -50);
+    const hi = this._generatorVec(max, 50);
+    return this._runGenerator('generatePoissonLights', style, 0, null, (seed) =>
+      this.wasm.exports.generatePoissonLights(count, minDistance, lo[0], lo[1], lo[2], hi[0], hi[1], hi[2], attempts, seed));
+  }
+
+  // A light every `spacing` units along a path of Vector3s (or flat xyz)
+  generatePolylineLights({ points = [], spacing = 1, closed = false, jitter = 0, ...style } = {}) {
+    const flat = this._generatorPoints(points);
+    const pointCount = flat.length / 3;
+    if (pointCount === 0) return [];
+    return this._runGenerator('generatePolylineLights', style, flat.length,
+      (mem, ptr) => new Float32Array(mem, ptr, flat.length).set(flat),
+      (seed) => this.wasm.exports.generatePolylineLights(pointCount, spacing, closed ? 1 : 0, jitter, seed));
+  }
+
+  // `count` lights spread uniformly by area over a triangle mesh, given as a
+  // BufferGeometry (optionally with `matrix`, e.g. mesh.matrixWorld) or as
+  // flat `positions` / `indices` arrays. `offset` lifts lights off the surface.
+  generateMeshLights({ count = 1000, geometry, matrix, positions, indices, offset = 0, ...style } = {}) {
+    let verts = positions;
+    let index = indices;
+    if (geometry) {
+      const attr = geometry.getAttribute('position');
+      const v = new Vector3();
+      verts = new Float32Array(attr.count * 3);
+      for (let i = 0; i < attr.count; i++) {
+        v.fromBufferAttribute(attr, i);
+        if (matrix) v.applyMatrix4(matrix);
+        verts[i * 3] = v.x;
+        verts[i * 3 + 1] = v.y;
+        verts[i * 3 + 2] = v.z;
+      }
+      index = geometry.index ? geometry.index.array : null;
+    }
+    if (!verts || verts.length < 9) return [];
+
+    const vertexCount = Math.floor(verts.length / 3);
+    const indexCount = index ? index.length - (index.length % 3) : 0;
+
+    // Indices go through their own uint32 input; reserve it before the
+    // generator input so no later growth invalidates the views below
+    let indexInput = 0;
+    if (indexCount) {
+      if (!this.wasm.exports.getLightGeneratorIndexInput) {
+        console.warn('generateMeshLights requires a rebuilt WASM module');
+        return [];
+      }
+      indexInput = this.wasm.exports.getLightGeneratorIndexInput(indexCount);
+      if (!indexInput) return [];
+    }
+
+    return this._runGenerator('generateMeshLights', style, vertexCount * 3,
+      (mem, ptr) => {
+        new Float32Array(mem, ptr, vertexCount * 3).set(verts.length === vertexCount * 3 ? verts : verts.subarray(0, vertexCount * 3));
+        if (indexCount) new Uint32Array(mem, indexInput, indexCount).set(index.length === indexCount ? index : index.subarray(0, indexCount));
+      },
+      (seed) => this.wasm.exports.generateMeshLights(count, vertexCount, indexCount, offset, seed));
+  }
+
+  // Write style, palette and shape data, run the generator, then register the
+  // lights it appended
+  _runGenerator(name, style, shapeFloats, writeShape, generate) {
+    const exports = this.wasm.exports;
+    if (!exports[name]) {
+      console.warn(`${name} requires a rebuilt WASM module`);
+      return [];
+    }
+
+    const palette = this._generatorPalette(style.palette);
+    const input = exports.getLightGeneratorInput(Math.max(1, palette.length + shapeFloats));
+    if (!input) return [];
+    this._writeGeneratorStyle(style, palette.length / 3);
+
+    // Fresh buffer reference: growing the input may have grown memory
+    const mem = exports.memory.buffer;
+    new Float32Array(mem, input, palette.length).set(palette);
+    if (writeShape) writeShape(mem, input + palette.length * 4);
+
+    const start = exports.getPointLightCount();
+    const added = generate((style.seed || 0) >>> 0);
+    if (added <= 0) return [];
+
+    const ids = new Array(added);
+    for (let i = 0; i < added; i++) {
+      ids[i] = this.globalLightIndex++;
+      this._registerLight(ids[i], 'point', start + i);
+    }
+
+    if (this.mirrorLights) {
+      const layout = this._getLightLayout('point');
+      const view = new DataView(exports.memory.buffer);
+      const base = this._lightArrayBase('point');
+      for (let i = 0; i < added; i++) {
+        this.pointLights[start + i] = this._decodeLight(view, base + (start + i) * layout[LightLayout.STRIDE], layout);
+      }
+    }
+
+    this.hasAnimatedLights = exports.getHasAnimatedLights() > 0;
+    if (!this._patching) this._lightsChanged();
+    return ids;
+  }
+
+  // Fill the core's LightGenStyle (field order as in cluster-lights.c)
+  _writeGeneratorStyle(style, paletteCount) {
+    const exports = this.wasm.exports;
+    const ptr = exports.getLightGeneratorStyle();
+    const f32 = new Float32Array(exports.memory.buffer, ptr, 34);
+    const u32 = new Uint32Array(exports.memory.buffer, ptr, 34);
+    const range = (value, fallback) =>
+      value === undefined ? fallback : Array.isArray(value) ? value : [value, value];
+    const anim = style.animation || {};
+    const weight = (entry) => !entry ? 0 : entry.weight !== undefined ? entry.weight : 1;
+    const circular = anim.circular || {};
+    const wave = anim.wave || {};
+    const flicker = anim.flicker || {};
+    const pulse = anim.pulse || {};
+    const hasAnimation = anim.circular || anim.wave || anim.flicker || anim.pulse;
+
+    let pulseTarget = PulseTarget.INTENSITY;
+    if (pulse.target === 'radius' || pulse.target === PulseTarget.RADIUS) pulseTarget = PulseTarget.RADIUS;
+    else if (pulse.target === 'both' || pulse.target === PulseTarget.BOTH) pulseTarget = PulseTarget.BOTH;
+    const axis = wave.axis ? this._generatorVec(wave.axis, 0) : [0, 1, 0];
+
+    f32.set([
+      ...range(style.radius, [2, 6]),
+      ...range(style.intensity, [1, 4]),
+      style.decay !== undefined ? style.decay : 2,
+      anim.none !== undefined ? anim.none : (hasAnimation ? 0 : 1),
+      weight(anim.circular), weight(anim.wave), weight(anim.flicker), weight(anim.pulse),
+      ...range(circular.speed, [0.5, 1.5]), ...range(circular.radius, [0.5, 2]),
+      ...range(wave.speed, [0.5, 1.5]), ...range(wave.amplitude, [0.5, 2]), ...axis,
+      ...range(flicker.speed, [2, 8]), ...range(flicker.intensity, [0.2, 0.5]),
+      ...range(pulse.speed, [0.5, 2]), ...range(pulse.amount, [0.2, 0.5]), pulseTarget,
+      style.paletteBlend || 0
+    ]);
+    u32[31] = paletteCount;
+    u32[32] = (style.groups || 0) >>> 0;
+    u32[33] = (style.layers !== undefined ? style.layers : 1) & 0xFF;
+  }
+
+  _generatorPalette(palette) {
+    const colors = palette === undefined ? [0xffffff] : Array.isArray(palette) ? palette : [palette];
+    const out = new Float32Array(colors.length * 3);
+    colors.forEach((c, i) => {
+      tempColor.set(c);
+      out[i * 3] = tempColor.r;
+      out[i * 3 + 1] = tempColor.g;
+      out[i * 3 + 2] = tempColor.b;
+    });
+    return out;
+  }
+
+  _generatorVec(v, fallback) {
+    if (v === undefined) return [fallback, fallback, fallback];
+    return Array.isArray(v) ? v : [v.x, v.y, v.z];
+  }
+
+  _generatorPoints(points) {
+    if (points.length === 0 || typeof points[0] === 'number') return Float32Array.from(points);
+    const flat = new Float32Array(points.length * 3);
+    points.forEach((p, i) => {
+      flat[i * 3] = p.x;
+      flat[i * 3 + 1] = p.y;
+      flat[i * 3 + 2] = p.z;
+    });
+    return flat;
+  }
+
+  // ──────────────────────────────────────────────────────────────
+  //                   STATIC POINT LIGHTS
+  // ──────────────────────────────────────────────────────────────
+  // Compact storage for large sets of lights that never change: positions
+  // are stored as 16-bit offsets within small spatial cells. Static lights
+  // have no ids, animation, groups, layers or shadows and are only removed
+  // together by clearStaticPointLights().
+
+  // Reserve room for `capacity` static lights. Clears existing static lights.
+  // Static and dynamic point lights share maxSafeLights, so the capacity is
+  // clamped to the point slots not in use and later dynamic point adds stop
+  // at maxSafeLights - capacity. Returns the reserved capacity, or -1 if
+  // allocation failed.
+  reserveStaticPointLights(capacity) {
+    const exports = this.wasm.exports;
+    if (!exports.reserveStaticPointLights) {
+      console.warn('reserveStaticPointLights requires a rebuilt WASM module');
+      return -1;
+    }
+    const reserved = exports.reserveStaticPointLights(Math.max(0, capacity | 0));
+    if (!this._patching) this._lightsChanged();
+    return reserved;
+  }
+
+  // Add [{ position, color, intensity, radius, decay }]. Returns the number
+  // added, which stops at the reserved capacity.
+  addStaticPointLights(lights) {
+    const exports = this.wasm.exports;
+    if (!exports.addStaticPointLights || !lights.length) return 0;
+
+    const input = exports.getStaticPointInput(lights.length);
+    if (!input) return 0;
+    const data = new Float32Array(exports.memory.buffer, input, lights.length * 8);
+    for (let i = 0; i < lights.length; i++) {
+      const light = lights[i];
+      const p = light.position;
+      const c = light.color;
+      const intensity = light.intensity || 10;
+      const o = i * 8;
+      data[o] = p.x;
+      data[o + 1] = p.y;
+      data[o + 2] = p.z;
+      data[o + 3] = light.radius || 10;
+      data[o + 4] = c.r * intensity;
+      data[o + 5] = c.g * intensity;
+      data[o + 6] = c.b * intensity;
+      data[o + 7] = light.decay || 2;
+    }
+
+    const added = exports.addStaticPointLights(lights.length);
+    if (added > 0 && !this._patching) this._lightsChanged();
+    return Math.max(0, added);
+  }
+
+  clearStaticPointLights() {
+    const exports = this.wasm.exports;
+    if (!exports.clearStaticPointLights || exports.getStaticPointLightCount() === 0) return;
+    exports.clearStaticPointLights();
+    if (!this._patching) this._lightsChanged();
+  }
+
+  // ──────────────────────────────────────────────────────────────
+  //                   LIGHT COMMAND QUEUE
+  // ──────────────────────────────────────────────────────────────
+  // Lock-free ring in WASM memory that other threads write light changes
+  // into (see utils/light-command-queue.js). The core applies them at the
+  // start of its next update. Mirrored JS light objects are not updated.
+
+  // Allocate the queue with room for `capacity` commands per frame.
+  // Returns false if the core does not support it or allocation failed.
+  createLightCommandQueue(capacity = 4096) {
+    const exports = this.wasm.exports;
+    if (!exports.initLightCommandQueue) {
+      console.warn('createLightCommandQueue requires a rebuilt WASM module');
+      return false;
+    }
+    this._lightCommandQueue = exports.initLightCommandQueue(capacity);
+    this._lightCommandProducers = 0;
+    return this._lightCommandQueue !== 0;
+  }
+
+  // Descriptor for new LightCommandProducer(info), on this thread or posted
+  // to a worker. Each call gets its own producer id, up to 256. Returns null
+  // unless the WASM memory is shared, since a worker would otherwise write
+  // into a copy of it.
+  createLightCommandProducer() {
+    if (!this._lightCommandQueue) return null;
+    const memory = this.wasm.exports.memory;
+    if (typeof SharedArrayBuffer === 'undefined' || !(memory.buffer instanceof SharedArrayBuffer)) {
+      console.warn('createLightCommandProducer requires shared WASM memory');
+      return null;
+    }
+    return {
+      memory,
+      queue: this._lightCommandQueue,
+      producer: this._lightCommandProducers++ & 0xFF
+    };
+  }
+
+  // Type and core index to address a light with in commands. The index goes
+  // stale when lights are removed or re-sorted (lightOrderVersion changes),
+  // so re-send it to producers after such changes.
+  getLightCommandTarget(globalIndex) {
+    const mapping = this.lightTypeMap.get(globalIndex);
+    return mapping ? { type: mapping.type, index: mapping.typeIndex } : null;
+  }
+
+  // ──────────────────────────────────────────────────────────────
+  //                   LIGHT STATE REPLICATION
+  // ──────────────────────────────────────────────────────────────
+  // Changes since the previous call as a compact byte stream (quantised,
+  // varint-encoded, changed fields only). `keyframe` encodes the whole scene
+  // for a receiver that is joining. Returns a copy, or null on older builds.
+  encodeLightDelta({ keyframe = false } = {}) {
+    const exports = this.wasm.exports;
+    if (!exports.encodeLightDelta) return null;
+
+    if (keyframe) exports.resetLightDelta();
+    const size = exports.encodeLightDelta();
+    if (size < 0) return null;
+    return new Uint8Array(exports.memory.buffer, exports.getLightDeltaBuffer(), size).slice();
+  }
+
+  // Apply a stream from encodeLightDelta() on another system. The receiver
+  // adopts the sender's light order; new lights get fresh global indices.
+  // A truncated or malformed stream is rejected whole and returns false.
+  applyLightDelta(bytes) {
+    const exports = this.wasm.exports;
+    if (!exports.applyLightDelta) return false;
+
+    const input = exports.getLightDeltaInput(bytes.length);
+    if (!input) return false;
+    new Uint8Array(exports.memory.buffer, input, bytes.length).set(bytes);
+    if (exports.applyLightDelta(bytes.length) !== 0) return false;
+
+    ['point', 'spot', 'rect'].forEach(type => {
+      const count = type === 'spot' ? exports.getSpotLightCount() :
+                    type === 'rect' ? exports.getRectLightCount() :
+                    exports.getPointLightCount();
+      const slots = this._lightSlots[type];
+      if (slots.length > count) {
+        for (const [globalIndex, mapping] of this.lightTypeMap.entries()) {
+          if (mapping.type === type && mapping.typeIndex >= count) this.lightTypeMap.delete(globalIndex);
+        }
+        slots.length = count;
+      }
+      for (let i = slots.length; i < count; i++) {
+        this._registerLight(this.globalLightIndex++, type, i);
+      }
+      if (this.mirrorLights) {
+        const lights = this._readLights(type);
+        if (type === 'spot') this.spotLights = lights;
+        else if (type === 'rect') this.rectLights = lights;
+        else this.pointLights = lights;
+      }
+    });
+
+    this.hasAnimatedLights = exports.getHasAnimatedLights() > 0;
+    this._lightsChanged();
+    return true;
+  }
+
+  // ──────────────────────────────────────────────────────────────
+  //                   VISIBILITY TRACKING
+  // ──────────────────────────────────────────────────────────────
+  // Packed visibility bitset for one light type: bit i is set when light i
+  // (type index) was rendered by the last update - visible, not culled and
+  // above LOD_SKIP. Returns null when the loaded WASM build predates it.
+  getVisibilityBitset(type = 'point') {
+    const exports = this.wasm.exports;
+    if (!exports.getPointVisibilityBits) return null;
+
+    const ptr = type === 'spot' ? exports.getSpotVisibilityBits() :
+                type === 'rect' ? exports.getRectVisibilityBits() :
+                exports.getPointVisibilityBits();
+    const count = type === 'spot' ? this.spotLightCount :
+                  type === 'rect' ? this.rectLightCount :
+                  this.pointLightCount;
+
+    // Fresh view each call - the buffer is replaced when WASM memory grows
+    return new Uint32Array(exports.memory.buffer, ptr, Math.ceil(count / 32));
+  }
+
+  // Lights whose visibility or LOD changed during the last update().
+  // Cost is O(changes): the core only records lights whose state flipped.
+  getVisibilityChanges() {
+    const exports = this.wasm.exports;
+    if (!exports.getVisibilityChanges) return [];
+
+    const count = exports.getVisibilityChangeCount();
+    if (count === 0) return [];
+
+    // 8 bytes per event: uint32 index, uint8 type, uint8 state, uint8 prevState, pad
+    const words = new Uint32Array(exports.memory.buffer, exports.getVisibilityChanges(), count * 2);
+    const typeNames = ['point', 'spot', 'rect'];
+    const changes = new Array(count);
+
+    for (let i = 0; i < count; i++) {
+      const packed = words[i * 2 + 1];
+      const state = (packed >>> 8) & 0xFF;
+      const prevState = (packed >>> 16) & 0xFF;
+      changes[i] = {
+        type: typeNames[packed & 0xFF],
+        typeIndex: words[i * 2],
+        visible: (state & 0x4) !== 0,
+        lod: state & 0x3,
+        wasVisible: (prevState & 0x4) !== 0,
+        previousLOD: prevState & 0x3
+      };
+    }
+
+    return changes;
+  }
+
+  // Whether a light was rendered by the last update (bitset lookup)
+  isLightRendered(globalIndex) {
+    const mapping = this.lightTypeMap.get(globalIndex);
+    if (!mapping) return false;
+
+    const bits = this.getVisibilityBitset(mapping.type);
+    if (!bits) return this.getLightLOD(globalIndex) > 0;
+
+    const i = mapping.typeIndex;
+    return (bits[i >>> 5] & (1 << (i & 31))) !== 0;
+  }
+
+  // Ascending type indices of the lights rendered by the last update, compacted
+  // by the core from the visibility bitset. The view aliases WASM memory and is
+  // only valid until the next update(). Returns null on older WASM builds.
+  getVisibleLightIndices(type = 'point') {
+    const exports = this.wasm.exports;
+    if (!exports.buildVisibleLightList) return null;
+
+    const typeId = type === 'spot' ? 1 : type === 'rect' ? 2 : 0;
+    const count = exports.buildVisibleLightList(typeId);
+    return new Uint32Array(exports.memory.buffer, exports.getVisibleLightList(typeId), count);
+  }
+
   config(lights, shuffle) {
     this.clearLights();
 
@@ -1611,7 +2699,7 @@ export class ClusterLightingSystem {
     });
 
     if (!shuffle) {
-      this.wasm.exports.sort();
+      this._sortLights();
     }
 
     this.updateLightCounts();
@@ -1658,7 +2746,7 @@ export class ClusterLightingSystem {
         );
 
         if (index >= 0) {
-          this.pointLights.push({
+          if (this.mirrorLights) this.pointLights.push({
             position: light.position.clone(),
             color: light.color.clone(),
             intensity: light.intensity || 1,
@@ -1667,10 +2755,7 @@ export class ClusterLightingSystem {
             animation: light.animation
           });
 
-          this.lightTypeMap.set(this.globalLightIndex++, {
-            type: 'point',
-            typeIndex: index
-          });
+          this._registerLight(this.globalLightIndex++, 'point', index);
         }
       }
 
@@ -1683,7 +2768,7 @@ export class ClusterLightingSystem {
     }
 
     // Track starting index for appending
-    const startIndex = append ? this.pointLights.length : 0;
+    const startIndex = append ? this.wasm.exports.getPointLightCount() : 0;
 
     // Create temporary JS typed arrays
     const positions = new Float32Array(count * 4);
@@ -1756,7 +2841,7 @@ export class ClusterLightingSystem {
       animFlags[i] = flags;
 
       // Track in JS arrays
-      this.pointLights.push({
+      if (this.mirrorLights) this.pointLights.push({
         position: light.position.clone(),
         color: light.color.clone(),
         intensity: light.intensity || 1,
@@ -1766,10 +2851,7 @@ export class ClusterLightingSystem {
       });
 
       // Map global index (use proper index when appending)
-      this.lightTypeMap.set(this.globalLightIndex++, {
-        type: 'point',
-        typeIndex: startIndex + i
-      });
+      this._registerLight(this.globalLightIndex++, 'point', startIndex + i);
     }
 
     // Copy arrays to WASM memory (use safe offsets with proper alignment)
@@ -1829,7 +2911,7 @@ export class ClusterLightingSystem {
     if (!append) {
       // Only sort if not deferred
       if (!this.deferSorting) {
-        this.wasm.exports.sort();
+        this._sortLights();
       } else {
         this.sortDeferred = true;
       }
@@ -1854,7 +2936,7 @@ export class ClusterLightingSystem {
   finalizeProgressiveLoading() {
     // Sort if needed
     if (this.sortDeferred) {
-      this.wasm.exports.sort();
+      this._sortLights();
       this.sortDeferred = false;
     }
 
@@ -2012,7 +3094,7 @@ export class ClusterLightingSystem {
 
       // Track in JS arrays
       if (light.type === 'spot') {
-        this.spotLights.push({
+        if (this.mirrorLights) this.spotLights.push({
           position: light.position.clone(),
           direction: light.direction.clone(),
           color: light.color.clone(),
@@ -2023,12 +3105,9 @@ export class ClusterLightingSystem {
           penumbra: light.penumbra || 0,
           animation: light.animation
         });
-        this.lightTypeMap.set(this.globalLightIndex++, {
-          type: 'spot',
-          typeIndex: this.spotLights.length - 1
-        });
+        this._registerLight(this.globalLightIndex++, 'spot', spotIdx - 1);
       } else if (light.type === 'rect') {
-        this.rectLights.push({
+        if (this.mirrorLights) this.rectLights.push({
           position: light.position.clone(),
           color: light.color.clone(),
           intensity: light.intensity || 1,
@@ -2039,12 +3118,9 @@ export class ClusterLightingSystem {
           normal: light.normal.clone(),
           animation: light.animation
         });
-        this.lightTypeMap.set(this.globalLightIndex++, {
-          type: 'rect',
-          typeIndex: this.rectLights.length - 1
-        });
+        this._registerLight(this.globalLightIndex++, 'rect', rectIdx - 1);
       } else {
-        this.pointLights.push({
+        if (this.mirrorLights) this.pointLights.push({
           position: light.position.clone(),
           color: light.color.clone(),
           intensity: light.intensity || 1,
@@ -2052,10 +3128,7 @@ export class ClusterLightingSystem {
           decay: light.decay || 2,
           animation: light.animation
         });
-        this.lightTypeMap.set(this.globalLightIndex++, {
-          type: 'point',
-          typeIndex: this.pointLights.length - 1
-        });
+        this._registerLight(this.globalLightIndex++, 'point', i - spotIdx - rectIdx);
       }
     }
 
@@ -2096,7 +3169,7 @@ export class ClusterLightingSystem {
     );
 
     if (!shuffle) {
-      this.wasm.exports.sort();
+      this._sortLights();
     }
 
     this.updateLightCounts();
@@ -2137,14 +3210,17 @@ export class ClusterLightingSystem {
     }
     this.cameraMatrix.set(camera.matrixWorldInverse.elements);
 
+    // Changes coalesced since the last frame (autoBatch)
+    if (this._pendingRefresh && this._batchDepth === 0) this._flushRefresh();
+
     // PERFORMANCE: Skip sorting when lights are animated
     // Morton ordering is only useful for static lights - with animated lights constantly moving,
     // the Morton order becomes stale immediately after sorting, making it pointless CPU overhead
     // Only sort once at initialization or when lights are added/removed
     // Also skip sorting if we have very few lights (no benefit, causes index corruption)
-    const totalLights = this.pointLightCount + this.spotLightCount + this.rectLightCount;
+    const totalLights = this.pointLightCount + this.staticPointLightCount + this.spotLightCount + this.rectLightCount;
     if (this.sortDeferred && !this.hasAnimatedLights && totalLights > 2) {
-      this.wasm.exports.sort();
+      this._sortLights();
       this.sortDeferred = false;
     }
 
@@ -2153,6 +3229,11 @@ export class ClusterLightingSystem {
     this.hasAnimatedLights = this.wasm.exports.update(time) > 0;
     const wasmEnd = performance.now();
 
+    // Queued commands may have moved lights
+    if (this._lightCommandQueue && this.wasm.exports.getLightCommandsApplied() > 0) {
+      this.clusterDirtyFlags.lightPositionsChanged = true;
+    }
+
     // Track WASM CPU time
     this.wasmTimeValue += (wasmEnd - wasmStart);
     this.wasmTimeCount++;
@@ -2167,63 +3248,13 @@ export class ClusterLightingSystem {
       this.wasmTimeValue = 0;
     }
     
-    // Update texture data from WASM memory
-    if (this.pointLightTexture.value && this.pointLightTextureData) {
-      const pointCount = this.wasm.exports.getPointLightCount();
-      if (pointCount > 0) {
-        const actualFloats = pointCount * 2 * 4;
-        const wasmDataPtr = this.wasm.exports.getPointLightTexture();
-
-        if (wasmDataPtr % 4 !== 0) {
-          console.error(`[ClusterLightingSystem] WASM pointer not aligned: ${wasmDataPtr}`);
-        } else {
-          // Check if we're using zero-copy mode
-          const usingZeroCopy = this.pointLightTextureData.buffer === this.wasm.exports.memory.buffer;
-
-          if (!usingZeroCopy) {
-            // COPY MODE: Need to copy WASM data to texture buffer
-            const wasmData = new Float32Array(
-              this.wasm.exports.memory.buffer,
-              wasmDataPtr,
-              actualFloats
-            );
-            this.pointLightTextureData.set(wasmData);
-
-            // Debug logging
-            if (!this._loggedUpdate && pointCount > 0) {
-              this._loggedUpdate = true;
-            }
-          } else {
-            // ZERO-COPY MODE: Texture already references WASM memory
-            // No copy needed! Just mark as needing GPU upload
-
-            // Debug logging
-            if (!this._loggedUpdate && pointCount > 0) {
-              this._loggedUpdate = true;
-            }
-          }
-        }
-      }
-      // Always mark texture for GPU upload since view-space positions change every frame
-      // when the camera moves, regardless of whether lights are animated
-      if (pointCount > 0) {
-        this.pointLightTexture.value.needsUpdate = true;
-      }
-    }
-
-    // Always update spot/rect textures since view-space positions change with camera movement
-    if (this.spotLightTexture.value && this.spotLights.length > 0) {
-      this.spotLightTexture.value.needsUpdate = true;
-    }
-    if (this.rectLightTexture.value && this.rectLights.length > 0) {
-      this.rectLightTexture.value.needsUpdate = true;
-    }
-
+    // Upload light data every frame: view-space positions change with the
+    // camera even when no light is animated
+    this.updateLightTextures();
 
     this.updateProxyGeometry();
 
-    const totalCount = this.pointLights.length + this.spotLights.length + this.rectLights.length;
-    if (totalCount > 0) {
+    if (totalLights > 0) {
       this.renderTiles(time);
     }
   }
@@ -2329,100 +3360,71 @@ export class ClusterLightingSystem {
     }
   }
 
-  getListTarget() {
-    const tp = this.sliceParams.value;
-    const requiredHeight = tp.y * this.batchCount.value;
-    
-    // Check if we need to recreate due to size change
-    if (this.listTarget && this.listTarget.height !== requiredHeight) {
-      this.listTarget.dispose();
-      this.listTarget = null;
+  // Render targets only grow, and are allocated with headroom: the batch
+  // dimension rounds up to a power of two, and master targets are always
+  // R32UI (enough for any batch count). Light-count changes that cross a
+  // 32-light batch then reuse the allocation. Each pass renders into the
+  // target's (0, 0, width, height) viewport; the shaders address texels
+  // from sliceParams, never from the texture size. Headroom never goes past
+  // maxTextureSize, but the exact size always wins.
+  _pooledTarget(key, width, height, allocWidth, allocHeight, options) {
+    let target = this[key];
+    if (target && (target.width < width || target.height < height)) {
+      allocWidth = Math.max(allocWidth, target.width);
+      allocHeight = Math.max(allocHeight, target.height);
+      target.dispose();
+      target = this[key] = null;
     }
-    
-    if (!this.listTarget) {
-      this.listTarget = new WebGLRenderTarget(tp.x * tp.z, requiredHeight, {
-        format: RGBAFormat,
-        type: UnsignedByteType,
+
+    const maxSize = this.renderer.capabilities.maxTextureSize;
+    allocWidth = Math.max(width, Math.min(allocWidth, maxSize));
+    allocHeight = Math.max(height, Math.min(allocHeight, maxSize));
+
+    if (!target) {
+      target = this[key] = new WebGLRenderTarget(allocWidth, allocHeight, {
         depthBuffer: false,
         stencilBuffer: false,
         minFilter: NearestFilter,
         magFilter: NearestFilter,
         generateMipmaps: false,
-        samples: 0
+        samples: 0,
+        ...options
       });
     }
-    return this.listTarget;
+    target.viewport.set(0, 0, width, height);
+    return target;
   }
 
-  getMasterTarget() {
-    const tw = this.batchCount.value;
+  getListTarget() {
     const tp = this.sliceParams.value;
-    const requiredHeight = tp.y * tp.w;
-
-    // Determine the required type based on batch count
-    const requiredType = tw > 16 ? UnsignedIntType : (tw > 8 ? UnsignedShortType : UnsignedByteType);
-
-    // Check if we need to recreate due to size or type change
-
-    // Check if we need to recreate due to size or type change
-    if (this.masterTarget &&
-      (this.masterTarget.height !== requiredHeight ||
-       this.masterTarget.texture.type !== requiredType)) {
-    this.masterTarget.dispose();
-    this.masterTarget = null;
-  }
-
-  if (!this.masterTarget) {
-    this.masterTarget = new WebGLRenderTarget(tp.x * tp.z, requiredHeight, {
-      format: RedIntegerFormat,
-      type: requiredType,
-      depthBuffer: false,
-      stencilBuffer: false,
-      minFilter: NearestFilter,
-      magFilter: NearestFilter,
-      generateMipmaps: false,
-      samples: 0,
-      internalFormat: tw > 16 ? "R32UI" : (tw > 8 ? "R16UI" : "R8UI")
-    });
+    const batches = this.batchCount.value;
+    return this._pooledTarget('listTarget', tp.x * tp.z, tp.y * batches,
+      tp.x * tp.z, tp.y * MathUtils.ceilPowerOfTwo(Math.max(1, batches)), {
+        format: RGBAFormat,
+        type: UnsignedByteType
+      });
   }
-  return this.masterTarget;
-}
 
-getSuperMasterTarget() {
-  const tp = this.sliceParams.value;
-  const w = Math.ceil((tp.x * tp.z) / 8);
-  const h = Math.ceil((tp.y * tp.w) / 8);
-  
-  // Determine required type based on batch count (same logic as master target)
-  const tw = this.batchCount.value;
-  const requiredType = tw > 16 ? UnsignedIntType : (tw > 8 ? UnsignedShortType : UnsignedByteType);
-  
-  // Check if we need to recreate due to size or type change
-  if (this.superMasterTarget &&
-      (this.superMasterTarget.width !== w || 
-       this.superMasterTarget.height !== h ||
-       this.superMasterTarget.texture.type !== requiredType)) {
-    this.superMasterTarget.dispose();
-    this.superMasterTarget = null;
+  getMasterTarget() {
+    const tp = this.sliceParams.value;
+    return this._pooledTarget('masterTarget', tp.x * tp.z, tp.y * tp.w,
+      tp.x * tp.z, tp.y * MathUtils.ceilPowerOfTwo(Math.max(1, tp.w)), {
+        format: RedIntegerFormat,
+        type: UnsignedIntType,
+        internalFormat: "R32UI"
+      });
   }
-  
-  if (!this.superMasterTarget) {
-    const params = {
-      depthBuffer: false,
-      stencilBuffer: false,
-      minFilter: NearestFilter,
-      magFilter: NearestFilter,
-      generateMipmaps: false,
-      samples: 0,
-      format: RedIntegerFormat,
-      type: requiredType,
-      internalFormat: tw > 16 ? "R32UI" : (tw > 8 ? "R16UI" : "R8UI")
-    };
-    this.superMasterTarget = new WebGLRenderTarget(w, h, params);
+
+  getSuperMasterTarget() {
+    const tp = this.sliceParams.value;
+    const w = Math.ceil((tp.x * tp.z) / 8);
+    return this._pooledTarget('superMasterTarget', w, Math.ceil((tp.y * tp.w) / 8),
+      w, Math.ceil((tp.y * MathUtils.ceilPowerOfTwo(Math.max(1, tp.w))) / 8), {
+        format: RedIntegerFormat,
+        type: UnsignedIntType,
+        internalFormat: "R32UI"
+      });
   }
-  
-  return this.superMasterTarget;
-}
 
 
 dispose() {
@@ -1,20 +1,73 @@
 // glsl.js - Complete file with shader variant system
 import { ShaderChunk, AdditiveBlending, RawShaderMaterial, CustomBlending, OneFactor, ZeroFactor, NoBlending } from "three";
 
+// Unit vector the core packed as octahedral u << 12 | v (an exact float).
+// Shared with the light marker shaders.
+export const cluster_oct_decode = `//glsl
+    vec3 clusterOctDecode(float packed) {
+        uint bits = uint(packed);
+        vec2 e = vec2(float(bits >> 12u), float(bits & 4095u)) * (2.0 / 4095.0) - 1.0;
+        vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+        float t = max(-v.z, 0.0);
+        v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+        return normalize(v);
+    }
+`;
+
 export const lights_physical_pars_fragment = `//glsl
 
     uniform vec4 clusterParams;
     uniform ivec4 sliceParams;
+    #ifdef CLUSTER_UNIFIED_LIGHTS
+    // Every light type in one texture; spot and rect records start on their own rows
+    uniform sampler2D lightTexture;
+    uniform ivec2 lightRowBases; // First row of spot (x) and rect (y) records
+    #define pointLightTexture lightTexture
+    #define spotLightTexture lightTexture
+    #define rectLightTexture lightTexture
+    #define CLUSTER_SPOT_ROW lightRowBases.x
+    #define CLUSTER_RECT_ROW lightRowBases.y
+    #else
     uniform sampler2D pointLightTexture;
     uniform sampler2D spotLightTexture;
     uniform sampler2D rectLightTexture;
+    #define CLUSTER_SPOT_ROW 0
+    #define CLUSTER_RECT_ROW 0
+    #endif
     uniform vec3 lightCounts; // x=point, y=spot, z=rect
+    uniform ivec2 lightBatchBases; // First 32-light batch of spot (x) and rect (y) lights
     uniform sampler2D listTexture;
     uniform usampler2D masterTexture;
     #ifdef USE_SUPER_MASTER
     uniform usampler2D superMasterTexture;
     #endif
-    uniform int pointLightTextureWidth; // 2D texture layout width
+    uniform int pointLightRowShift; // Lights per texture row = 1 << shift
+    uniform int spotLightRowShift;
+    uniform int rectLightRowShift;
+    uniform uint lightLayerMask; // Light layers this material receives (bit n = layer n)
+
+    // Packed light word, an exact integer stored in a float:
+    // bits 0-1 = LOD, bit 2 = visible, bits 3-10 = light layers, bits 11-23 = decay * 64
+    bool clusterLightReceived(uint bits) {
+        // Visible, above LOD skip and on a layer this material receives
+        return (bits & 4u) != 0u && (bits & 3u) != 0u && ((bits >> 3u) & lightLayerMask) != 0u;
+    }
+
+    float clusterLightLOD(uint bits) { return float(bits & 3u); }
+
+    // getDistanceAttenuation with the cutoff reciprocal supplied by the caller:
+    // every record carries it precomputed (position texel w)
+    float clusterDistanceAttenuation(float lightDistance, float invCutoff, float decay) {
+        float falloff = 1.0 / max(pow(lightDistance, decay), 0.01);
+        return falloff * pow2(saturate(1.0 - pow4(lightDistance * invCutoff)));
+    }
+
+${cluster_oct_decode}
+    // First texel of light index in a texture of 2^shift records per row
+    // (records never straddle rows), in a region starting at the given row
+    ivec2 clusterLightTexel(int index, int shift, int texels, int row) {
+        return ivec2((index & ((1 << shift) - 1)) * texels, row + (index >> shift));
+    }
 
 `;
 
@@ -26,10 +79,6 @@ export const lights_fragment_begin = `//glsl
 
     txy.x = txy.x * sliceParams.z + slice;
 
-    // Precompute texture sampling constants (avoid per-light recalculation)
-    float width = float(pointLightTextureWidth);
-    float widthInv = 1.0 / width;
-
     #ifdef USE_SUPER_MASTER
     // Hierarchical early-out: skip empty 8x8 super-tiles
     int superX = txy.x >> 3; // /8
@@ -56,6 +105,11 @@ export const lights_fragment_begin = `//glsl
 
                 int lightIndex = 32 * clusterIndex;
 
+                // Each type starts on a 32-light batch boundary, so the whole
+                // batch shares one light type: resolve it once, not per bit
+                int lightType = clusterIndex < lightBatchBases.x ? 0 : (clusterIndex < lightBatchBases.y ? 1 : 2);
+                int typeBase = lightType == 0 ? 0 : 32 * (lightType == 1 ? lightBatchBases.x : lightBatchBases.y);
+
                 uvec4 utexel = uvec4(texel * 255.);
 
                 for(int lmax = lightIndex + 32; lightIndex < lmax; lightIndex += 8){
@@ -68,58 +122,26 @@ export const lights_fragment_begin = `//glsl
 
                         if ( ( value & 1u ) == 1u ){
                             
-                            int globalLightIndex = lightIndex + j;
+                            // Padding slots are never assigned, so no bounds check
+                            int typeIndex = lightIndex + j - typeBase;
                             
-                            // Determine which light type and index within that type
-                            int lightType = 0;
-                            int typeIndex = globalLightIndex;
-                            
-                            if (globalLightIndex < int(lightCounts.x)) {
-                                // Point light
-                                lightType = 0;
-                                typeIndex = globalLightIndex;
-                            } else if (globalLightIndex < int(lightCounts.x + lightCounts.y)) {
-                                // Spot light
-                                lightType = 1;
-                                typeIndex = globalLightIndex - int(lightCounts.x);
-                            } else {
-                                // Rect light
-                                lightType = 2;
-                                typeIndex = globalLightIndex - int(lightCounts.x + lightCounts.y);
-                            }
-                            
-                            if (lightType == 0 && typeIndex < int(lightCounts.x)) {
-                                // Point light - optimized with 2 texels
-                                // 2D texture sampling - use precomputed widthInv to avoid divisions
-                                float typeIdx = float(typeIndex);
-                                float baseTexel = typeIdx * 2.0;
-                                float rowF = floor(baseTexel * widthInv);
-                                int row = int(rowF);
-                                int col = int(baseTexel - rowF * width);
-                                ivec2 posCoord = ivec2(col, row);
-
-                                float nextTexel = baseTexel + 1.0;
-                                float nextRowF = floor(nextTexel * widthInv);
-                                int nextRow = int(nextRowF);
-                                int nextCol = int(nextTexel - nextRowF * width);
-                                ivec2 colorCoord = ivec2(nextCol, nextRow);
-
-                                vec4 posRadius = texelFetch(pointLightTexture, posCoord, 0);
-                                vec4 colorDecayVisible = texelFetch(pointLightTexture, colorCoord, 0);
-                                
-                                // Extract packed parameters
-                                float packedValue = colorDecayVisible.w;
-                                float decay = floor(packedValue * 0.01) * 0.1;
-                                float visible = mod(floor(packedValue * 0.1), 2.0);
-                                float lod = mod(packedValue, 10.0);
+                            if (lightType == 0) {
+                                // Point light - 3 texels
+                                ivec2 posCoord = clusterLightTexel(typeIndex, pointLightRowShift, 3, 0);
+                                vec4 colorDecayVisible = texelFetch(pointLightTexture, posCoord + ivec2(1, 0), 0);
+
+                                // Visibility, LOD skip and light layers before any lighting work
+                                uint lightBits = uint(colorDecayVisible.w);
+                                if (!clusterLightReceived(lightBits)) continue;
+                                float decay = texelFetch(pointLightTexture, posCoord + ivec2(2, 0), 0).x;
+                                float lod = clusterLightLOD(lightBits);
+
+                                vec4 posInvRadius = texelFetch(pointLightTexture, posCoord, 0);
                                 
-                                // Check visibility and LOD skip
-                                if (visible < 0.5 || lod < 0.5) continue;
-                                
-                                vec3 lVector = posRadius.xyz - geometryPosition;
+                                vec3 lVector = posInvRadius.xyz - geometryPosition;
                                 float lightDistance = length( lVector );
                                 
-                                if( lightDistance < posRadius.w ) {
+                                if( lightDistance * posInvRadius.w < 1.0 ) {
                                     directLight.direction = lVector / lightDistance; // Reuse length instead of calling normalize()
 
                                     // LOD-based quality
@@ -133,7 +155,7 @@ export const lights_fragment_begin = `//glsl
                                         reflectedLight.directDiffuse += dotNL * directLight.color * BRDF_Lambert( material.diffuseColor );
                                     } else if (lod < 2.5) {
                                         // LOD 2: Medium quality - diffuse only
-                                        directLight.color = colorDecayVisible.rgb * getDistanceAttenuation( lightDistance, posRadius.w, decay );
+                                        directLight.color = colorDecayVisible.rgb * clusterDistanceAttenuation( lightDistance, posInvRadius.w, decay );
 
                                         float dotNL = saturate( dot( geometryNormal, directLight.direction ) );
                                         reflectedLight.directDiffuse += dotNL * directLight.color * BRDF_Lambert( material.diffuseColor );
@@ -146,35 +168,35 @@ export const lights_fragment_begin = `//glsl
                                         reflectedLight.directSpecular += directLight.color * F * pow(dotNH, shininess) * dotNL;
                                     } else {
                                         // LOD 3: Full quality
-                                        directLight.color = colorDecayVisible.rgb * getDistanceAttenuation( lightDistance, posRadius.w, decay );
+                                        directLight.color = colorDecayVisible.rgb * clusterDistanceAttenuation( lightDistance, posInvRadius.w, decay );
                                         RE_Direct( directLight, geometryPosition, geometryNormal, geometryViewDir, geometryClearcoatNormal, material, reflectedLight );
                                     }
                                 }
                                 
-                            } else if (lightType == 1 && typeIndex < int(lightCounts.y)) {
+                            } else if (lightType == 1) {
                                 // Spot light
-                                vec4 posRadius = texelFetch(spotLightTexture, ivec2(typeIndex * 4, 0), 0);
-                                vec4 colorIntensity = texelFetch(spotLightTexture, ivec2(typeIndex * 4 + 1, 0), 0);
-                                vec4 direction = texelFetch(spotLightTexture, ivec2(typeIndex * 4 + 2, 0), 0);
-                                vec4 angleParams = texelFetch(spotLightTexture, ivec2(typeIndex * 4 + 3, 0), 0);
-                                
-                                // Extract visibility and LOD
-                                float packedValue = angleParams.w;
-                                float visible = floor(packedValue * 0.1);
-                                float lod = mod(packedValue, 10.0);
-                                
-                                // Check visibility and LOD skip
-                                if (visible < 0.5 || lod < 0.5) continue;
+                                ivec2 spotCoord = clusterLightTexel(typeIndex, spotLightRowShift, 3, CLUSTER_SPOT_ROW);
+                                vec4 angleParams = texelFetch(spotLightTexture, spotCoord + ivec2(2, 0), 0);
+
+                                // Visibility, LOD skip and light layers before any lighting work
+                                uint lightBits = uint(angleParams.w);
+                                if (!clusterLightReceived(lightBits)) continue;
+                                float lod = clusterLightLOD(lightBits);
+
+                                vec4 posInvRadius = texelFetch(spotLightTexture, spotCoord, 0);
+                                vec4 colorDecay = texelFetch(spotLightTexture, spotCoord + ivec2(1, 0), 0);
+                                float decay = colorDecay.w;
+                                vec3 spotDirection = clusterOctDecode(angleParams.z);
                                 
-                                vec3 lVector = posRadius.xyz - geometryPosition;
+                                vec3 lVector = posInvRadius.xyz - geometryPosition;
                                 float distSq = dot(lVector, lVector);
-                                float radiusSq = posRadius.w * posRadius.w;
+                                float invRadiusSq = posInvRadius.w * posInvRadius.w;
                                 
-                                if( distSq < radiusSq ) {
+                                if( distSq * invRadiusSq < 1.0 ) {
                                     float lightDistance = sqrt(distSq);
                                     directLight.direction = lVector / lightDistance;
 
-                                    float angleCos = dot( directLight.direction, direction.xyz );
+                                    float angleCos = dot( directLight.direction, spotDirection );
                                     float spotEffect = smoothstep( angleParams.x, angleParams.y, angleCos );
 
                                     if (spotEffect > 0.0) {
@@ -182,14 +204,14 @@ export const lights_fragment_begin = `//glsl
                                         // LOD-based quality
                                         if (lod < 1.5) {
                                             // LOD 1: Simple
-                                            float attenuation = spotEffect / (1.0 + angleParams.z * lightDistance);
-                                            directLight.color = colorIntensity.rgb * colorIntensity.w * attenuation;
+                                            float attenuation = spotEffect / (1.0 + decay * lightDistance);
+                                            directLight.color = colorDecay.rgb * attenuation;
 
                                             float dotNL = saturate( dot( geometryNormal, directLight.direction ) );
                                             reflectedLight.directDiffuse += dotNL * directLight.color * BRDF_Lambert( material.diffuseColor );
                                         } else if (lod < 2.5) {
                                             // LOD 2: Medium
-                                            directLight.color = colorIntensity.rgb * colorIntensity.w * spotEffect * getDistanceAttenuation( lightDistance, posRadius.w, angleParams.z );
+                                            directLight.color = colorDecay.rgb * spotEffect * clusterDistanceAttenuation( lightDistance, posInvRadius.w, decay );
 
                                             float dotNL = saturate( dot( geometryNormal, directLight.direction ) );
                                             reflectedLight.directDiffuse += dotNL * directLight.color * BRDF_Lambert( material.diffuseColor );
@@ -201,34 +223,34 @@ export const lights_fragment_begin = `//glsl
                                             reflectedLight.directSpecular += directLight.color * F * pow(dotNH, shininess) * dotNL;
                                         } else {
                                             // LOD 3: Full
-                                            directLight.color = colorIntensity.rgb * colorIntensity.w * spotEffect * getDistanceAttenuation( lightDistance, posRadius.w, angleParams.z );
+                                            directLight.color = colorDecay.rgb * spotEffect * clusterDistanceAttenuation( lightDistance, posInvRadius.w, decay );
                                             RE_Direct( directLight, geometryPosition, geometryNormal, geometryViewDir, geometryClearcoatNormal, material, reflectedLight );
                                         }
                                     }
                                 }
                                 
-                            } else if (lightType == 2 && typeIndex < int(lightCounts.z)) {
+                            } else {
                                 // Rect light
-                                vec4 posRadius = texelFetch(rectLightTexture, ivec2(typeIndex * 5, 0), 0);
-                                vec4 colorIntensity = texelFetch(rectLightTexture, ivec2(typeIndex * 5 + 1, 0), 0);
-                                vec4 sizeParams = texelFetch(rectLightTexture, ivec2(typeIndex * 5 + 2, 0), 0);
-                                vec4 lightNormal = texelFetch(rectLightTexture, ivec2(typeIndex * 5 + 3, 0), 0);
-                                vec4 lightTangent = texelFetch(rectLightTexture, ivec2(typeIndex * 5 + 4, 0), 0);
-                                
-                                // Extract visibility and LOD
-                                float packedValue = sizeParams.w;
-                                float visible = floor(packedValue * 0.1);
-                                float lod = mod(packedValue, 10.0);
-                                
-                                // Check visibility and LOD skip
-                                if (visible < 0.5 || lod < 0.5) continue;
+                                ivec2 rectCoord = clusterLightTexel(typeIndex, rectLightRowShift, 4, CLUSTER_RECT_ROW);
+                                vec4 sizeParams = texelFetch(rectLightTexture, rectCoord + ivec2(2, 0), 0);
+
+                                // Visibility, LOD skip and light layers before any lighting work
+                                uint lightBits = uint(sizeParams.w);
+                                if (!clusterLightReceived(lightBits)) continue;
+                                float lod = clusterLightLOD(lightBits);
+
+                                vec4 posInvRadius = texelFetch(rectLightTexture, rectCoord, 0);
+                                vec4 colorTangent = texelFetch(rectLightTexture, rectCoord + ivec2(1, 0), 0);
+                                vec3 lightNormal = clusterOctDecode(sizeParams.z);
+                                vec3 lightTangent = clusterOctDecode(colorTangent.w);
+                                float decayRate = texelFetch(rectLightTexture, rectCoord + ivec2(3, 0), 0).x;
                                 
-                                vec3 lightPos = posRadius.xyz;
+                                vec3 lightPos = posInvRadius.xyz;
                                 vec3 L = lightPos - geometryPosition;
                                 float distSq = dot(L, L);
-                                float radiusSq = posRadius.w * posRadius.w;
+                                float invRadiusSq = posInvRadius.w * posInvRadius.w;
                                 
-                                if( distSq < radiusSq ) {
+                                if( distSq * invRadiusSq < 1.0 ) {
                                     float distToLight = sqrt(distSq);
                                     L = L / distToLight;
                                     
@@ -238,11 +260,10 @@ export const lights_fragment_begin = `//glsl
                                         // LOD-based quality
                                         if (lod < 1.5) {
                                             // LOD 1: Simple point approximation
-                                            float area = sizeParams.x * sizeParams.y;
-                                            float attenuation = area / (distToLight * distToLight * (1.0 + sizeParams.z * distToLight * 0.1));
+                                            float attenuation = 1.0 / (distToLight * distToLight * (1.0 + decayRate * distToLight));
 
                                             directLight.direction = L;
-                                            directLight.color = colorIntensity.rgb * colorIntensity.w * attenuation * NdotL;
+                                            directLight.color = colorTangent.rgb * attenuation * NdotL;
 
                                             reflectedLight.directDiffuse += directLight.color * BRDF_Lambert( material.diffuseColor );
                                         } else {
@@ -280,18 +301,17 @@ export const lights_fragment_begin = `//glsl
                                                 falloff = 1.0 / (1.0 + falloffDist * falloffDist * 0.5);
                                             }
                                             
-                                            // Area-based intensity
-                                            float area = sizeParams.x * sizeParams.y;
-                                            float rectDistAttenuation = (area * falloff) / (distToLight * distToLight);
+                                            // Area-based intensity (the core folds the area into the colour)
+                                            float rectDistAttenuation = falloff / (distToLight * distToLight);
                                             
                                             // Apply decay
-                                            rectDistAttenuation *= 1.0 / (1.0 + sizeParams.z * distToLight * 0.1);
+                                            rectDistAttenuation *= 1.0 / (1.0 + decayRate * distToLight);
                                             
                                             // Emission angle falloff
                                             rectDistAttenuation *= cosTheta * 10.0;
 
                                             directLight.direction = L;
-                                            directLight.color = colorIntensity.rgb * colorIntensity.w * rectDistAttenuation * NdotL;
+                                            directLight.color = colorTangent.rgb * rectDistAttenuation * NdotL;
 
                                             if (lod < 2.5) {
                                                 // LOD 2: Simplified
@@ -330,10 +350,6 @@ export const lights_fragment_begin_optimized = `//glsl
     // Early exit for fragments too close or too far
     if(slice < 0 || slice >= sliceParams.z) return;
 
-    // Precompute texture sampling constants (avoid per-light recalculation)
-    float width = float(pointLightTextureWidth);
-    float widthInv = 1.0 / width;
-
     #ifdef USE_SUPER_MASTER
     int superX = txy.x >> 3; // /8
     #endif
@@ -354,7 +370,8 @@ export const lights_fragment_begin_optimized = `//glsl
             int clusterIndex = 32 * i;
 
             for(; master != 0u ; ){
-                if( ( master & 1u ) == 1u ) {
+                // Point batches only: types never share a 32-light batch
+                if( ( master & 1u ) == 1u && clusterIndex < lightBatchBases.x ) {
                     vec4 texel = texelFetch(listTexture, ivec2(txy.x, txy.y + sliceParams.y * clusterIndex), 0);
                     int lightIndex = 32 * clusterIndex;
                     uvec4 utexel = uvec4(texel * 255.);
@@ -367,53 +384,36 @@ export const lights_fragment_begin_optimized = `//glsl
                             if ( ( value & 1u ) == 1u ){
                                 int globalLightIndex = lightIndex + j;
                                 
-                                if (globalLightIndex < int(lightCounts.x)) {
-                                    // 2D texture sampling - use precomputed widthInv to avoid divisions
-                                    float lightIdx = float(globalLightIndex);
-                                    float baseTexel = lightIdx * 2.0;
-                                    float rowF = floor(baseTexel * widthInv);
-                                    int row = int(rowF);
-                                    int col = int(baseTexel - rowF * width);
-                                    ivec2 posCoord = ivec2(col, row);
-
-                                    float nextTexel = baseTexel + 1.0;
-                                    float nextRowF = floor(nextTexel * widthInv);
-                                    int nextRow = int(nextRowF);
-                                    int nextCol = int(nextTexel - nextRowF * width);
-                                    ivec2 colorCoord = ivec2(nextCol, nextRow);
-
-                                    vec4 posRadius = texelFetch(pointLightTexture, posCoord, 0);
-                                    vec4 colorDecayVisible = texelFetch(pointLightTexture, colorCoord, 0);
-                                    
-                                    // Extract packed parameters
-                                    float packedValue = colorDecayVisible.w;
-                                    float decay = floor(packedValue * 0.01) * 0.1;
-                                    float visible = mod(floor(packedValue * 0.1), 2.0);
-                                    float lod = mod(packedValue, 10.0);
-                                    
-                                    // Check visibility and LOD skip
-                                    if (visible < 0.5 || lod < 0.5) continue;
-                                    
-                                    vec3 lVector = posRadius.xyz - geometryPosition;
-                                    float distSq = dot(lVector, lVector);
-                                    float radiusSq = posRadius.w * posRadius.w;
+                                ivec2 posCoord = clusterLightTexel(globalLightIndex, pointLightRowShift, 3, 0);
+                                vec4 colorDecayVisible = texelFetch(pointLightTexture, posCoord + ivec2(1, 0), 0);
+
+                                // Visibility, LOD skip and light layers before any lighting work
+                                uint lightBits = uint(colorDecayVisible.w);
+                                if (!clusterLightReceived(lightBits)) continue;
+                                float decay = texelFetch(pointLightTexture, posCoord + ivec2(2, 0), 0).x;
+                                float lod = clusterLightLOD(lightBits);
+
+                                vec4 posInvRadius = texelFetch(pointLightTexture, posCoord, 0);
+                                
+                                vec3 lVector = posInvRadius.xyz - geometryPosition;
+                                float distSq = dot(lVector, lVector);
+                                float invRadiusSq = posInvRadius.w * posInvRadius.w;
+                                
+                                if( distSq * invRadiusSq < 1.0 ) {
+                                    float lightDistance = sqrt(distSq);
+                                    directLight.direction = lVector / lightDistance;
                                     
-                                    if( distSq < radiusSq ) {
-                                        float lightDistance = sqrt(distSq);
-                                        directLight.direction = lVector / lightDistance;
-                                        
-                                        // LOD-based quality
-                                        if (lod < 1.5) {
-                                            // Simple
-                                            float attenuation = 1.0 / (1.0 + decay * lightDistance);
-                                            vec3 lightColor = colorDecayVisible.rgb * attenuation;
-                                            float dotNL = saturate( dot( geometryNormal, directLight.direction ) );
-                                            reflectedLight.directDiffuse += dotNL * lightColor * BRDF_Lambert( material.diffuseColor );
-                                        } else {
-                                            // Full
-                                            directLight.color = colorDecayVisible.rgb * getDistanceAttenuation( lightDistance, posRadius.w, decay );
-                                            RE_Direct( directLight, geometryPosition, geometryNormal, geometryViewDir, geometryClearcoatNormal, material, reflectedLight );
-                                        }
+                                    // LOD-based quality
+                                    if (lod < 1.5) {
+                                        // Simple
+                                        float attenuation = 1.0 / (1.0 + decay * lightDistance);
+                                        vec3 lightColor = colorDecayVisible.rgb * attenuation;
+                                        float dotNL = saturate( dot( geometryNormal, directLight.direction ) );
+                                        reflectedLight.directDiffuse += dotNL * lightColor * BRDF_Lambert( material.diffuseColor );
+                                    } else {
+                                        // Full
+                                        directLight.color = colorDecayVisible.rgb * clusterDistanceAttenuation( lightDistance, posInvRadius.w, decay );
+                                        RE_Direct( directLight, geometryPosition, geometryNormal, geometryViewDir, geometryClearcoatNormal, material, reflectedLight );
                                     }
                                 }
                             }
@@ -446,7 +446,8 @@ export const lights_fragment_begin_optimized = `//glsl
             int clusterIndex = 32 * i;
 
             for(; master != 0u ; ){
-                if( ( master & 1u ) == 1u ) {
+                // Spot batches only: types never share a 32-light batch
+                if( ( master & 1u ) == 1u && clusterIndex >= lightBatchBases.x && clusterIndex < lightBatchBases.y ) {
                     vec4 texel = texelFetch(listTexture, ivec2(txy.x, txy.y + sliceParams.y * clusterIndex), 0);
                     int lightIndex = 32 * clusterIndex;
                     uvec4 utexel = uvec4(texel * 255.);
@@ -458,43 +459,41 @@ export const lights_fragment_begin_optimized = `//glsl
                         for( int j = 0; value != 0u; j++, value >>= 1 ) {
                             if ( ( value & 1u ) == 1u ){
                                 int globalLightIndex = lightIndex + j;
-                                int spotIndex = globalLightIndex - int(lightCounts.x);
+                                int spotIndex = globalLightIndex - 32 * lightBatchBases.x;
                                 
-                                if (spotIndex >= 0 && spotIndex < int(lightCounts.y)) {
-                                    vec4 posRadius = texelFetch(spotLightTexture, ivec2(spotIndex * 4, 0), 0);
-                                    vec4 colorIntensity = texelFetch(spotLightTexture, ivec2(spotIndex * 4 + 1, 0), 0);
-                                    vec4 direction = texelFetch(spotLightTexture, ivec2(spotIndex * 4 + 2, 0), 0);
-                                    vec4 angleParams = texelFetch(spotLightTexture, ivec2(spotIndex * 4 + 3, 0), 0);
-                                    
-                                    // Extract visibility and LOD
-                                    float packedValue = angleParams.w;
-                                    float visible = floor(packedValue * 0.1);
-                                    float lod = mod(packedValue, 10.0);
-                                    
-                                    // Check visibility and LOD skip
-                                    if (visible < 0.5 || lod < 0.5) continue;
-                                    
-                                    vec3 lVector = posRadius.xyz - geometryPosition;
-                                    float lightDistance = length( lVector );
+                                ivec2 spotCoord = clusterLightTexel(spotIndex, spotLightRowShift, 3, CLUSTER_SPOT_ROW);
+                                vec4 angleParams = texelFetch(spotLightTexture, spotCoord + ivec2(2, 0), 0);
+
+                                // Visibility, LOD skip and light layers before any lighting work
+                                uint lightBits = uint(angleParams.w);
+                                if (!clusterLightReceived(lightBits)) continue;
+                                float lod = clusterLightLOD(lightBits);
+
+                                vec4 posInvRadius = texelFetch(spotLightTexture, spotCoord, 0);
+                                vec4 colorDecay = texelFetch(spotLightTexture, spotCoord + ivec2(1, 0), 0);
+                                float decay = colorDecay.w;
+                                vec3 spotDirection = clusterOctDecode(angleParams.z);
+                                
+                                vec3 lVector = posInvRadius.xyz - geometryPosition;
+                                float lightDistance = length( lVector );
+                                
+                                if( lightDistance * posInvRadius.w < 1.0 ) {
+                                    directLight.direction = lVector / lightDistance;
+                                    float angleCos = dot( directLight.direction, spotDirection );
                                     
-                                    if( lightDistance < posRadius.w ) {
-                                        directLight.direction = lVector / lightDistance;
-                                        float angleCos = dot( directLight.direction, direction.xyz );
+                                    if (angleCos > angleParams.x) {
+                                        float spotEffect = smoothstep( angleParams.x, angleParams.y, angleCos );
                                         
-                                        if (angleCos > angleParams.x) {
-                                            float spotEffect = smoothstep( angleParams.x, angleParams.y, angleCos );
-                                            
-                                            if (lod < 1.5) {
-                                                // Simple
-                                                float attenuation = spotEffect / (1.0 + angleParams.z * lightDistance);
-                                                vec3 lightColor = colorIntensity.rgb * colorIntensity.w * attenuation;
-                                                float dotNL = saturate( dot( geometryNormal, directLight.direction ) );
-                                                reflectedLight.directDiffuse += dotNL * lightColor * BRDF_Lambert( material.diffuseColor );
-                                            } else {
-                                                // Full
-                                                directLight.color = colorIntensity.rgb * colorIntensity.w * spotEffect * getDistanceAttenuation( lightDistance, posRadius.w, angleParams.z );
-                                                RE_Direct( directLight, geometryPosition, geometryNormal, geometryViewDir, geometryClearcoatNormal, material, reflectedLight );
-                                            }
+                                        if (lod < 1.5) {
+                                            // Simple
+                                            float attenuation = spotEffect / (1.0 + decay * lightDistance);
+                                            vec3 lightColor = colorDecay.rgb * attenuation;
+                                            float dotNL = saturate( dot( geometryNormal, directLight.direction ) );
+                                            reflectedLight.directDiffuse += dotNL * lightColor * BRDF_Lambert( material.diffuseColor );
+                                        } else {
+                                            // Full
+                                            directLight.color = colorDecay.rgb * spotEffect * clusterDistanceAttenuation( lightDistance, posInvRadius.w, decay );
+                                            RE_Direct( directLight, geometryPosition, geometryNormal, geometryViewDir, geometryClearcoatNormal, material, reflectedLight );
                                         }
                                     }
                                 }
@@ -528,7 +527,8 @@ export const lights_fragment_begin_optimized = `//glsl
             int clusterIndex = 32 * i;
 
             for(; master != 0u ; ){
-                if( ( master & 1u ) == 1u ) {
+                // Rect batches only: types never share a 32-light batch
+                if( ( master & 1u ) == 1u && clusterIndex >= lightBatchBases.y ) {
                     vec4 texel = texelFetch(listTexture, ivec2(txy.x, txy.y + sliceParams.y * clusterIndex), 0);
                     int lightIndex = 32 * clusterIndex;
                     uvec4 utexel = uvec4(texel * 255.);
@@ -540,58 +540,54 @@ export const lights_fragment_begin_optimized = `//glsl
                         for( int j = 0; value != 0u; j++, value >>= 1 ) {
                             if ( ( value & 1u ) == 1u ){
                                 int globalLightIndex = lightIndex + j;
-                                int rectIndex = globalLightIndex - int(lightCounts.x + lightCounts.y);
+                                int rectIndex = globalLightIndex - 32 * lightBatchBases.y;
                                 
-                                if (rectIndex >= 0 && rectIndex < int(lightCounts.z)) {
-                                    vec4 posRadius = texelFetch(rectLightTexture, ivec2(rectIndex * 4, 0), 0);
-                                    vec4 colorIntensity = texelFetch(rectLightTexture, ivec2(rectIndex * 4 + 1, 0), 0);
-                                    vec4 sizeParams = texelFetch(rectLightTexture, ivec2(rectIndex * 4 + 2, 0), 0);
-                                    vec4 lightNormal = texelFetch(rectLightTexture, ivec2(rectIndex * 4 + 3, 0), 0);
-                                    
-                                    // Extract visibility and LOD
-                                    float packedValue = sizeParams.w;
-                                    float visible = floor(packedValue * 0.1);
-                                    float lod = mod(packedValue, 10.0);
-                                    
-                                    // Check visibility and LOD skip
-                                    if (visible < 0.5 || lod < 0.5) continue;
-                                    
-                                    vec3 L = posRadius.xyz - geometryPosition;
-                                    float distToLight = length(L);
+                                ivec2 rectCoord = clusterLightTexel(rectIndex, rectLightRowShift, 4, CLUSTER_RECT_ROW);
+                                vec4 sizeParams = texelFetch(rectLightTexture, rectCoord + ivec2(2, 0), 0);
+
+                                // Visibility, LOD skip and light layers before any lighting work
+                                uint lightBits = uint(sizeParams.w);
+                                if (!clusterLightReceived(lightBits)) continue;
+                                float lod = clusterLightLOD(lightBits);
+
+                                vec4 posInvRadius = texelFetch(rectLightTexture, rectCoord, 0);
+                                vec4 colorTangent = texelFetch(rectLightTexture, rectCoord + ivec2(1, 0), 0);
+                                vec3 lightNormal = clusterOctDecode(sizeParams.z);
+                                float decayRate = texelFetch(rectLightTexture, rectCoord + ivec2(3, 0), 0).x;
+                                
+                                vec3 L = posInvRadius.xyz - geometryPosition;
+                                float distToLight = length(L);
+                                
+                                if( distToLight * posInvRadius.w < 1.0 ) {
+                                    L = L / distToLight;
+                                    float NdotL = max(dot(geometryNormal, L), 0.0);
                                     
-                                    if( distToLight < posRadius.w ) {
-                                        L = L / distToLight;
-                                        float NdotL = max(dot(geometryNormal, L), 0.0);
-                                        
-                                        if (NdotL > 0.0) {
-                                            if (lod < 1.5) {
-                                                // Simple point approximation
-                                                float area = sizeParams.x * sizeParams.y;
-                                                float attenuation = area / (distToLight * distToLight * (1.0 + sizeParams.z * distToLight * 0.1));
-                                                
-                                                directLight.direction = L;
-                                                vec3 lightColor = colorIntensity.rgb * colorIntensity.w * attenuation * NdotL;
-                                                reflectedLight.directDiffuse += lightColor * BRDF_Lambert( material.diffuseColor );
-                                            } else {
-                                                // Full calculation with stable basis
-                                                vec3 absNormal = abs(lightNormal.xyz);
-                                                vec3 helper = absNormal.x < absNormal.y ?
-                                                    (absNormal.x < absNormal.z ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 0.0, 1.0)) :
-                                                    (absNormal.y < absNormal.z ? vec3(0.0, 1.0, 0.0) : vec3(0.0, 0.0, 1.0));
-                                                vec3 right = normalize(cross(lightNormal.xyz, helper));
-                                                vec3 up = cross(right, lightNormal.xyz);
-                                                
-                                                // toSurface = -L * distToLight (L is already normalized on line 558)
-                                                float cosTheta = max(0.0, dot(lightNormal.xyz, -L)); // Reuse normalized L
-                                                
-                                                float area = sizeParams.x * sizeParams.y;
-                                                float rectDistAttenuation = (area * cosTheta * 10.0) / (distToLight * distToLight);
-                                                rectDistAttenuation *= 1.0 / (1.0 + sizeParams.z * distToLight * 0.1);
-                                                
-                                                directLight.direction = L;
-                                                directLight.color = colorIntensity.rgb * colorIntensity.w * rectDistAttenuation * NdotL;
-                                                RE_Direct( directLight, geometryPosition, geometryNormal, geometryViewDir, geometryClearcoatNormal, material, reflectedLight );
-                                            }
+                                    if (NdotL > 0.0) {
+                                        if (lod < 1.5) {
+                                            // Simple point approximation
+                                            float attenuation = 1.0 / (distToLight * distToLight * (1.0 + decayRate * distToLight));
+                                            
+                                            directLight.direction = L;
+                                            vec3 lightColor = colorTangent.rgb * attenuation * NdotL;
+                                            reflectedLight.directDiffuse += lightColor * BRDF_Lambert( material.diffuseColor );
+                                        } else {
+                                            // Full calculation with stable basis
+                                            vec3 absNormal = abs(lightNormal.xyz);
+                                            vec3 helper = absNormal.x < absNormal.y ?
+                                                (absNormal.x < absNormal.z ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 0.0, 1.0)) :
+                                                (absNormal.y < absNormal.z ? vec3(0.0, 1.0, 0.0) : vec3(0.0, 0.0, 1.0));
+                                            vec3 right = normalize(cross(lightNormal.xyz, helper));
+                                            vec3 up = cross(right, lightNormal.xyz);
+                                            
+                                            // toSurface = -L * distToLight (L is already normalized on line 558)
+                                            float cosTheta = max(0.0, dot(lightNormal.xyz, -L)); // Reuse normalized L
+                                            
+                                            float rectDistAttenuation = (cosTheta * 10.0) / (distToLight * distToLight);
+                                            rectDistAttenuation *= 1.0 / (1.0 + decayRate * distToLight);
+                                            
+                                            directLight.direction = L;
+                                            directLight.color = colorTangent.rgb * rectDistAttenuation * NdotL;
+                                            RE_Direct( directLight, geometryPosition, geometryNormal, geometryViewDir, geometryClearcoatNormal, material, reflectedLight );
                                         }
                                     }
                                 }
@@ -618,11 +614,6 @@ export const lights_fragment_ultra_optimized = `//glsl
     int slice = int( log( vViewPosition.z ) * clusterParams.z - clusterParams.w );
     txy.x = txy.x * sliceParams.z + slice;
 
-    // Precompute constants to avoid per-light recalculation
-    float width = float(pointLightTextureWidth);
-    float widthInv = 1.0 / width;
-    int pointCount = int(lightCounts.x);
-
     #ifdef USE_SUPER_MASTER
     // Hierarchical early-out: skip empty 8x8 super-tiles
     int superX = txy.x >> 3; // /8
@@ -652,52 +643,38 @@ export const lights_fragment_ultra_optimized = `//glsl
 
                     for( int j = 0; value != 0u; j++, value >>= 1 ) {
                         if ( ( value & 1u ) == 1u ){
+                            // Point-only scene: every assigned slot is a point light
                             int typeIndex = lightIndex + j;
 
-                            // Bounds check only
-                            if (typeIndex >= pointCount) continue;
-
-                            // Optimized 2D texture sampling - minimize divisions
-                            float baseTexel = float(typeIndex) * 2.0;
-                            float rowF = floor(baseTexel * widthInv);
-                            int row = int(rowF);
-                            int col = int(baseTexel - rowF * width);
-
-                            // Second texel coordinate (baseTexel + 1)
-                            int col2 = col + 1;
-                            int row2 = row;
-                            if (col2 >= int(width)) {
-                                col2 = 0;
-                                row2 = row + 1;
-                            }
+                            // All three texels share a row: shift/mask addressing
+                            ivec2 posCoord = clusterLightTexel(typeIndex, pointLightRowShift, 3, 0);
+                            vec4 colorDecayVisible = texelFetch(pointLightTexture, posCoord + ivec2(1, 0), 0);
 
-                            vec4 posRadius = texelFetch(pointLightTexture, ivec2(col, row), 0);
-                            vec4 colorDecayVisible = texelFetch(pointLightTexture, ivec2(col2, row2), 0);
+                            // Fast visibility/LOD/layer check (packed in w component)
+                            uint lightBits = uint(colorDecayVisible.w);
+                            if (!clusterLightReceived(lightBits)) continue;
 
-                            // Fast visibility/LOD check (packed in w component)
-                            float packed = colorDecayVisible.w;
-                            float visLod = mod(packed, 100.0); // visible*10 + lod
-                            if (visLod < 10.5) continue; // Skip if invisible or LOD=0
+                            vec4 posInvRadius = texelFetch(pointLightTexture, posCoord, 0);
 
-                            vec3 lVector = posRadius.xyz - geometryPosition;
+                            vec3 lVector = posInvRadius.xyz - geometryPosition;
                             float distSq = dot(lVector, lVector);
-                            float radiusSq = posRadius.w * posRadius.w;
+                            float invRadiusSq = posInvRadius.w * posInvRadius.w;
 
-                            if( distSq < radiusSq ) {
+                            if( distSq * invRadiusSq < 1.0 ) {
                                 float lightDistance = sqrt(distSq);
                                 directLight.direction = lVector / lightDistance; // Normalize using precomputed 1/dist
 
                                 // LOD-based lighting - simplified branching
-                                float lod = mod(visLod, 10.0);
-                                float decay = floor(packed * 0.01) * 0.1;
+                                float lod = clusterLightLOD(lightBits);
+                                float decay = texelFetch(pointLightTexture, posCoord + ivec2(2, 0), 0).x;
 
                                 if (lod > 2.5) {
                                     // LOD 3: Full quality PBR
-                                    directLight.color = colorDecayVisible.rgb * getDistanceAttenuation( lightDistance, posRadius.w, decay );
+                                    directLight.color = colorDecayVisible.rgb * clusterDistanceAttenuation( lightDistance, posInvRadius.w, decay );
                                     RE_Direct( directLight, geometryPosition, geometryNormal, geometryViewDir, geometryClearcoatNormal, material, reflectedLight );
                                 } else if (lod > 1.5) {
                                     // LOD 2: Medium quality - diffuse + simplified specular
-                                    directLight.color = colorDecayVisible.rgb * getDistanceAttenuation( lightDistance, posRadius.w, decay );
+                                    directLight.color = colorDecayVisible.rgb * clusterDistanceAttenuation( lightDistance, posInvRadius.w, decay );
                                     float dotNL = saturate( dot( geometryNormal, directLight.direction ) );
                                     reflectedLight.directDiffuse += dotNL * directLight.color * BRDF_Lambert( material.diffuseColor );
 
@@ -775,9 +752,14 @@ export function getListMaterial() {
             pointLightTexture: null,
             spotLightTexture: null,
             rectLightTexture: null,
+            lightTexture: null,
+            lightRowBases: null,
             lightCounts: null,
+            lightBatchBases: null,
             projectionMatrix: { value: null },
-            pointLightTextureWidth: null,
+            pointLightRowShift: null,
+            spotLightRowShift: null,
+            rectLightRowShift: null,
             maxTileSpan: { value: 12.0 } // Limit tile overdraw (min: 8 to avoid artifacts, lower = better perf, higher = better quality)
         },
         glslVersion: "300 es",
@@ -794,16 +776,35 @@ export function getListMaterial() {
             uniform float nearZ;
             uniform mat4 projectionMatrix;
             uniform vec3 lightCounts;
+            uniform ivec2 lightBatchBases; // First 32-light batch of spot (x) and rect (y) lights
+            #ifdef CLUSTER_UNIFIED_LIGHTS
+            uniform highp sampler2D lightTexture;
+            uniform ivec2 lightRowBases; // First row of spot (x) and rect (y) records
+            #define pointLightTexture lightTexture
+            #define spotLightTexture lightTexture
+            #define rectLightTexture lightTexture
+            #define SPOT_ROW lightRowBases.x
+            #define RECT_ROW lightRowBases.y
+            #else
             uniform highp sampler2D pointLightTexture;
             uniform highp sampler2D spotLightTexture;
             uniform highp sampler2D rectLightTexture;
-            uniform int pointLightTextureWidth;
+            #define SPOT_ROW 0
+            #define RECT_ROW 0
+            #endif
+            uniform int pointLightRowShift; // Lights per texture row = 1 << shift
+            uniform int spotLightRowShift;
+            uniform int rectLightRowShift;
             uniform float maxTileSpan; // Max tiles a light can span (prevents overdraw)
 
             flat out ivec2 vClusters;
             flat out int vID;
 
             float square(float v) { return v * v;}
+
+            ivec2 lightTexel(int index, int shift, int texels, int row) {
+                return ivec2((index & ((1 << shift) - 1)) * texels, row + (index >> shift));
+            }
            
             vec2 project_sphere_flat(float view_xy, float view_z, float radius)
             {
@@ -843,56 +844,53 @@ export function getListMaterial() {
                 vec4 params;
                 float lod = 3.0; // default to full quality
 
-                if (gl_InstanceID < int(lightCounts.x)) {
-                    // 2D texture sampling - use float to avoid int overflow
-                    float lightIdx = float(gl_InstanceID);
-                    float baseTexel = lightIdx * 2.0;
-                    float width = float(pointLightTextureWidth);
-                    int row = int(floor(baseTexel / width));
-                    int col = int(baseTexel - float(row) * width);
-                    ivec2 posCoord = ivec2(col, row);
-
-                    float nextTexel = baseTexel + 1.0;
-                    int nextRow = int(floor(nextTexel / width));
-                    int nextCol = int(nextTexel - float(nextRow) * width);
-                    ivec2 colorCoord = ivec2(nextCol, nextRow);
+                // Instances are light slots: each type starts on a 32-light
+                // batch boundary and the padding slots are culled like
+                // invisible lights, so no batch mixes light types
+                int spotBase = 32 * lightBatchBases.x;
+                int rectBase = 32 * lightBatchBases.y;
+                int typeIndex = gl_InstanceID - (gl_InstanceID < spotBase ? 0 : (gl_InstanceID < rectBase ? spotBase : rectBase));
+                int typeCount = int(gl_InstanceID < spotBase ? lightCounts.x : (gl_InstanceID < rectBase ? lightCounts.y : lightCounts.z));
+                if (typeIndex >= typeCount) {
+                    gl_Position = vec4(10., 10., 0., 1.);
+                    return;
+                }
 
+                if (gl_InstanceID < spotBase) {
+                    ivec2 posCoord = lightTexel(typeIndex, pointLightRowShift, 3, 0);
                     view = texelFetch(pointLightTexture, posCoord, 0);
-                    vec4 colorDecayVisible = texelFetch(pointLightTexture, colorCoord, 0);
-
-                    // Extract visibility and LOD from packed value
-                    float packedValue = colorDecayVisible.w;
-                    float visible = mod(floor(packedValue * 0.1), 2.0);
-                    lod = mod(packedValue, 10.0);
-                    params = vec4(0.0, visible, 0.0, 0.0);
-                } else if (gl_InstanceID < int(lightCounts.x + lightCounts.y)) {
+                    vec4 colorDecayVisible = texelFetch(pointLightTexture, posCoord + ivec2(1, 0), 0);
+
+                    // Extract visibility and LOD from packed value (bits 0-1 LOD, bit 2 visible)
+                    uint lightBits = uint(colorDecayVisible.w);
+                    lod = float(lightBits & 3u);
+                    params = vec4(0.0, float((lightBits >> 2u) & 1u), 0.0, 0.0);
+                } else if (gl_InstanceID < rectBase) {
                     // Spot light
-                    int spotIndex = gl_InstanceID - int(lightCounts.x);
-                    view = texelFetch(spotLightTexture, ivec2(spotIndex * 4, 0), 0);
-                    params = texelFetch(spotLightTexture, ivec2(spotIndex * 4 + 3, 0), 0);
-                    float packedValue = params.w;
-                    float visible = floor(packedValue * 0.1);
-                    lod = mod(packedValue, 10.0);
-                    params.y = visible;
+                    ivec2 spotCoord = lightTexel(typeIndex, spotLightRowShift, 3, SPOT_ROW);
+                    view = texelFetch(spotLightTexture, spotCoord, 0);
+                    params = texelFetch(spotLightTexture, spotCoord + ivec2(2, 0), 0);
+                    uint lightBits = uint(params.w);
+                    lod = float(lightBits & 3u);
+                    params.y = float((lightBits >> 2u) & 1u);
                 } else {
                     // Rect light
-                    int rectIndex = gl_InstanceID - int(lightCounts.x + lightCounts.y);
-                    view = texelFetch(rectLightTexture, ivec2(rectIndex * 4, 0), 0);
-                    params = texelFetch(rectLightTexture, ivec2(rectIndex * 4 + 2, 0), 0);
-                    float packedValue = params.w;
-                    float visible = floor(packedValue * 0.1);
-                    lod = mod(packedValue, 10.0);
-                    params.y = visible;
+                    ivec2 rectCoord = lightTexel(typeIndex, rectLightRowShift, 4, RECT_ROW);
+                    view = texelFetch(rectLightTexture, rectCoord, 0);
+                    params = texelFetch(rectLightTexture, rectCoord + ivec2(2, 0), 0);
+                    uint lightBits = uint(params.w);
+                    lod = float(lightBits & 3u);
+                    params.y = float((lightBits >> 2u) & 1u);
                 }
 
-                // Check visibility and LOD
-                float visibility = (gl_InstanceID < int(lightCounts.x)) ? params.y : params.y;
-                if (visibility < 0.5 || lod < 0.5) {
+                // Check visibility and LOD; records store 1 / radius, and a
+                // light of radius 0 (stored as 0) reaches no cluster
+                if (params.y < 0.5 || lod < 0.5 || view.w <= 0.0) {
                     gl_Position = vec4(10., 10., 0., 1.);
                     return;
                 }
                  
-                float radius = view.w;
+                float radius = 1.0 / view.w;
 
                 if(view.z > radius - nearZ) {
                     gl_Position = vec4(10., 10., 0., 1.);
@@ -1079,8 +1077,8 @@ export function getSuperMasterMaterial() {
                 int superX = int(gl_FragCoord.x);
                 int superY = int(gl_FragCoord.y);
 
-                // Get master texture dimensions
-                ivec2 masterSize = textureSize(masterTexture, 0);
+                // Master dimensions in use (the target may be larger)
+                ivec2 masterSize = ivec2(sliceParams.x * sliceParams.z, sliceParams.y * sliceParams.w);
 
                 // OR together up to 8×8 tiles
                 superCluster = 0u;
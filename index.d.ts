@@ -108,6 +108,14 @@ export interface BaseLightConfig {
   radius?: number;
   decay?: number;
   visible?: boolean;
+  /** Group membership bitmask: bit g = member of group g (0-31) */
+  groups?: number;
+  /** Light layer bitmask: bit n = layer n (0-7). Defaults to layer 0 */
+  layers?: number;
+  /** Candidate for per-frame shadow caster selection */
+  castsShadow?: boolean;
+  /** 0 = pitch black, 1 = no shadow (default 0.3) */
+  shadowIntensity?: number;
   animation?: LightAnimation;
 }
 
@@ -131,10 +139,72 @@ export interface RectLightConfig extends BaseLightConfig {
 
 export type LightConfig = PointLightConfig | SpotLightConfig | RectLightConfig;
 
+export interface VisibilityChange {
+  type: 'point' | 'spot' | 'rect';
+  typeIndex: number;
+  visible: boolean;
+  lod: number;
+  wasVisible: boolean;
+  previousLOD: number;
+}
+
+export interface LightPatch {
+  /** Ids (global indices returned by addLight) to remove */
+  remove?: number[];
+  update?: Array<{ id: number; properties: Partial<LightConfig> }>;
+  add?: LightConfig[];
+}
+
+type GeneratorRange = number | [number, number];
+type GeneratorVec3 = THREE.Vector3 | [number, number, number];
+
+/** Styling shared by the light generators; ranges are [min, max] */
+export interface LightGeneratorStyle {
+  seed?: number;
+  palette?: THREE.ColorRepresentation | THREE.ColorRepresentation[];
+  /** 0 = pick palette entries, 1 = blend between neighbouring entries */
+  paletteBlend?: number;
+  radius?: GeneratorRange;
+  intensity?: GeneratorRange;
+  decay?: number;
+  groups?: number;
+  layers?: number;
+  /** Relative weights per animation kind (`none` defaults to 0 once any kind is given) */
+  animation?: {
+    none?: number;
+    circular?: { weight?: number; speed?: GeneratorRange; radius?: GeneratorRange };
+    wave?: { weight?: number; speed?: GeneratorRange; amplitude?: GeneratorRange; axis?: GeneratorVec3 };
+    flicker?: { weight?: number; speed?: GeneratorRange; intensity?: GeneratorRange };
+    pulse?: { weight?: number; speed?: GeneratorRange; amount?: GeneratorRange; target?: PulseTarget | 'intensity' | 'radius' | 'both' };
+  };
+}
+
+export interface ShadowCaster {
+  type: 'point' | 'spot' | 'rect';
+  typeIndex: number;
+  /** View-space position */
+  position: THREE.Vector3;
+  radius: number;
+  /** View-space spot direction or rect normal (zero for point lights) */
+  direction: THREE.Vector3;
+  /** Spot cone angle in radians (0 for other types) */
+  angle: number;
+  score: number;
+  shadowIntensity: number;
+  /** Atlas rects in texels: six cube faces for points, one tile otherwise */
+  tiles: Array<{ x: number; y: number; size: number; face: number }>;
+}
+
 // ============================================================================
 // Cluster Lighting System
 // ============================================================================
 
+export interface LightCommandProducerInfo {
+  memory: WebAssembly.Memory;
+  queue: number;
+  producer: number;
+}
+
 export class ClusterLightingSystem {
   constructor(
     renderer: THREE.WebGLRenderer,
@@ -154,14 +224,26 @@ export class ClusterLightingSystem {
   readonly pointLightCount: number;
   readonly spotLightCount: number;
   readonly rectLightCount: number;
+  /** Incremented whenever lights move to new core indices (command targets go stale) */
+  readonly lightOrderVersion: number;
 
   // Material patching
-  patchMaterial(material: THREE.Material): void;
+  patchMaterial(material: THREE.Material, options?: { lightLayers?: number }): void;
+  setMaterialLightLayers(material: THREE.Material, layers: number): void;
 
   // Light management
   addLight(light: LightConfig): number;
   removeLight(globalIndex: number): void;
   clearLights(): void;
+  /** Returns the ids assigned to `add`, in order */
+  patchLights(diff: LightPatch): number[];
+
+  // Batching: defer derived work (counts, textures, cluster state) to one refresh
+  autoBatch: boolean;
+  beginBatch(): void;
+  commitBatch(): void;
+  batch<T>(fn: () => T): T;
+  setAutoBatch(enabled: boolean): void;
 
   // Light updates
   updateLightPosition(globalIndex: number, position: THREE.Vector3): void;
@@ -171,6 +253,9 @@ export class ClusterLightingSystem {
   updateLightDecay(globalIndex: number, decay: number): void;
   updateLightVisibility(globalIndex: number, visible: boolean): void;
   updateLightAnimation(globalIndex: number, animation: LightAnimation): void;
+  updateLightGroups(globalIndex: number, groups: number): void;
+  updateLightLayers(globalIndex: number, layers: number): void;
+  updateLightShadow(globalIndex: number, castsShadow: boolean, shadowIntensity?: number): void;
 
   // Spot light specific updates
   updateSpotDirection(globalIndex: number, direction: THREE.Vector3): void;
@@ -191,12 +276,55 @@ export class ClusterLightingSystem {
   getLODBias(): number;
   getLightLOD(globalIndex: number): number;
 
+  // Light groups
+  setLightGroupEnabled(group: number, enabled: boolean): void;
+  setLightGroupIntensity(group: number, intensity: number): void;
+  setLightGroupTint(group: number, color: THREE.Color): void;
+  resetLightGroups(): void;
+
+  // Shadow caster selection
+  setShadowBudget(count: number): void;
+  setShadowHysteresis(factor: number): void;
+  setShadowAtlas(size: number, minTile?: number): void;
+  setShadowTileScale(scale: number): void;
+  getShadowCasters(): ShadowCaster[];
+
+  // Light generators (return the new lights' global indices)
+  generateGridLights(options?: LightGeneratorStyle & { counts?: [number, number, number]; min?: GeneratorVec3; max?: GeneratorVec3; jitter?: number }): number[];
+  generatePoissonLights(options?: LightGeneratorStyle & { count?: number; minDistance?: number; min?: GeneratorVec3; max?: GeneratorVec3; attempts?: number }): number[];
+  generatePolylineLights(options?: LightGeneratorStyle & { points?: THREE.Vector3[] | ArrayLike<number>; spacing?: number; closed?: boolean; jitter?: number }): number[];
+  generateMeshLights(options?: LightGeneratorStyle & { count?: number; geometry?: THREE.BufferGeometry; matrix?: THREE.Matrix4; positions?: Float32Array; indices?: ArrayLike<number>; offset?: number }): number[];
+
+  // Compact static point lights (not individually addressable). They share the
+  // maxSafeLights point budget with dynamic point lights; the capacity returned
+  // by reserveStaticPointLights may be lower than requested.
+  reserveStaticPointLights(capacity: number): number;
+  addStaticPointLights(lights: Array<{ position: THREE.Vector3; color: THREE.Color; intensity?: number; radius?: number; decay?: number }>): number;
+  clearStaticPointLights(): void;
+
+  // Lock-free command queue
+  createLightCommandQueue(capacity?: number): boolean;
+  createLightCommandProducer(): LightCommandProducerInfo | null;
+  getLightCommandTarget(globalIndex: number): { type: 'point' | 'spot' | 'rect'; index: number } | null;
+
+  // State replication
+  encodeLightDelta(options?: { keyframe?: boolean }): Uint8Array | null;
+  applyLightDelta(bytes: Uint8Array): boolean;
+
+  // Visibility tracking
+  getVisibilityBitset(type?: 'point' | 'spot' | 'rect'): Uint32Array | null;
+  getVisibilityChanges(): VisibilityChange[];
+  isLightRendered(globalIndex: number): boolean;
+  getVisibleLightIndices(type?: 'point' | 'spot' | 'rect'): Uint32Array | null;
+
   // Performance tuning
   setMaxTileSpan(span: number): void;
   getMaxTileSpan(): number;
   setDynamicClusters(enable: boolean): void;
   setZeroCopyMode(enabled: boolean): void;
   setDeferredSorting(enabled: boolean): void;
+  setLightMirrors(enabled: boolean): void;
+  setUnifiedLightTexture(enabled: boolean): void;
   sortNow(): void;
   forceClusterUpdate(): void;
 
@@ -206,6 +334,7 @@ export class ClusterLightingSystem {
 
   // Import/Export
   exportLights(): LightConfig[];
+  getLight(globalIndex: number): LightConfig | null;
   importLights(lightData: LightConfig[]): void;
 
   // Cleanup
@@ -367,3 +496,35 @@ export interface WasmLoadOptions {
 
 export function loadWasm(options?: WasmLoadOptions): Promise<WebAssembly.WebAssemblyInstantiatedSource>;
 
+
+// ============================================================================
+// Light Command Queue
+// ============================================================================
+
+export enum LightCommand {
+  POSITION = 0,
+  COLOR = 1,
+  INTENSITY = 2,
+  RADIUS = 3,
+  DECAY = 4,
+  VISIBILITY = 5,
+  DIRECTION = 6,
+  LAYERS = 7,
+  GROUP_MASK = 8
+}
+
+type LightCommandType = 'point' | 'spot' | 'rect' | 0 | 1 | 2;
+
+export class LightCommandProducer {
+  constructor(info: LightCommandProducerInfo);
+  push(op: LightCommand, type: LightCommandType, index: number, a?: number, b?: number, c?: number, d?: number, bits?: boolean): boolean;
+  setPosition(type: LightCommandType, index: number, x: number, y: number, z: number): boolean;
+  setColor(type: LightCommandType, index: number, r: number, g: number, b: number): boolean;
+  setIntensity(type: LightCommandType, index: number, intensity: number): boolean;
+  setRadius(type: LightCommandType, index: number, radius: number): boolean;
+  setDecay(type: LightCommandType, index: number, decay: number): boolean;
+  setVisible(type: LightCommandType, index: number, visible: boolean): boolean;
+  setDirection(type: LightCommandType, index: number, x: number, y: number, z: number): boolean;
+  setLayers(type: LightCommandType, index: number, layers: number): boolean;
+  setGroupMask(type: LightCommandType, index: number, mask: number): boolean;
+}
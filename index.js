@@ -39,6 +39,9 @@ export { LightMarkers } from './visual/light-markers.js';
 // WASM loader helper (includes ASM.js fallback)
 export { loadWasm } from './utils/wasm-loader.js';
 
+// Lock-free light command producers (main thread or workers)
+export { LightCommandProducer, LightCommand } from './utils/light-command-queue.js';
+
 // Unified Performance Tracker (easiest to use)
 export { PerformanceTracker } from './performance/performance-tracker.js';
 
@@ -0,0 +1,52 @@
+#!/usr/bin/env node
+
+// Native tests for the core: every tests/*.c is compiled with the host C
+// compiler (CC, default cc) against wasm/cluster-lights.c and run.
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { spawnSync } = require('child_process');
+
+const projectRoot = process.cwd();
+const testDir = path.join(projectRoot, 'tests');
+const outDir = fs.mkdtempSync(path.join(os.tmpdir(), 'cluster-lights-tests-'));
+const compiler = process.env.CC || 'cc';
+const only = process.argv.slice(2);
+
+const tests = fs.readdirSync(testDir)
+  .filter((file) => file.endsWith('.c'))
+  .filter((file) => !only.length || only.includes(path.basename(file, '.c')))
+  .sort();
+
+const failed = [];
+for (const file of tests) {
+  const name = path.basename(file, '.c');
+  const binary = path.join(outDir, name);
+  const build = spawnSync(compiler, [
+    '-std=gnu11', '-O1', '-g', '-Wall', '-Wno-unused-function',
+    path.join(testDir, file), '-o', binary, '-lm',
+  ], { stdio: 'inherit' });
+
+  if (build.error || build.status !== 0) {
+    console.error(`FAIL ${name} (build${build.error ? `: ${build.error.message}` : ''})`);
+    failed.push(name);
+    continue;
+  }
+
+  const run = spawnSync(binary, [], { stdio: 'inherit' });
+  if (run.status !== 0) {
+    console.error(`FAIL ${name}`);
+    failed.push(name);
+  } else {
+    console.log(`ok   ${name}`);
+  }
+}
+
+fs.rmSync(outDir, { recursive: true, force: true });
+
+if (failed.length) {
+  console.error(`\n${failed.length} of ${tests.length} test(s) failed`);
+  process.exit(1);
+}
+console.log(`\nAll ${tests.length} test(s) passed.`);
@@ -24,4 +24,57 @@ if (missing.length) {
   process.exit(1);
 }
 
-console.log('All prebuilt WebAssembly artifacts are present.');
+// Artifacts must be built from the current core: the shaders decode the
+// texture layout reported by getTextureLayoutVersion()
+const LAYOUT_EXPORT = 'getTextureLayoutVersion';
+
+// Names in a .wasm export section (id 7)
+function wasmExports(buffer) {
+  const names = [];
+  let offset = 8;
+  const leb = () => {
+    let result = 0;
+    let shift = 0;
+    let byte;
+    do {
+      byte = buffer[offset++];
+      result |= (byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    return result >>> 0;
+  };
+  while (offset < buffer.length) {
+    const id = buffer[offset++];
+    const size = leb();
+    const end = offset + size;
+    if (id === 7) {
+      for (let count = leb(); count > 0; count--) {
+        const length = leb();
+        names.push(buffer.toString('utf8', offset, offset + length));
+        offset += length + 1; // name, kind
+        leb(); // index
+      }
+    }
+    offset = end;
+  }
+  return names;
+}
+
+const stale = requiredArtifacts.filter((relativePath) => {
+  const contents = fs.readFileSync(path.join(projectRoot, relativePath));
+  if (relativePath.endsWith('.wasm')) {
+    return !wasmExports(contents).some((name) => name === LAYOUT_EXPORT || name === `_${LAYOUT_EXPORT}`);
+  }
+  return !contents.toString('utf8').includes(LAYOUT_EXPORT);
+});
+
+if (stale.length) {
+  console.error(
+    `Prebuilt WebAssembly artifacts are older than wasm/cluster-lights.c:\n${stale
+      .map((file) => ` - ${file}`)
+      .join('\n')}\n\nRun npm run build:all before publishing.`
+  );
+  process.exit(1);
+}
+
+console.log('All prebuilt WebAssembly artifacts are present and current.');
@@ -0,0 +1,17 @@
+// Shared scaffolding for the native core tests (run with npm test). Each test
+// compiles the core into itself, so its static helpers are reachable.
+#include "../wasm/cluster-lights.c"
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+// Exit status for main: 0 when every check passed
+#define TEST_RESULT() (failures ? (fprintf(stderr, "%d check(s) failed\n", failures), 1) : 0)
@@ -0,0 +1,118 @@
+// Light state deltas: a keyframe and an incremental delta rebuild the
+// sender's quantised state on a fresh core, and no truncated prefix of a
+// packet is applied (all-or-nothing)
+#include "harness.h"
+
+#define MAX_TEST_LIGHTS 256
+
+typedef struct {
+    int counts[3];
+    int32_t q[3][MAX_TEST_LIGHTS][DELTA_FIELDS];
+} Scene;
+
+static void capture(Scene *s) {
+    s->counts[LIGHT_TYPE_POINT] = pointLightCount;
+    s->counts[LIGHT_TYPE_SPOT] = spotLightCount;
+    s->counts[LIGHT_TYPE_RECT] = rectLightCount;
+    memset(s->q, 0, sizeof(s->q));
+    for (int t = 0; t < 3; t++) {
+        for (int i = 0; i < s->counts[t]; i++) quantizeLight(t, i, s->q[t][i]);
+    }
+}
+
+static int sameScene(const Scene *a, const Scene *b) {
+    return memcmp(a->counts, b->counts, sizeof(a->counts)) == 0 &&
+           memcmp(a->q, b->q, sizeof(a->q)) == 0;
+}
+
+// Copy of the last encoded packet
+static uint8_t *takePacket(int size) {
+    uint8_t *packet = (uint8_t*)malloc((size_t)size);
+    memcpy(packet, getLightDeltaBuffer(), (size_t)size);
+    return packet;
+}
+
+static int apply(const uint8_t *packet, int size) {
+    memcpy(getLightDeltaInput(size > 0 ? size : 1), packet, (size_t)size);
+    return applyLightDelta(size);
+}
+
+// Every strict prefix is rejected and leaves the scene untouched
+static void checkTruncation(const uint8_t *packet, int size) {
+    Scene before, after;
+    capture(&before);
+    for (int k = 0; k < size; k++) {
+        CHECK(apply(packet, k) == -1);
+        capture(&after);
+        CHECK(sameScene(&before, &after));
+    }
+}
+
+int main(void) {
+    Scene sent1, sent2, received;
+
+    // Sender: a mixed scene, some points with a circular animation
+    init(MAX_TEST_LIGHTS);
+    for (int i = 0; i < 40; i++) {
+        add((float)(i * 3 % 50) - 25.0f, 1.5f, (float)(i * 7 % 50) - 25.0f, 5.0f,
+            0.5f, 0.25f, 1.0f, 2.0f, i % 5 == 0 ? 1.0f : 0.0f, i % 5 == 0 ? 2.0f : 0.0f, 3.0f);
+    }
+    for (int i = 0; i < 8; i++) addSpot((float)i, 2.0f, 0.0f, 10.0f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.2f, 0.6f, 0.1f, 2.0f, 5.0f);
+    for (int i = 0; i < 4; i++) addRect((float)i, 3.0f, 0.0f, 2.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 4.0f, 0.5f, 8.0f);
+    sort();
+
+    int keySize = encodeLightDelta();
+    CHECK(keySize > 0);
+    uint8_t *keyframe = takePacket(keySize);
+    capture(&sent1);
+
+    // Edits: a move, an intensity change, an added and a removed light
+    updatePointLightPosition(3, 10.0f, 2.0f, -4.0f);
+    updateSpotLightIntensity(1, 7.5f);
+    add(1.0f, 1.0f, 1.0f, 4.0f, 1.0f, 1.0f, 1.0f, 2.0f, 0.0f, 0.0f, 1.0f);
+    removeRectLight(0);
+    sort();
+
+    int deltaSize = encodeLightDelta();
+    CHECK(deltaSize > 0 && deltaSize < keySize);
+    uint8_t *delta = takePacket(deltaSize);
+    capture(&sent2);
+    int idleSize = encodeLightDelta();
+
+    resetLightDelta();
+    int rekeySize = encodeLightDelta();
+    uint8_t *rekey = takePacket(rekeySize);
+    cleanup();
+
+    // Receiver: a fresh core
+    init(MAX_TEST_LIGHTS);
+    checkTruncation(keyframe, keySize);
+    CHECK(apply(keyframe, keySize) == 0);
+    capture(&received);
+    CHECK(sameScene(&sent1, &received));
+
+    checkTruncation(delta, deltaSize);
+    CHECK(apply(delta, deltaSize) == 0);
+    capture(&received);
+    CHECK(sameScene(&sent2, &received));
+
+    // Trailing bytes are malformed too
+    uint8_t *padded = (uint8_t*)calloc((size_t)deltaSize + 1, 1);
+    memcpy(padded, delta, (size_t)deltaSize);
+    CHECK(apply(padded, deltaSize + 1) == -1);
+
+    // In sync: the receiver has nothing to send back
+    CHECK(encodeLightDelta() == idleSize);
+
+    // A keyframe over existing state lands on the same scene
+    CHECK(apply(rekey, rekeySize) == 0);
+    capture(&received);
+    CHECK(sameScene(&sent2, &received));
+    cleanup();
+
+    free(keyframe);
+    free(delta);
+    free(rekey);
+    free(padded);
+    return TEST_RESULT();
+}
@@ -0,0 +1,65 @@
+// packOctahedral: one exact float per unit vector, decoded the way the
+// shaders do (clusterOctDecode) to within a small angle
+#include "harness.h"
+
+// C mirror of clusterOctDecode in core/cluster-shaders.js
+static void octDecode(float packed, float out[3]) {
+    uint32_t bits = (uint32_t)packed;
+    float ex = (float)(bits >> OCT_BITS) * (2.0f / (float)OCT_MAX) - 1.0f;
+    float ey = (float)(bits & OCT_MAX) * (2.0f / (float)OCT_MAX) - 1.0f;
+    float v[3] = {ex, ey, 1.0f - fabsf(ex) - fabsf(ey)};
+    float t = fmaxf(-v[2], 0.0f);
+    v[0] += v[0] >= 0.0f ? -t : t;
+    v[1] += v[1] >= 0.0f ? -t : t;
+    float len = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    for (int i = 0; i < 3; i++) out[i] = v[i] / len;
+}
+
+// Largest decode error in degrees; also checks the packed word is exact
+static double roundTrip(float x, float y, float z) {
+    float len = sqrtf(x * x + y * y + z * z);
+    Vec4 n = {x / len, y / len, z / len, 0.0f};
+    float packed = packOctahedral(&n);
+    CHECK(packed >= 0.0f && packed < 16777216.0f && (float)(uint32_t)packed == packed);
+
+    float d[3];
+    octDecode(packed, d);
+    double dot = (double)d[0] * n.x + (double)d[1] * n.y + (double)d[2] * n.z;
+    if (dot > 1.0) dot = 1.0;
+    return acos(dot) * 180.0 / M_PI;
+}
+
+int main(void) {
+    double worst = 0.0;
+
+    // Axes, octant diagonals and the fold edges of the lower hemisphere
+    static const float special[][3] = {
+        {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+        {1, 1, 1}, {-1, 1, 1}, {1, -1, -1}, {-1, -1, -1},
+        {1, 0, -1}, {0, 1, -1}, {-1, 0, -1}, {0, -1, -1}, {1e-6f, 0, -1},
+    };
+    for (size_t i = 0; i < sizeof(special) / sizeof(special[0]); i++) {
+        worst = fmax(worst, roundTrip(special[i][0], special[i][1], special[i][2]));
+    }
+
+    // Fibonacci sphere
+    const int samples = 100000;
+    const float golden = (float)(M_PI * (3.0 - sqrt(5.0)));
+    for (int i = 0; i < samples; i++) {
+        float y = 1.0f - 2.0f * ((float)i + 0.5f) / (float)samples;
+        float r = sqrtf(fmaxf(0.0f, 1.0f - y * y));
+        float phi = golden * (float)i;
+        worst = fmax(worst, roundTrip(r * cosf(phi), y, r * sinf(phi)));
+    }
+
+    // A zero vector encodes as the +z pole
+    Vec4 zero = {0.0f, 0.0f, 0.0f, 0.0f};
+    float pole[3];
+    octDecode(packOctahedral(&zero), pole);
+    CHECK(pole[2] > 0.9999f);
+
+    // 12 bits per axis: a few hundredths of a degree
+    CHECK(worst < 0.1);
+    if (failures) fprintf(stderr, "worst decode error %.4f degrees\n", worst);
+    return TEST_RESULT();
+}
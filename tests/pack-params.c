@@ -0,0 +1,31 @@
+// packLightParams: the word survives the float round trip exactly and every
+// field decodes the way the shaders read it (clusterLightReceived and friends)
+#include "harness.h"
+
+int main(void) {
+    static const float decays[] = {0.0f, 0.5f, 1.0f, 2.0f, 2.015625f, 10.0f, 127.98f, 500.0f};
+
+    for (size_t d = 0; d < sizeof(decays) / sizeof(decays[0]); d++) {
+        for (int visible = 0; visible < 2; visible++) {
+            for (int lod = 0; lod < 4; lod++) {
+                for (int layers = 0; layers < 256; layers++) {
+                    float packed = packLightParams(decays[d], (uint8_t)visible, (uint8_t)lod, (uint8_t)layers);
+                    uint32_t bits = (uint32_t)packed;
+
+                    // An exact integer, as uint(colorDecayVisible.w) expects
+                    CHECK((float)bits == packed);
+                    CHECK((bits & PACK_LOD_MASK) == (uint32_t)lod);
+                    CHECK(((bits & PACK_VISIBLE) != 0) == visible);
+                    CHECK(((bits >> PACK_LAYER_SHIFT) & 0xFFu) == (uint32_t)layers);
+
+                    // Decay is truncated to 1/64 steps and clamped to the field
+                    float decay = (float)(bits >> PACK_DECAY_SHIFT) / PACK_DECAY_STEPS;
+                    float expected = fminf(decays[d], (float)PACK_DECAY_MAX / PACK_DECAY_STEPS);
+                    CHECK(decay <= expected && expected - decay < 1.0f / PACK_DECAY_STEPS);
+                }
+            }
+        }
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,60 @@
+// Morton radix sort: records end up in key order, equal keys keep their
+// input order (full sort and tail merge), and passes over uniform key bytes
+// are skipped without disturbing anything
+#include "harness.h"
+
+#define N 4096
+
+static uint32_t rng = 7;
+static uint32_t next(void) { return rng = rng * 1664525u + 1013904223u; }
+
+// Stamp each record with its input position in `order`
+static void fill(int n, uint32_t (*key)(int)) {
+    for (int i = 0; i < n; i++) {
+        pointLights[i].morton = key(i);
+        pointLights[i].order = (uint32_t)i;
+    }
+}
+
+static void checkStableOrder(int n) {
+    static uint8_t seen[N];
+    memset(seen, 0, sizeof(seen));
+    for (int i = 0; i < n; i++) {
+        uint32_t o = pointLights[i].order;
+        CHECK(o < (uint32_t)n && !seen[o]);
+        if (o < (uint32_t)n) seen[o] = 1;
+    }
+    for (int i = 1; i < n; i++) {
+        const PointLight *a = &pointLights[i - 1], *b = &pointLights[i];
+        CHECK(a->morton <= b->morton);
+        if (a->morton == b->morton) CHECK(a->order < b->order);
+    }
+}
+
+static uint32_t fewKeys(int i) { (void)i; return (next() >> 16) % 17u * 0x01010101u; }
+static uint32_t anyKey(int i) { (void)i; return next(); }
+static uint32_t topByteOnly(int i) { (void)i; return (next() >> 24) << 24 | 0x00ABCDEFu; }
+static uint32_t sameKey(int i) { (void)i; return 0x12345678u; }
+
+int main(void) {
+    init(N);
+
+    uint32_t (*keys[])(int) = {fewKeys, anyKey, topByteOnly, sameKey};
+    for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) {
+        fill(N, keys[k]);
+        RADIX_SORT_IMPL(PointLight, pointLights, pointLightsScratch, N);
+        checkStableOrder(N);
+    }
+
+    // Tail merge: a sorted prefix plus a few unsorted records; for equal
+    // keys the prefix comes first, then the tail in its input order
+    fill(N, fewKeys);
+    int sorted = N - 64;
+    RADIX_SORT_IMPL(PointLight, pointLights, pointLightsScratch, sorted);
+    for (int i = 0; i < N; i++) pointLights[i].order = (uint32_t)i;
+    MERGE_SORTED_TAIL_IMPL(PointLight, pointLights, pointLightsScratch, sorted, N);
+    checkStableOrder(N);
+
+    cleanup();
+    return TEST_RESULT();
+}
@@ -0,0 +1,83 @@
+// Shadow atlas quadtree: sizes snap to a power of two, allocated tiles never
+// overlap or leave the atlas, and reserve/release keep the tree consistent
+#include "harness.h"
+
+// Mark the tile of `node` in a coverage grid of minimum-size cells; returns
+// 0 if any cell was already covered
+static int cover(uint8_t *grid, int cells, int node) {
+    int level = atlasNodeLevel(node);
+    uint32_t local = (uint32_t)(node - atlasLevelOffset(level));
+    int span = cells >> level;
+    int x0 = (int)deinterleaveBits(local) * span;
+    int y0 = (int)deinterleaveBits(local >> 1) * span;
+    int ok = x0 + span <= cells && y0 + span <= cells;
+    for (int y = y0; ok && y < y0 + span; y++) {
+        for (int x = x0; x < x0 + span; x++) {
+            if (grid[y * cells + x]) ok = 0;
+            grid[y * cells + x] = 1;
+        }
+    }
+    return ok;
+}
+
+static void resetAtlas(void) {
+    memset(atlasState, ATLAS_FREE, (size_t)atlasLevelOffset(atlasDepth + 1));
+}
+
+int main(void) {
+    setShadowAtlas(4096, 128);
+    CHECK(atlasSize == 4096 && atlasDepth == 5);
+    setShadowAtlas(3000, 128);
+    CHECK(atlasSize == 2048 && atlasDepth == 4);
+    setShadowAtlas(100000, 1);
+    CHECK(atlasSize == 16384 && atlasDepth == ATLAS_MAX_DEPTH);
+
+    setShadowAtlas(1024, 32);
+    CHECK(atlasDepth == 5);
+    int cells = 1 << atlasDepth;
+    static uint8_t grid[1 << (2 * ATLAS_MAX_DEPTH)];
+
+    // Every minimum tile can be handed out exactly once
+    resetAtlas();
+    memset(grid, 0, sizeof(grid));
+    int count = 0;
+    for (int node; (node = atlasAlloc(0, 0, atlasDepth)) >= 0; count++) {
+        CHECK(cover(grid, cells, node));
+    }
+    CHECK(count == cells * cells);
+    CHECK(atlasState[0] == ATLAS_FULL);
+
+    // Mixed sizes stay disjoint until the atlas is full
+    resetAtlas();
+    memset(grid, 0, sizeof(grid));
+    uint32_t s = 12345;
+    int covered = 0;
+    for (int i = 0; i < 4096; i++) {
+        s = s * 1664525u + 1013904223u;
+        int level = 1 + (int)((s >> 16) % (uint32_t)atlasDepth);
+        int node = atlasAlloc(0, 0, level);
+        if (node < 0) continue;
+        CHECK(atlasNodeLevel(node) == level);
+        CHECK(cover(grid, cells, node));
+        covered += (cells >> level) * (cells >> level);
+    }
+    CHECK(covered == cells * cells);
+
+    // Reserve fails on taken tiles and beneath taken ancestors; release frees
+    resetAtlas();
+    int big = atlasAlloc(0, 0, 1);
+    CHECK(big == atlasLevelOffset(1));
+    CHECK(!atlasReserve(big));
+    CHECK(!atlasReserve(4 * big + 1));
+    CHECK(atlasState[0] == ATLAS_PARTIAL);
+    atlasRelease(big);
+    CHECK(atlasState[0] == ATLAS_FREE);
+    CHECK(atlasReserve(4 * big + 1));
+    CHECK(atlasState[big] == ATLAS_PARTIAL);
+
+    // Partial subtrees are filled before free ones are split
+    int next = atlasAlloc(0, 0, 2);
+    CHECK(next >= 4 * big + 1 && next <= 4 * big + 4);
+
+    return TEST_RESULT();
+}
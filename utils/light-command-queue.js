@@ -0,0 +1,128 @@
+/**
+ * Producer side of the core's lock-free light command queue
+ *
+ * Any number of producers (the main thread, workers sharing the WASM memory)
+ * write commands into one ring without locks; the core drains it at the start
+ * of update() and applies the commands ordered by (producer, per-producer
+ * order), so the result never depends on how producers interleaved. A full
+ * ring makes a push return false rather than wait.
+ *
+ * Lights are addressed by type and core index (the same index the
+ * update*Light* exports take), not by a stable id. Indices change when the
+ * owning thread removes or re-sorts lights, and position changes (including
+ * queued ones) mark lights for re-sorting. The core drains the queue before
+ * either, so commands already in the ring apply to the indices they name.
+ * An index a producer captured earlier is not updated, though: a command
+ * pushed after the owner re-sorted or removed lights lands on whatever
+ * light now has that index. When the system's lightOrderVersion changes,
+ * the owner should post fresh getLightCommandTarget() results to its
+ * producers, and producers should treat commands pushed before those
+ * arrive as possibly misdirected.
+ *
+ * Producers need a WebAssembly.Memory backed by a SharedArrayBuffer;
+ * createLightCommandProducer() returns null otherwise.
+ *
+ * @example
+ * // Main thread
+ * lights.createLightCommandQueue(4096);
+ * worker.postMessage(lights.createLightCommandProducer()); // needs shared memory
+ *
+ * // Worker
+ * const producer = new LightCommandProducer(event.data);
+ * producer.setPosition('point', 12, x, y, z);
+ */
+
+// Command ops (LIGHT_CMD_* in cluster-lights.c)
+export const LightCommand = {
+  POSITION: 0,
+  COLOR: 1,
+  INTENSITY: 2,
+  RADIUS: 3,
+  DECAY: 4,
+  VISIBILITY: 5,
+  DIRECTION: 6,
+  LAYERS: 7,
+  GROUP_MASK: 8
+};
+
+const LightTypeIds = { point: 0, spot: 1, rect: 2 };
+
+// Queue layout (LightCommandQueue / LightCommand), in 32-bit words
+const TAIL = 0;
+const MASK = 1;
+const SLOTS = 32;        // Header is two 64-byte lines
+const SLOT_WORDS = 8;    // seq, index, op|type|producer, order, v[4]
+
+export class LightCommandProducer {
+  /**
+   * @param {{ memory: WebAssembly.Memory, queue: number, producer: number }} info
+   *   As returned by ClusterLightingSystem.createLightCommandProducer()
+   */
+  constructor({ memory, queue, producer }) {
+    this.memory = memory;
+    this.queue = queue;
+    this.producer = producer & 0xFF;
+    this.order = 0;
+    this._bind();
+  }
+
+  // (Re)create the views; memory growth replaces the buffer
+  _bind() {
+    const buffer = this.memory.buffer;
+    this._i32 = new Int32Array(buffer);
+    this._u32 = new Uint32Array(buffer);
+    this._f32 = new Float32Array(buffer);
+    this._base = this.queue >> 2;
+    this._mask = this._u32[this._base + MASK];
+  }
+
+  // Claim a slot, fill it and publish it. Returns false if the ring is full.
+  push(op, type, index, a = 0, b = 0, c = 0, d = 0, bits = false) {
+    if (this._i32.buffer !== this.memory.buffer) this._bind();
+    const i32 = this._i32;
+    const tail = this._base + TAIL;
+
+    let pos = Atomics.load(i32, tail);
+    let slot;
+    for (;;) {
+      slot = this._base + SLOTS + (pos & this._mask) * SLOT_WORDS;
+      const diff = (Atomics.load(i32, slot) - pos) | 0;
+      if (diff === 0) {
+        const seen = Atomics.compareExchange(i32, tail, pos, (pos + 1) | 0);
+        if (seen === pos) break;
+        pos = seen;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = Atomics.load(i32, tail);
+      }
+    }
+
+    i32[slot + 1] = index;
+    this._u32[slot + 2] = (op & 0xFF) | ((typeof type === 'string' ? LightTypeIds[type] : type) << 8) | (this.producer << 16);
+    this._u32[slot + 3] = this.order;
+    if (bits) {
+      this._u32[slot + 4] = a >>> 0;
+    } else {
+      const f32 = this._f32;
+      f32[slot + 4] = a;
+      f32[slot + 5] = b;
+      f32[slot + 6] = c;
+      f32[slot + 7] = d;
+    }
+    Atomics.store(i32, slot, (pos + 1) | 0);
+    this.order = (this.order + 1) >>> 0;
+    return true;
+  }
+
+  setPosition(type, index, x, y, z) { return this.push(LightCommand.POSITION, type, index, x, y, z); }
+  setColor(type, index, r, g, b) { return this.push(LightCommand.COLOR, type, index, r, g, b); }
+  setIntensity(type, index, intensity) { return this.push(LightCommand.INTENSITY, type, index, intensity); }
+  setRadius(type, index, radius) { return this.push(LightCommand.RADIUS, type, index, radius); }
+  setDecay(type, index, decay) { return this.push(LightCommand.DECAY, type, index, decay); }
+  setVisible(type, index, visible) { return this.push(LightCommand.VISIBILITY, type, index, visible ? 1 : 0, 0, 0, 0, true); }
+  // Spot direction or rect normal
+  setDirection(type, index, x, y, z) { return this.push(LightCommand.DIRECTION, type, index, x, y, z); }
+  setLayers(type, index, layers) { return this.push(LightCommand.LAYERS, type, index, layers, 0, 0, 0, true); }
+  setGroupMask(type, index, mask) { return this.push(LightCommand.GROUP_MASK, type, index, mask, 0, 0, 0, true); }
+}
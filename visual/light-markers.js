@@ -1,5 +1,6 @@
 // light-markers.js - Three.js visual markers for clustered lights
-import { ShaderMaterial, AdditiveBlending, DoubleSide, PlaneGeometry, Mesh, Group, Vector3 } from 'three';
+import { ShaderMaterial, AdditiveBlending, DoubleSide, PlaneGeometry, InstancedBufferAttribute, DynamicDrawUsage, Mesh, Group, Vector3 } from 'three';
+import { cluster_oct_decode } from '../core/cluster-shaders.js';
 
 export class LightMarkers {
   constructor(lightsSystem, options = {}) {
@@ -29,7 +30,8 @@ export class LightMarkers {
       side: DoubleSide,
       uniforms: {
         lightTexture: { value: null },
-        lightTextureWidth: { value: 2048 },
+        lightRowShift: { value: 9 },
+        lightRowBase: { value: 0 },
         showGlow: { value: this.showGlow },
         glowRadius: { value: this.pointGlowRadius },
         colorOverride: { value: this.colorOverride },
@@ -37,35 +39,27 @@ export class LightMarkers {
       },
       vertexShader: `
         uniform sampler2D lightTexture;
-        uniform int lightTextureWidth;
+        uniform int lightRowShift;
+        uniform int lightRowBase; // First row of this type's records (unified texture)
         uniform float markerScale;
+        attribute float lightIndex;
         varying vec4 vColor;
         varying vec3 vPosition;
         varying float vVisibility;
         varying float vLOD;
 
         void main() {
-          float lightIdx = float(gl_InstanceID);
-          float baseTexel = lightIdx * 2.0;
-          float width = float(lightTextureWidth);
-          int row = int(floor(baseTexel / width));
-          int col = int(baseTexel - float(row) * width);
-          ivec2 posCoord = ivec2(col, row);
-
-          float nextTexel = baseTexel + 1.0;
-          int nextRow = int(floor(nextTexel / width));
-          int nextCol = int(nextTexel - float(nextRow) * width);
-          ivec2 colorCoord = ivec2(nextCol, nextRow);
-
-          vec4 posRadius = texelFetch(lightTexture, posCoord, 0);
-          vec4 colorDecayVisible = texelFetch(lightTexture, colorCoord, 0);
-
-          float packedValue = colorDecayVisible.w;
-          float decay = floor(packedValue * 0.01) * 0.1;
-          float visible = mod(floor(packedValue * 0.1), 2.0);
-          float lod = mod(packedValue, 10.0);
-
-          vColor = vec4(colorDecayVisible.rgb, -posRadius.z);
+          int idx = int(lightIndex);
+          ivec2 posCoord = ivec2((idx & ((1 << lightRowShift) - 1)) * 3, lightRowBase + (idx >> lightRowShift));
+          vec4 posInvRadius = texelFetch(lightTexture, posCoord, 0);
+          vec4 colorDecayVisible = texelFetch(lightTexture, posCoord + ivec2(1, 0), 0);
+
+          // Packed word: bits 0-1 LOD, bit 2 visible
+          uint lightBits = uint(colorDecayVisible.w);
+          float visible = float((lightBits >> 2u) & 1u);
+          float lod = float(lightBits & 3u);
+
+          vColor = vec4(colorDecayVisible.rgb, -posInvRadius.z);
           vPosition = position.xyz;
           vVisibility = visible;
           vLOD = lod;
@@ -74,11 +68,11 @@ export class LightMarkers {
           if (lod < 1.5) lodScale = 0.5;
           else if (lod < 2.5) lodScale = 0.75;
 
-          float scale = posRadius.w * markerScale * lodScale;
+          float scale = posInvRadius.w > 0.0 ? markerScale * lodScale / posInvRadius.w : 0.0;
           vec3 transformedPosition = position.xyz * scale;
 
-          // posRadius.xyz is already in view space
-          gl_Position = projectionMatrix * vec4(transformedPosition + posRadius.xyz, 1.);
+          // posInvRadius.xyz is already in view space
+          gl_Position = projectionMatrix * vec4(transformedPosition + posInvRadius.xyz, 1.);
         }
       `,
       fragmentShader: `
@@ -125,10 +119,15 @@ export class LightMarkers {
         lightTexture: { value: null },
         showGlow: { value: this.showGlow },
         glowRadius: { value: this.spotGlowRadius },
-        colorOverride: { value: this.colorOverride }
+        colorOverride: { value: this.colorOverride },
+        lightRowShift: { value: 9 },
+        lightRowBase: { value: 0 }
       },
       vertexShader: `
         uniform sampler2D lightTexture;
+        uniform int lightRowShift;
+        uniform int lightRowBase; // First row of this type's records (unified texture)
+        attribute float lightIndex;
         varying vec4 vColor;
         varying vec3 vPosition;
         varying vec2 vAngle;
@@ -136,26 +135,27 @@ export class LightMarkers {
         varying float vLOD;
 
         void main() {
-          int lightIndex = gl_InstanceID * 4;
-          vec4 posRadius = texelFetch(lightTexture, ivec2(lightIndex, 0), 0);
-          vec4 colorIntensity = texelFetch(lightTexture, ivec2(lightIndex + 1, 0), 0);
-          vec4 angleParams = texelFetch(lightTexture, ivec2(lightIndex + 3, 0), 0);
+          int idx = int(lightIndex);
+          ivec2 base = ivec2((idx & ((1 << lightRowShift) - 1)) * 3, lightRowBase + (idx >> lightRowShift));
+          vec4 posInvRadius = texelFetch(lightTexture, base, 0);
+          vec4 colorIntensity = texelFetch(lightTexture, base + ivec2(1, 0), 0);
+          vec4 angleParams = texelFetch(lightTexture, base + ivec2(2, 0), 0);
 
-          float packedValue = angleParams.w;
-          float visible = floor(packedValue * 0.1);
-          float lod = mod(packedValue, 10.0);
+          uint lightBits = uint(angleParams.w);
+          float visible = float((lightBits >> 2u) & 1u);
+          float lod = float(lightBits & 3u);
 
-          vColor = vec4(colorIntensity.rgb, -posRadius.z);
+          vColor = vec4(colorIntensity.rgb, -posInvRadius.z);
           vPosition = position.xyz;
           vAngle = angleParams.xy;
           vVisibility = visible;
           vLOD = lod;
 
           float lodScale = lod < 1.5 ? 0.5 : (lod < 2.5 ? 0.75 : 1.0);
-          float scale = posRadius.w * 0.08 * lodScale;
+          float scale = posInvRadius.w > 0.0 ? 0.08 * lodScale / posInvRadius.w : 0.0;
           vec3 transformedPosition = position.xyz * scale;
 
-          gl_Position = projectionMatrix * vec4(transformedPosition + posRadius.xyz, 1.);
+          gl_Position = projectionMatrix * vec4(transformedPosition + posInvRadius.xyz, 1.);
         }
       `,
       fragmentShader: `
@@ -199,28 +199,39 @@ export class LightMarkers {
         lightTexture: { value: null },
         showGlow: { value: this.showGlow },
         glowRadius: { value: this.rectGlowRadius },
-        colorOverride: { value: this.colorOverride }
+        colorOverride: { value: this.colorOverride },
+        lightRowShift: { value: 9 },
+        lightRowBase: { value: 0 }
       },
       vertexShader: `
         uniform sampler2D lightTexture;
+        uniform int lightRowShift;
+        uniform int lightRowBase; // First row of this type's records (unified texture)
+        attribute float lightIndex;
         varying vec4 vColor;
         varying vec3 vPosition;
         varying vec2 vSize;
         varying float vVisibility;
         varying float vLOD;
 
+        ${cluster_oct_decode}
+
         void main() {
-          int lightIndex = gl_InstanceID * 4;
-          vec4 posRadius = texelFetch(lightTexture, ivec2(lightIndex, 0), 0);
-          vec4 colorIntensity = texelFetch(lightTexture, ivec2(lightIndex + 1, 0), 0);
-          vec4 sizeParams = texelFetch(lightTexture, ivec2(lightIndex + 2, 0), 0);
-          vec4 normal = texelFetch(lightTexture, ivec2(lightIndex + 3, 0), 0);
+          // RectLightData is 4 texels per light
+          int idx = int(lightIndex);
+          ivec2 base = ivec2((idx & ((1 << lightRowShift) - 1)) * 4, lightRowBase + (idx >> lightRowShift));
+          vec4 posInvRadius = texelFetch(lightTexture, base, 0);
+          vec4 colorIntensity = texelFetch(lightTexture, base + ivec2(1, 0), 0);
+          vec4 sizeParams = texelFetch(lightTexture, base + ivec2(2, 0), 0);
 
-          float packedValue = sizeParams.w;
-          float visible = floor(packedValue * 0.1);
-          float lod = mod(packedValue, 10.0);
+          vec3 normal = clusterOctDecode(sizeParams.z);
 
-          vColor = vec4(colorIntensity.rgb, -posRadius.z);
+          uint lightBits = uint(sizeParams.w);
+          float visible = float((lightBits >> 2u) & 1u);
+          float lod = float(lightBits & 3u);
+
+          // Rect colours arrive scaled by the light's area
+          vColor = vec4(colorIntensity.rgb / max(sizeParams.x * sizeParams.y, 1e-6), -posInvRadius.z);
           vPosition = position.xyz;
           vSize = sizeParams.xy;
           vVisibility = visible;
@@ -248,7 +259,7 @@ export class LightMarkers {
                                     y_axis * localPos.y +
                                     z_axis * localPos.z * 0.1;
 
-          gl_Position = projectionMatrix * vec4(transformedPosition + posRadius.xyz, 1.);
+          gl_Position = projectionMatrix * vec4(transformedPosition + posInvRadius.xyz, 1.);
         }
       `,
       fragmentShader: `
@@ -280,115 +291,106 @@ export class LightMarkers {
     });
   }
 
-  // Initialize light source meshes (call after lights are added)
-  init(scene) {
-    // Use WASM counts, not JS array lengths (arrays may be stale)
-    const pointCount = this.lightsSystem.wasm.exports.getPointLightCount();
-    const spotCount = this.lightsSystem.wasm.exports.getSpotLightCount();
-    const rectCount = this.lightsSystem.wasm.exports.getRectLightCount();
-
-    // Add group to scene
-    this.group.visible = this.visible;
-    scene.add(this.group);
-
-    // Create point light visualization
-    if (pointCount > 0) {
-      const geometry = new PlaneGeometry(1, 1);
-      geometry.isInstancedBufferGeometry = true;
-      geometry.instanceCount = pointCount;
-      this.geometries.point = geometry;
-
-      const material = this.createPointLightMaterial();
-      this.materials.point = material;
-
-      // Set initial texture if available
-      if (this.lightsSystem.pointLightTexture.value) {
-        material.uniforms.lightTexture.value = this.lightsSystem.pointLightTexture.value;
-        material.uniforms.lightTextureWidth.value = this.lightsSystem.lightTextureWidth;
-        material.uniformsNeedUpdate = true;
-      }
+  // Create the instanced marker mesh for one light type. Instances are drawn
+  // through a per-instance lightIndex attribute sized for maxSafeLights, so the
+  // visible set can change every frame without re-creating geometry.
+  createTypeMesh(type) {
+    const geometry = new PlaneGeometry(1, 1);
+    geometry.isInstancedBufferGeometry = true;
+    geometry.instanceCount = 0;
+
+    const indices = new InstancedBufferAttribute(new Float32Array(this.lightsSystem.maxSafeLights), 1);
+    indices.setUsage(DynamicDrawUsage);
+    geometry.setAttribute('lightIndex', indices);
+    this.geometries[type] = geometry;
+
+    const material = type === 'spot' ? this.createSpotLightMaterial() :
+                     type === 'rect' ? this.createRectLightMaterial() :
+                     this.createPointLightMaterial();
+    this.materials[type] = material;
+
+    const mesh = new Mesh(geometry, material);
+    mesh.frustumCulled = false;
+    mesh.renderOrder = 1000;
+    this.meshes[type] = mesh;
+    this.group.add(mesh);
+  }
 
-      const mesh = new Mesh(geometry, material);
-      mesh.frustumCulled = false;
-      mesh.renderOrder = 1000;
-      this.meshes.point = mesh;
-      this.group.add(mesh);
+  // Point the instance attribute at the lights the core rendered last update.
+  // Falls back to drawing every light (shader discards hidden ones) when the
+  // loaded WASM build has no visible-index export.
+  updateInstances(type, count) {
+    const geometry = this.geometries[type];
+    const attribute = geometry.attributes.lightIndex;
+    const array = attribute.array;
+    const visible = this.lightsSystem.getVisibleLightIndices(type);
+
+    let instanceCount;
+    if (visible) {
+      instanceCount = Math.min(visible.length, array.length);
+      for (let i = 0; i < instanceCount; i++) array[i] = visible[i];
+    } else {
+      instanceCount = Math.min(count, array.length);
+      if (instanceCount === geometry.instanceCount) return;
+      for (let i = 0; i < instanceCount; i++) array[i] = i;
     }
 
-    // Create spot light visualization
-    if (spotCount > 0) {
-      const geometry = new PlaneGeometry(1, 1);
-      geometry.isInstancedBufferGeometry = true;
-      geometry.instanceCount = spotCount;
-      this.geometries.spot = geometry;
-
-      const material = this.createSpotLightMaterial();
-      this.materials.spot = material;
-
-      // Set initial texture if available
-      if (this.lightsSystem.spotLightTexture.value) {
-        material.uniforms.lightTexture.value = this.lightsSystem.spotLightTexture.value;
-        material.uniformsNeedUpdate = true;
-      }
-
-      const mesh = new Mesh(geometry, material);
-      mesh.frustumCulled = false;
-      mesh.renderOrder = 1000;
-      this.meshes.spot = mesh;
-      this.group.add(mesh);
+    geometry.instanceCount = instanceCount;
+    if (instanceCount > 0) {
+      attribute.clearUpdateRanges();
+      attribute.addUpdateRange(0, instanceCount);
+      attribute.needsUpdate = true;
     }
+  }
 
-    // Create rect light visualization
-    if (rectCount > 0) {
-      const geometry = new PlaneGeometry(1, 1);
-      geometry.isInstancedBufferGeometry = true;
-      geometry.instanceCount = rectCount;
-      this.geometries.rect = geometry;
-
-      const material = this.createRectLightMaterial();
-      this.materials.rect = material;
-
-      // Set initial texture if available
-      if (this.lightsSystem.rectLightTexture.value) {
-        material.uniforms.lightTexture.value = this.lightsSystem.rectLightTexture.value;
-        material.uniformsNeedUpdate = true;
-      }
+  // Initialize light source meshes. Types with no lights yet are created
+  // lazily by update() once lights of that type are added.
+  init(scene) {
+    // Add group to scene
+    this.group.visible = this.visible;
+    scene.add(this.group);
 
-      const mesh = new Mesh(geometry, material);
-      mesh.frustumCulled = false;
-      mesh.renderOrder = 1000;
-      this.meshes.rect = mesh;
-      this.group.add(mesh);
-    }
+    this.update(scene);
   }
 
-  // Update uniforms every frame
+  // Update instances and uniforms every frame
   update(scene) {
-    // Update point light texture
-    if (this.materials.point && this.lightsSystem.pointLightTexture.value) {
-      const texture = this.lightsSystem.pointLightTexture.value;
-      if (this.materials.point.uniforms.lightTexture.value !== texture) {
-        this.materials.point.uniforms.lightTexture.value = texture;
-        this.materials.point.uniformsNeedUpdate = true;
+    const exports = this.lightsSystem.wasm.exports;
+    const system = this.lightsSystem;
+    const unified = system.unifiedLights ? system.lightTexture.value : null;
+    const textures = {
+      point: unified || system.pointLightTexture.value,
+      spot: unified || system.spotLightTexture.value,
+      rect: unified || system.rectLightTexture.value
+    };
+    const rowBases = {
+      point: 0,
+      spot: unified ? system.lightRowBases.value.x : 0,
+      rect: unified ? system.lightRowBases.value.y : 0
+    };
+    // Use WASM counts, not JS array lengths (arrays may be stale)
+    const counts = {
+      point: exports.getPointLightCount(),
+      spot: exports.getSpotLightCount(),
+      rect: exports.getRectLightCount()
+    };
+
+    for (const type of ['point', 'spot', 'rect']) {
+      if (!this.meshes[type]) {
+        if (counts[type] === 0) continue;
+        this.createTypeMesh(type);
       }
-    }
 
-    // Update spot light texture
-    if (this.materials.spot && this.lightsSystem.spotLightTexture.value) {
-      const texture = this.lightsSystem.spotLightTexture.value;
-      if (this.materials.spot.uniforms.lightTexture.value !== texture) {
-        this.materials.spot.uniforms.lightTexture.value = texture;
-        this.materials.spot.uniformsNeedUpdate = true;
+      const material = this.materials[type];
+      const texture = textures[type];
+      if (texture && material.uniforms.lightTexture.value !== texture) {
+        material.uniforms.lightTexture.value = texture;
+        material.uniformsNeedUpdate = true;
       }
-    }
+      material.uniforms.lightRowShift.value = system[`${type}LightRowShift`].value;
+      material.uniforms.lightRowBase.value = rowBases[type];
 
-    // Update rect light texture
-    if (this.materials.rect && this.lightsSystem.rectLightTexture.value) {
-      const texture = this.lightsSystem.rectLightTexture.value;
-      if (this.materials.rect.uniforms.lightTexture.value !== texture) {
-        this.materials.rect.uniforms.lightTexture.value = texture;
-        this.materials.rect.uniformsNeedUpdate = true;
-      }
+      this.updateInstances(type, counts[type]);
     }
 
     // Update other uniforms for all materials
@@ -3,7 +3,13 @@
 #include <string.h>
 #include <math.h>
 #include <stdint.h>
+#include <stddef.h>
+
+#ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
+#else
+#define EMSCRIPTEN_KEEPALIVE __attribute__((used))
+#endif
 
 #ifdef __wasm_simd128__
 #include <wasm_simd128.h>
@@ -110,6 +116,10 @@ typedef struct {
     RotationParams rotation;
 } AnimationParams;
 
+// Shadow atlas node ids stored per light
+#define SHADOW_CUBE_FACES 6
+#define SHADOW_NODE_NONE  0xFFFFu
+
 // Optimized light structures with LOD support
 typedef struct {
     Vec4 baseWorldPos;  // Static position for Morton ordering
@@ -121,11 +131,18 @@ typedef struct {
     AnimationParams anim;
     float decay;
     uint32_t morton;    // ONLY calculated from baseWorldPos
+    uint32_t groupMask; // Light group membership: bit g = member of group g
+    uint32_t order;     // Index the host last saw (see syncLightOrder)
     uint8_t dirty;
     uint8_t visible;
     uint8_t lodLevel;   // LOD level: 0=skip, 1=simple, 2=medium, 3=full
+    uint8_t visState;   // Last published visibility state (see VIS_STATE_*)
+    uint8_t layerMask;  // Light layers: bit n = layer n (see PACK_LAYER_*)
     uint8_t castsShadow;     // Shadow flag: 0=no shadow, 1=casts shadow
+    uint8_t shadowSelected;  // Picked as a shadow caster last frame (hysteresis)
+    uint8_t resort;          // Key changed inside the sorted prefix (see EXTRACT_MOVED)
     float shadowIntensity;   // 0=pitch black, 1=no shadow
+    uint16_t shadowNodes[SHADOW_CUBE_FACES]; // Atlas nodes from last frame's plan (SHADOW_NODE_NONE = none)
 } PointLight;
 
 typedef struct {
@@ -133,6 +150,7 @@ typedef struct {
     Vec4 animOffset;    // Dynamic offset calculated each frame
     Vec4 worldPos;      // baseWorldPos + animOffset
     Vec4 color;         // rgb = color, w = intensity
+    Vec4 baseColor;     // rgb = base color, w = base intensity
     Vec4 direction;     // xyz = direction, w = unused
     Vec4 viewPos;       // xyz = view position, w = radius
     Vec4 viewDir;       // xyz = view direction, w = unused
@@ -142,11 +160,18 @@ typedef struct {
     float angle;
     float penumbra;
     uint32_t morton;
+    uint32_t groupMask; // Light group membership
+    uint32_t order;     // Index the host last saw (see syncLightOrder)
     uint8_t dirty;
     uint8_t visible;
     uint8_t lodLevel;   // LOD level
+    uint8_t visState;   // Last published visibility state (see VIS_STATE_*)
+    uint8_t layerMask;  // Light layers: bit n = layer n (see PACK_LAYER_*)
     uint8_t castsShadow;     // Shadow flag: 0=no shadow, 1=casts shadow
+    uint8_t shadowSelected;  // Picked as a shadow caster last frame (hysteresis)
+    uint8_t resort;          // Key changed inside the sorted prefix (see EXTRACT_MOVED)
     float shadowIntensity;   // 0=pitch black, 1=no shadow
+    uint16_t shadowNodes[1]; // Atlas node from last frame's plan
 } SpotLight;
 
 typedef struct {
@@ -154,6 +179,7 @@ typedef struct {
     Vec4 animOffset;    // Dynamic offset calculated each frame
     Vec4 worldPos;      // baseWorldPos + animOffset
     Vec4 color;         // rgb = color, w = intensity
+    Vec4 baseColor;     // rgb = base color, w = base intensity
     Vec4 size;          // x = width, y = height, z,w = unused
     Vec4 normal;        // xyz = normal, w = unused
     Vec4 tangent;       // xyz = tangent (right direction), w = unused
@@ -167,34 +193,97 @@ typedef struct {
     AnimationParams anim;
     float decay;
     uint32_t morton;
+    uint32_t groupMask; // Light group membership
+    uint32_t order;     // Index the host last saw (see syncLightOrder)
     uint8_t dirty;
     uint8_t visible;
     uint8_t lodLevel;   // LOD level
+    uint8_t visState;   // Last published visibility state (see VIS_STATE_*)
+    uint8_t layerMask;  // Light layers: bit n = layer n (see PACK_LAYER_*)
     uint8_t castsShadow;     // Shadow flag: 0=no shadow, 1=casts shadow
+    uint8_t shadowSelected;  // Picked as a shadow caster last frame (hysteresis)
+    uint8_t resort;          // Key changed inside the sorted prefix (see EXTRACT_MOVED)
     float shadowIntensity;   // 0=pitch black, 1=no shadow
+    uint16_t shadowNodes[1]; // Atlas node from last frame's plan
 } RectLight;
 
-// Optimized texture data structures with LOD info
+// Optimized texture data structures with LOD info. Every record starts with
+// the view position and the inverse radius (0 for a radius of 0), and carries
+// the decay term its shader uses as a plain float, so fragments neither
+// divide by the radius nor decode the decay from the packed word.
 typedef struct {
-    Vec4 positionRadius;    // xyz = position, w = radius
-    Vec4 colorDecayVisible; // rgb = color * intensity, w = packed(decay, visible, lod)
+    Vec4 positionInvRadius; // xyz = position, w = 1 / radius
+    Vec4 colorDecayVisible; // rgb = color * intensity, w = packed(decay, visible, lod, layers)
+    Vec4 falloff;           // x = decay rate (decay * 0.1), yzw unused
 } PointLightDataOptimized;
 
+// Spot and rect unit vectors are stored octahedral-encoded (packOctahedral)
+// in a spare channel, which keeps spot records at three texels.
 typedef struct {
-    Vec4 positionRadius;  // xyz = position, w = radius
-    Vec4 colorIntensity;  // rgb = color, w = intensity
-    Vec4 direction;       // xyz = direction, w = unused
-    Vec4 angleParams;     // x = cos(angle), y = cos(penumbra), z = decay, w = packed(visible, lod)
+    Vec4 positionInvRadius; // xyz = position, w = 1 / radius
+    Vec4 colorDecay;        // rgb = color * intensity, w = decay
+    Vec4 angleParams;       // x = cos(angle), y = cos(penumbra), z = octahedral direction, w = packed(decay, visible, lod, layers)
 } SpotLightData;
 
 typedef struct {
-    Vec4 positionRadius;  // xyz = position, w = radius
-    Vec4 colorIntensity;  // rgb = color, w = intensity
-    Vec4 sizeParams;      // xy = size, z = decay, w = packed(visible, lod)
-    Vec4 normal;          // xyz = normal, w = unused
-    Vec4 tangent;         // xyz = tangent (right direction), w = unused
+    Vec4 positionInvRadius; // xyz = position, w = 1 / radius
+    Vec4 colorTangent;      // rgb = color * intensity * area, w = octahedral tangent (right direction)
+    Vec4 sizeParams;        // xy = size, z = octahedral normal, w = packed(decay, visible, lod, layers)
+    Vec4 falloff;           // x = decay rate (decay * 0.1), yzw unused
 } RectLightData;
 
+// Static point lights (see STATIC POINT LIGHTS): a compact pool for lights
+// that never animate, about 1/9 the size of a PointLight. Positions are 16-bit
+// offsets within a cell of up to STATIC_CELL_LIGHTS spatially adjacent lights
+// that share an origin and scale.
+#define STATIC_CELL_LIGHTS 256
+#define STATIC_MAX_CELLS 65535
+#define STATIC_QUANT_MAX 32767
+#define STATIC_INPUT_FLOATS 8   // x, y, z, radius, r, g, b (premultiplied), decay
+
+typedef struct {
+    int16_t pos[3];     // World position = cell origin + pos * cell scale
+    uint16_t pad;
+    float radius;
+    float color[3];     // rgb * intensity
+    float params;       // packLightParams(decay, visible, LOD_SKIP, layers); LOD added per frame
+} StaticPointLight;
+
+typedef struct {
+    Vec4 origin;        // xyz = cell centre, w = quantisation step
+    uint32_t first;     // First pool index in the cell
+    uint32_t count;
+} StaticCell;
+
+// Texture records are laid out row-major in rows of a power-of-two number of
+// lights, so no record straddles a row and the host addresses them with
+// shifts and masks. Buffers are rounded up to whole rows of this many lights,
+// so every row width up to it can be uploaded without a copy.
+#define LIGHT_TEXTURE_ROW_ALIGN 1024
+
+// Version of the texture record layouts and the packed parameter word. The
+// host refuses a core that reports a different version (or none), so stale
+// prebuilt binaries fail loudly instead of feeding the shaders garbage.
+// Bump it whenever a record layout changes.
+#define TEXTURE_LAYOUT_VERSION 4
+
+// Unified light texture (setUnifiedLightTexture): every type in one texture
+// of UNIFIED_ROW_TEXELS-wide rows, points first, then spots and rects, each
+// type starting on a new row. A row holds 512 records of any type (point and
+// spot rows use 1536 of the 2048 texels).
+#define UNIFIED_ROW_TEXELS 2048
+#define UNIFIED_POINT_SHIFT 9
+#define UNIFIED_SPOT_SHIFT 9
+#define UNIFIED_RECT_SHIFT 9
+
+// Record i of a unified region whose rows are wider than their records
+#define UNIFIED_RECORD(type, base, i, shift) \
+    ((type*)((Vec4*)(base) + (size_t)((i) >> (shift)) * UNIFIED_ROW_TEXELS) + ((i) & ((1 << (shift)) - 1)))
+
+// Point record i (dynamic, then static) in either texture mode
+#define POINT_RECORD(i) \
+    (unifiedLights ? UNIFIED_RECORD(PointLightDataOptimized, pointRecords, i, UNIFIED_POINT_SHIFT) : &pointRecords[i])
+
 // ──────────────────────────────────────────────────────────────
 //                       GLOBAL STATE
 // ──────────────────────────────────────────────────────────────
@@ -205,21 +294,118 @@ static RectLight *rectLights = NULL;
 static PointLight *pointLightsScratch = NULL;
 static SpotLight *spotLightsScratch = NULL;
 static RectLight *rectLightsScratch = NULL;
+static uint64_t *sortKeys = NULL;      // 2 * maxLights (morton << 32 | index) pairs
 
 static PointLightDataOptimized *pointLightTexture = NULL;
 static SpotLightData *spotLightTexture = NULL;
 static RectLightData *rectLightTexture = NULL;
 
+// Where the pack stage writes records: the per-type buffers above, or their
+// regions of unifiedLightTexture (bound at the start of each update)
+static PointLightDataOptimized *pointRecords = NULL;
+static SpotLightData *spotRecords = NULL;
+static RectLightData *rectRecords = NULL;
+
+static Vec4 *unifiedLightTexture = NULL; // One texel per Vec4, UNIFIED_ROW_TEXELS per row
+static int unifiedRowCapacity = 0;
+static int unifiedLights = 0;            // setUnifiedLightTexture
+static int32_t unifiedLayout[7];         // Row texels, first spot row, first rect row, rows used,
+                                         // then the point, spot and rect row shifts
+
 static Mat4 *cameraMatrix = NULL;
 
 static int pointLightCount = 0;
 static int spotLightCount = 0;
 static int rectLightCount = 0;
 static int maxLights = 0;
+static int pointLightLimit = 0;        // Dynamic point lights: maxLights less the reserved static lights
+static int lightTextureCapacity = 0;   // Records per texture buffer (whole rows)
+
+// Static point pool; its records follow the dynamic point records
+static StaticPointLight *staticPointLights = NULL;
+static StaticCell *staticCells = NULL;
+static int staticPointCount = 0;
+static int staticPointCapacity = 0;
+static int staticCellCount = 0;
+static int staticCellCapacity = 0;
 
 static int hasAnimatedLights = 0;
 static int needsSort = 0;
 
+// Incremental sort and host index sync, per light type. [0, sortedCount) is
+// known to be in Morton order; records from orderStamped on were appended
+// since the last reorder and still sit at the index the host was given.
+static int sortedCount[3];
+static int orderStamped[3];
+static uint32_t prefixMoved = 0;       // Bit per type with resort-flagged prefix records
+static uint32_t orderChanged = 0;      // Bit per type with an unsynced reorder
+static uint32_t *lightOrder = NULL;    // Previous index per current index (syncLightOrder)
+static uint32_t *patchIndices = NULL;  // Host-written indices for removeLights
+static float *patchVectors = NULL;     // Host-written xyz per patch index (updateRectLightNormals)
+
+// Replication deltas (see LIGHT STATE DELTAS; allocated on first use)
+static int32_t *deltaSnapshots[3] = {NULL, NULL, NULL}; // Quantised fields last sent/applied, per light
+static int deltaCounts[3];             // Light counts as of the last encode/apply
+static int deltaKeyframe = 0;          // Next encode diffs against an empty scene
+static uint8_t *deltaBuffer = NULL;    // Encoded output
+static int deltaCapacity = 0;
+static int deltaSize = 0;
+static uint8_t *deltaInput = NULL;     // Host-written input for applyLightDelta
+static int deltaInputCapacity = 0;
+
+// Multi-producer command queue (see LIGHT COMMAND QUEUE; allocated on first use)
+typedef struct {
+    uint32_t seq;       // Slot sequence: position when free, position + 1 once written
+    int32_t index;      // Light index within its type array
+    uint8_t op;         // LIGHT_CMD_*
+    uint8_t type;       // 0=point, 1=spot, 2=rect
+    uint8_t producer;   // Producer id; commands apply in (producer, order) order
+    uint8_t pad;
+    uint32_t order;     // Producer's own running command count
+    union { float f[4]; uint32_t u[4]; } v;
+} LightCommand;
+
+typedef struct {
+    uint32_t tail;      // Next position to claim (producers, CAS)
+    uint32_t mask;      // Slot count - 1
+    uint32_t pad0[14];  // Keep producers and the consumer on separate cache lines
+    uint32_t head;      // Next position to drain (update only)
+    uint32_t applied;   // Commands applied by the last drain
+    uint32_t pad1[14];
+    LightCommand slots[];
+} LightCommandQueue;
+
+static LightCommandQueue *commandQueue = NULL;
+static LightCommand *commandScratch = NULL;
+static void drainLightCommands(void);
+
+// Procedural generators (see LIGHT GENERATORS)
+typedef struct {
+    float radius[2];           // min, max
+    float intensity[2];
+    float decay;
+    float animWeights[5];      // Relative odds: none, circular, wave, flicker, pulse
+    float circularSpeed[2];
+    float circularRadius[2];
+    float waveSpeed[2];
+    float waveAmplitude[2];
+    float waveAxis[3];         // Zero vector = random axis per light
+    float flickerSpeed[2];
+    float flickerIntensity[2];
+    float pulseSpeed[2];
+    float pulseAmount[2];
+    float pulseTarget;         // PULSE_* bits
+    float paletteBlend;        // 0 = pick a palette entry, 1 = lerp between neighbours
+    int32_t paletteCount;      // rgb triples at the start of the generator input
+    uint32_t groupMask;
+    uint32_t layerMask;
+} LightGenStyle;
+
+static float *genInput = NULL;         // Host-written palette + shape data
+static int genInputCapacity = 0;       // In floats
+static uint32_t *genIndexInput = NULL; // Host-written mesh indices
+static int genIndexCapacity = 0;       // In indices
+
 // Fast path flags
 static int hasPointLights = 0;
 static int hasSpotLights = 0;
@@ -227,10 +413,18 @@ static int hasRectLights = 0;
 
 // Cached view matrix elements
 static float e0,e1,e2,e4,e5,e6,e8,e9,e10,e12,e13,e14;
+static int viewRigid = 0;  // Upper 3x3 is a rotation: unit directions stay unit
 
 // SIMD cached elements
 #ifdef __wasm_simd128__
 static v128_t e0v, e1v, e2v, e4v, e5v, e6v, e8v, e9v, e10v, e12v, e13v, e14v;
+
+// One row of the view transform for 4 lights: a * x + b * y + c * z + d
+ALWAYS_INLINE static v128_t transformRowSIMD(v128_t a, v128_t b, v128_t c, v128_t d,
+                                             v128_t x, v128_t y, v128_t z) {
+    return wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(a, x), wasm_f32x4_mul(b, y)),
+                          wasm_f32x4_add(wasm_f32x4_mul(c, z), d));
+}
 #endif
 
 // View frustum parameters
@@ -240,12 +434,104 @@ static float viewFar = 1000.0f;
 // LOD settings (always enabled)
 static float lodBias = 1.0f;  // Global LOD bias multiplier
 
+// Visibility tracking: one bit per light and type (1 = rendered this frame)
+// plus a list of lights whose visibility or LOD changed during the last update()
+static uint32_t *pointVisibilityBits = NULL;
+static uint32_t *spotVisibilityBits = NULL;
+static uint32_t *rectVisibilityBits = NULL;
+static int visibilityWords = 0;
+
+typedef struct {
+    uint32_t index;     // Light index within its type array
+    uint8_t type;       // 0=point, 1=spot, 2=rect
+    uint8_t state;      // New state (VIS_STATE_*)
+    uint8_t prevState;  // State published by the previous update
+    uint8_t pad;
+} VisibilityChange;
+
+static VisibilityChange *visibilityChanges = NULL;
+static int visibilityChangeCount = 0;
+
+// Light groups: a light belongs to every group whose bit is set in its
+// groupMask. Group state is applied at pack time, so toggling or dimming a
+// group costs O(1) regardless of how many lights are in it.
+#define MAX_LIGHT_GROUPS 32
+
+static uint32_t disabledGroups = 0;   // Bit g set = group g disabled
+static uint32_t scaledGroups = 0;     // Bit g set = group g has non-identity tint/intensity
+static Vec4 groupScale[MAX_LIGHT_GROUPS]; // rgb = tint, w = intensity multiplier
+
+// Shadow caster selection: the top-N rendered shadow-casting lights by screen
+// importance, rebuilt each update() when the budget is non-zero
+#define MAX_SHADOW_CASTERS 64
+
+typedef struct {
+    Vec4 viewPos;           // xyz = view position, w = radius
+    Vec4 viewDir;           // xyz = spot direction / rect normal, w = spot angle (0 for others)
+    float score;            // Screen importance (hysteresis bonus included)
+    float shadowIntensity;  // 0=pitch black, 1=no shadow
+    uint32_t index;         // Light index within its type array
+    uint32_t type;          // 0=point, 1=spot, 2=rect
+} ShadowCaster;
+
+static ShadowCaster shadowCasters[MAX_SHADOW_CASTERS];
+static int shadowCasterCount = 0;
+static int shadowBudget = 0;            // 0 = selection disabled
+static float shadowHysteresis = 1.25f;  // Score multiplier for last frame's casters
+
+// Shadow atlas: a fixed-size square texture carved into power-of-two tiles by
+// a quadtree stored as a heap (children of node n are 4n+1..4n+4, so the
+// tiles of each level are laid out in Morton order).
+#define ATLAS_MAX_DEPTH 7
+#define ATLAS_MAX_NODES 21845   // (4^(ATLAS_MAX_DEPTH+1) - 1) / 3
+#define ATLAS_FREE    0
+#define ATLAS_PARTIAL 1
+#define ATLAS_FULL    2
+
+typedef struct {
+    uint16_t x, y;      // Texel origin in the atlas
+    uint16_t size;      // Tile edge in texels
+    uint8_t caster;     // Index into shadowCasters
+    uint8_t face;       // Cube face for point lights, 0 otherwise
+} ShadowTile;
+
+static uint8_t atlasState[ATLAS_MAX_NODES];
+static int atlasSize = 4096;
+static int atlasDepth = 5;              // atlasSize >> atlasDepth = minimum tile
+static int atlasReuse = 0;              // 0 after a config change: stored nodes are stale
+static float shadowTileScale = 1024.0f; // Tile texels per unit of radius/distance
+static ShadowTile shadowTiles[MAX_SHADOW_CASTERS * SHADOW_CUBE_FACES];
+static int shadowTileCount = 0;
+
+// Compacted visible-index lists (ascending type indices), built on request
+static uint32_t *pointVisibleList = NULL;
+static uint32_t *spotVisibleList = NULL;
+static uint32_t *rectVisibleList = NULL;
+
 // Dirty flags
 #define DIRTY_POSITION 1
 #define DIRTY_COLOR 2
 #define DIRTY_PARAMS 4
 #define DIRTY_ALL 7
 
+// Visibility state: bit 2 = rendered (visible, not culled, LOD above skip),
+// bits 0-1 = LOD level. Hidden lights always report 0.
+#define VIS_STATE_LOD_MASK 0x03
+#define VIS_STATE_RENDERED 0x04
+
+// Packed parameter word layout (see packLightParams)
+#define PACK_LOD_MASK      0x3u
+#define PACK_VISIBLE       0x4u
+#define PACK_LAYER_SHIFT   3
+#define PACK_DECAY_SHIFT   11
+#define PACK_DECAY_MAX     0x1FFFu
+#define PACK_DECAY_STEPS   64.0f
+#define PACK_LAYER_DEFAULT 0x01   // New lights are on layer 0
+
+#define LIGHT_TYPE_POINT 0
+#define LIGHT_TYPE_SPOT  1
+#define LIGHT_TYPE_RECT  2
+
 // ──────────────────────────────────────────────────────────────
 //                    FAST MATH & HELPERS
 // ──────────────────────────────────────────────────────────────
@@ -283,10 +569,14 @@ ALWAYS_INLINE static void worldToView(float x, float y, float z, float r, Vec4 *
     out->w = r;
 }
 
-ALWAYS_INLINE static void worldDirToView(const Vec4 *in, Vec4 *out) {
+ALWAYS_INLINE static void rotateDirToView(const Vec4 *in, Vec4 *out) {
     out->x = e0*in->x + e4*in->y + e8 *in->z;
     out->y = e1*in->x + e5*in->y + e9 *in->z;
     out->z = e2*in->x + e6*in->y + e10*in->z;
+}
+
+ALWAYS_INLINE static void worldDirToView(const Vec4 *in, Vec4 *out) {
+    rotateDirToView(in, out);
     float len = sqrtf(out->x*out->x + out->y*out->y + out->z*out->z);
     if (len > 0.f) { 
         float inv = 1.f/len; 
@@ -296,20 +586,49 @@ ALWAYS_INLINE static void worldDirToView(const Vec4 *in, Vec4 *out) {
     }
 }
 
-ALWAYS_INLINE static void rotateAroundAxis(Vec4 *v, const Vec4 *axis, float angle) {
+// Rotation about an axis as a 3x3 matrix, stored as columns (w = 0).
+// Rodrigues' formula v*c + (axis x v)*s + axis*(axis.v)*(1-c) in matrix
+// form, so a light evaluates sin/cos once for all the vectors it rotates.
+typedef struct { Vec4 col[3]; } RotationMatrix;
+
+ALWAYS_INLINE static void buildRotationMatrix(const Vec4 *a, float angle, RotationMatrix *r) {
     float c = cosf(angle);
     float s = sinf(angle);
-    float dot = v->x * axis->x + v->y * axis->y + v->z * axis->z;
+    float t = 1.0f - c;
+
+    r->col[0] = (Vec4){c + a->x * a->x * t, a->y * a->x * t + a->z * s, a->z * a->x * t - a->y * s, 0.0f};
+    r->col[1] = (Vec4){a->x * a->y * t - a->z * s, c + a->y * a->y * t, a->z * a->y * t + a->x * s, 0.0f};
+    r->col[2] = (Vec4){a->x * a->z * t + a->y * s, a->y * a->z * t - a->x * s, c + a->z * a->z * t, 0.0f};
+}
 
-    // Store original values before overwriting
-    float vx = v->x;
-    float vy = v->y;
-    float vz = v->z;
+// Rotate v in place; w (radius for positions) is kept
+ALWAYS_INLINE static void applyRotation(const RotationMatrix *r, Vec4 *v) {
+#ifdef __wasm_simd128__
+    v128_t out = wasm_f32x4_add(
+        wasm_f32x4_add(wasm_f32x4_mul(wasm_v128_load(&r->col[0]), wasm_f32x4_splat(v->x)),
+                       wasm_f32x4_mul(wasm_v128_load(&r->col[1]), wasm_f32x4_splat(v->y))),
+        wasm_f32x4_mul(wasm_v128_load(&r->col[2]), wasm_f32x4_splat(v->z)));
+    float w = v->w;
+    wasm_v128_store(v, out);
+    v->w = w;
+#else
+    float x = v->x, y = v->y, z = v->z;
+    v->x = r->col[0].x * x + r->col[1].x * y + r->col[2].x * z;
+    v->y = r->col[0].y * x + r->col[1].y * y + r->col[2].y * z;
+    v->z = r->col[0].z * x + r->col[1].z * y + r->col[2].z * z;
+#endif
+}
 
-    // Rodrigues' rotation formula
-    v->x = vx * c + (axis->y * vz - axis->z * vy) * s + axis->x * dot * (1.0f - c);
-    v->y = vy * c + (axis->z * vx - axis->x * vz) * s + axis->y * dot * (1.0f - c);
-    v->z = vz * c + (axis->x * vy - axis->y * vx) * s + axis->z * dot * (1.0f - c);
+// The rotation at time, built once per light and applied to each of its vectors
+ALWAYS_INLINE static void animRotation(const RotationParams *p, float time, RotationMatrix *r) {
+    float angle;
+    if (p->mode == ROTATE_SWING) {
+        angle = sinf(time * p->speed) * p->angle;
+    } else {
+        // Normalize angle to prevent floating point precision issues
+        angle = fmodf(time * p->speed, 2.0f * M_PI);
+    }
+    buildRotationMatrix(&p->axis, angle, r);
 }
 
 // Build stable orthonormal basis from normal
@@ -362,6 +681,87 @@ ALWAYS_INLINE static void buildOrthonormalBasis(const Vec4 *normal, Vec4 *tangen
     bitangent->w = 0.0f;
 }
 
+ALWAYS_INLINE static void buildRectFrame(RectLight *l) {
+    buildOrthonormalBasis(&l->normal, &l->tangent, &l->bitangent);
+    l->baseTangent = l->tangent;
+    l->baseBitangent = l->bitangent;
+}
+
+// Tangent frames for many rect lights at once: the lights listed in indices,
+// or first..first+count-1 when indices is NULL. Normals must be normalised.
+// The SIMD build does four lights per step with the same arithmetic as
+// buildOrthonormalBasis; degenerate normals take the scalar fallback.
+static void buildRectFrames(int first, const uint32_t *indices, int count) {
+    int k = 0;
+#ifdef __wasm_simd128__
+    const v128_t zero = wasm_f32x4_splat(0.0f);
+    const v128_t one = wasm_f32x4_splat(1.0f);
+    for (; k + 3 < count; k += 4) {
+        RectLight *l[4];
+        for (int j = 0; j < 4; j++) {
+            l[j] = &rectLights[indices ? (int)indices[k + j] : first + k + j];
+        }
+
+        v128_t nx = wasm_f32x4_make(l[0]->normal.x, l[1]->normal.x, l[2]->normal.x, l[3]->normal.x);
+        v128_t ny = wasm_f32x4_make(l[0]->normal.y, l[1]->normal.y, l[2]->normal.y, l[3]->normal.y);
+        v128_t nz = wasm_f32x4_make(l[0]->normal.z, l[1]->normal.z, l[2]->normal.z, l[3]->normal.z);
+
+        // Tangent = cross(reference, normal) with the world-up reference,
+        // (nz, 0, -nx), or the X reference for near-vertical normals, (0, -nz, ny)
+        v128_t useX = wasm_f32x4_ge(wasm_f32x4_abs(ny), wasm_f32x4_splat(0.999f));
+        v128_t tx = wasm_v128_bitselect(zero, nz, useX);
+        v128_t ty = wasm_v128_bitselect(wasm_f32x4_neg(nz), zero, useX);
+        v128_t tz = wasm_v128_bitselect(ny, wasm_f32x4_neg(nx), useX);
+
+        v128_t len = wasm_f32x4_sqrt(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(tx, tx),
+                                                                   wasm_f32x4_mul(ty, ty)),
+                                                    wasm_f32x4_mul(tz, tz)));
+        if (wasm_i32x4_bitmask(wasm_f32x4_ge(len, wasm_f32x4_splat(1e-6f))) != 0xF) {
+            for (int j = 0; j < 4; j++) buildRectFrame(l[j]);
+            continue;
+        }
+        v128_t inv = wasm_f32x4_div(one, len);
+        tx = wasm_f32x4_mul(tx, inv);
+        ty = wasm_f32x4_mul(ty, inv);
+        tz = wasm_f32x4_mul(tz, inv);
+
+        // Bitangent = normalize(cross(normal, tangent)), non-zero for unit normals
+        v128_t bx = wasm_f32x4_sub(wasm_f32x4_mul(ny, tz), wasm_f32x4_mul(nz, ty));
+        v128_t by = wasm_f32x4_sub(wasm_f32x4_mul(nz, tx), wasm_f32x4_mul(nx, tz));
+        v128_t bz = wasm_f32x4_sub(wasm_f32x4_mul(nx, ty), wasm_f32x4_mul(ny, tx));
+        v128_t invBit = wasm_f32x4_div(one, wasm_f32x4_sqrt(
+            wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(bx, bx), wasm_f32x4_mul(by, by)),
+                           wasm_f32x4_mul(bz, bz))));
+        bx = wasm_f32x4_mul(bx, invBit);
+        by = wasm_f32x4_mul(by, invBit);
+        bz = wasm_f32x4_mul(bz, invBit);
+
+        float t[3][4], b[3][4];
+        wasm_v128_store(t[0], tx); wasm_v128_store(t[1], ty); wasm_v128_store(t[2], tz);
+        wasm_v128_store(b[0], bx); wasm_v128_store(b[1], by); wasm_v128_store(b[2], bz);
+        for (int j = 0; j < 4; j++) {
+            l[j]->tangent = l[j]->baseTangent = (Vec4){t[0][j], t[1][j], t[2][j], 0.0f};
+            l[j]->bitangent = l[j]->baseBitangent = (Vec4){b[0][j], b[1][j], b[2][j], 0.0f};
+        }
+    }
+#endif
+    for (; k < count; k++) {
+        buildRectFrame(&rectLights[indices ? (int)indices[k] : first + k]);
+    }
+}
+
+// The view rotation has unit, orthogonal axes (no scale or shear), so it
+// maps unit vectors to unit vectors
+ALWAYS_INLINE static int viewRotationIsRigid(void) {
+    const float eps = 1e-5f;
+    return fabsf(e0*e0 + e1*e1 + e2*e2 - 1.0f) < eps &&
+           fabsf(e4*e4 + e5*e5 + e6*e6 - 1.0f) < eps &&
+           fabsf(e8*e8 + e9*e9 + e10*e10 - 1.0f) < eps &&
+           fabsf(e0*e4 + e1*e5 + e2*e6) < eps &&
+           fabsf(e0*e8 + e1*e9 + e2*e10) < eps &&
+           fabsf(e4*e8 + e5*e9 + e6*e10) < eps;
+}
+
 // Calculate LOD level based on view distance and radius
 ALWAYS_INLINE static uint8_t calculateLOD(float viewZ, float radius) {
     float distance = -viewZ;  // viewZ is negative
@@ -389,15 +789,15 @@ ALWAYS_INLINE static void calculateLOD_SIMD(
     v128_t rad = wasm_f32x4_make(radius0 * lodBias, radius1 * lodBias,
                                   radius2 * lodBias, radius3 * lodBias);
 
-    // Calculate relative distances (4 at once)
-    v128_t relDist = wasm_f32x4_div(vz, rad);
-
     // Thresholds (broadcast to all lanes)
     v128_t skipThresh = wasm_f32x4_splat(LOD_SKIP_DISTANCE);
     v128_t simpleThresh = wasm_f32x4_splat(LOD_SIMPLE_DISTANCE);
     v128_t mediumThresh = wasm_f32x4_splat(LOD_MEDIUM_DISTANCE);
 
     // Compare: relDist > threshold produces 0xFFFFFFFF for true, 0x00000000 for false
+    // Calculate relative distances (4 at once)
+    v128_t relDist = wasm_f32x4_div(vz, rad);
+
     v128_t isSkip = wasm_f32x4_gt(relDist, skipThresh);
     v128_t isSimple = wasm_f32x4_gt(relDist, simpleThresh);
     v128_t isMedium = wasm_f32x4_gt(relDist, mediumThresh);
@@ -417,15 +817,243 @@ ALWAYS_INLINE static void calculateLOD_SIMD(
 }
 #endif
 
-// Pack decay, visibility, and LOD into a single float for optimized texture layout
-ALWAYS_INLINE static float packLightParams(float decay, uint8_t visible, uint8_t lod) {
-    // Pack: decay (0-3 range) * 100 + visible * 10 + lod (0-3)
-    return decay * 100.0f + (visible ? 10.0f : 0.0f) + (float)lod;
+// Pack LOD, visibility, light layers and decay into one float for the texture.
+// The word is a bitfield below 2^24, so it is exact as a float and shaders
+// decode it with integer ops: bits 0-1 = LOD, bit 2 = visible,
+// bits 3-10 = light layers, bits 11-23 = decay in 1/64 steps.
+ALWAYS_INLINE static float packLightParams(float decay, uint8_t visible, uint8_t lod, uint8_t layers) {
+    uint32_t q = decay > 0.0f ? (uint32_t)(decay * PACK_DECAY_STEPS) : 0;
+    if (q > PACK_DECAY_MAX) q = PACK_DECAY_MAX;
+
+    uint32_t word = ((uint32_t)lod & PACK_LOD_MASK) |
+                    (visible ? PACK_VISIBLE : 0) |
+                    ((uint32_t)layers << PACK_LAYER_SHIFT) |
+                    (q << PACK_DECAY_SHIFT);
+    return (float)word;
+}
+
+// Octahedral encoding of a unit vector into one exact float: two 12-bit
+// coordinates as u << 12 | v, so the word stays below 2^24 like the packed
+// parameters. The lower hemisphere is folded over the diagonals; a zero
+// vector encodes as the +z pole.
+#define OCT_BITS 12
+#define OCT_MAX ((1u << OCT_BITS) - 1)
+
+ALWAYS_INLINE static uint32_t octQuantize(float e) {
+    float q = (e * 0.5f + 0.5f) * (float)OCT_MAX + 0.5f;
+    if (q < 0.0f) q = 0.0f;
+    if (q > (float)OCT_MAX) q = (float)OCT_MAX;
+    return (uint32_t)q;
+}
+
+ALWAYS_INLINE static float packOctahedral(const Vec4 *n) {
+    float sum = fabsf(n->x) + fabsf(n->y) + fabsf(n->z);
+    float u = 0.0f, v = 0.0f;
+    if (sum > 0.0f) {
+        float inv = 1.0f / sum;
+        u = n->x * inv;
+        v = n->y * inv;
+        if (n->z < 0.0f) {
+            float fu = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+            float fv = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+            u = fu;
+            v = fv;
+        }
+    }
+    return (float)((octQuantize(u) << OCT_BITS) | octQuantize(v));
+}
+
+// ──────────────────────────────────────────────────────────────
+//                   VISIBILITY TRACKING
+// ──────────────────────────────────────────────────────────────
+// Called from every pack site. Only lights whose state differs from the one
+// published last frame touch the bitset and the change list.
+ALWAYS_INLINE static void trackVisibility(uint8_t type, int index, uint8_t *state,
+                                          uint32_t *bits, uint8_t rendered, uint8_t lod) {
+    uint8_t next = rendered ? (uint8_t)(VIS_STATE_RENDERED | (lod & VIS_STATE_LOD_MASK)) : 0;
+    if (next == *state) return;
+
+    uint32_t bit = 1u << (index & 31);
+    if (rendered) bits[index >> 5] |= bit;
+    else bits[index >> 5] &= ~bit;
+
+    VisibilityChange *c = &visibilityChanges[visibilityChangeCount++];
+    c->index = (uint32_t)index;
+    c->type = type;
+    c->state = next;
+    c->prevState = *state;
+    c->pad = 0;
+    *state = next;
+}
+
+// Rebuild a bitset from the per-light state after lights moved in memory
+// (sort, removal, count changes). The state travels with the light, so a
+// reorder never produces spurious change events.
+#define REBUILD_VISIBILITY_BITS(array, count, bits) \
+    do { \
+        memset(bits, 0, (size_t)visibilityWords * sizeof(uint32_t)); \
+        for (int i = 0; i < (count); ++i) { \
+            if (array[i].visState & VIS_STATE_RENDERED) bits[i >> 5] |= 1u << (i & 31); \
+        } \
+    } while(0)
+
+// Depth-range culling shared by all light types
+ALWAYS_INLINE static uint8_t isDepthCulled(float viewZ, float radius) {
+    return (viewZ > radius - viewNear || viewZ < -viewFar - radius) ? 1 : 0;
+}
+
+// Apply group state to a light's color. Returns 0 if any of the light's
+// groups is disabled. Lights outside all groups take the first branch only.
+ALWAYS_INLINE static uint8_t applyLightGroups(uint32_t mask, Vec4 *color) {
+    if (mask == 0) return 1;
+    if (mask & disabledGroups) return 0;
+
+    uint32_t scaled = mask & scaledGroups;
+    while (scaled) {
+        const Vec4 *g = &groupScale[__builtin_ctz(scaled)];
+        color->x *= g->x;
+        color->y *= g->y;
+        color->z *= g->z;
+        color->w *= g->w;
+        scaled &= scaled - 1;
+    }
+    return 1;
+}
+
+// ──────────────────────────────────────────────────────────────
+//                   TEXTURE PACKING
+// ──────────────────────────────────────────────────────────────
+// Shading constants that only depend on the light go into the records, so
+// fragments read them instead of recomputing them.
+ALWAYS_INLINE static Vec4 viewPosInvRadius(const Vec4 *viewPos) {
+    return (Vec4){viewPos->x, viewPos->y, viewPos->z, viewPos->w > 0.0f ? 1.0f / viewPos->w : 0.0f};
+}
+
+// Point and rect falloff rate; the shaders' 1 / (1 + rate * distance) terms
+// were tuned against decay * 0.1
+ALWAYS_INLINE static float decayRate(float decay) {
+    return decay * 0.1f;
+}
+
+ALWAYS_INLINE static void packPointLight(int i, PointLight *l, uint8_t culled) {
+    Vec4 color = l->color;
+    uint8_t visible = l->visible && !culled && applyLightGroups(l->groupMask, &color);
+    // Unified point rows are wider than their 512 records, so index by row
+    PointLightDataOptimized *ld = POINT_RECORD(i);
+
+    ld->positionInvRadius = viewPosInvRadius(&l->viewPos);
+    ld->colorDecayVisible = (Vec4){
+        color.x * color.w,
+        color.y * color.w,
+        color.z * color.w,
+        packLightParams(l->decay, visible, l->lodLevel, l->layerMask)
+    };
+    ld->falloff = (Vec4){decayRate(l->decay), 0.0f, 0.0f, 0.0f};
+
+    trackVisibility(LIGHT_TYPE_POINT, i, &l->visState, pointVisibilityBits,
+                    visible && l->lodLevel != LOD_SKIP, l->lodLevel);
+    l->dirty = 0;
+}
+
+ALWAYS_INLINE static void packSpotLight(int i, SpotLight *l, uint8_t culled) {
+    Vec4 color = l->color;
+    uint8_t visible = l->visible && !culled && applyLightGroups(l->groupMask, &color);
+    // Unified spot rows are wider than their 512 records, so index by row
+    SpotLightData *ld = unifiedLights
+        ? UNIFIED_RECORD(SpotLightData, spotRecords, i, UNIFIED_SPOT_SHIFT)
+        : &spotRecords[i];
+
+    ld->positionInvRadius = viewPosInvRadius(&l->viewPos);
+    ld->colorDecay = (Vec4){
+        color.x * color.w,
+        color.y * color.w,
+        color.z * color.w,
+        l->decay
+    };
+    ld->angleParams = (Vec4){
+        cosf(l->angle),
+        cosf(l->angle - l->penumbra),
+        packOctahedral(&l->viewDir),
+        packLightParams(l->decay, visible, l->lodLevel, l->layerMask)
+    };
+
+    trackVisibility(LIGHT_TYPE_SPOT, i, &l->visState, spotVisibilityBits,
+                    visible && l->lodLevel != LOD_SKIP, l->lodLevel);
+    l->dirty = 0;
+}
+
+ALWAYS_INLINE static void packRectLight(int i, RectLight *l, uint8_t culled) {
+    Vec4 color = l->color;
+    uint8_t visible = l->visible && !culled && applyLightGroups(l->groupMask, &color);
+    // Unified rect rows are wider than their 512 records, so index by row
+    RectLightData *ld = unifiedLights
+        ? UNIFIED_RECORD(RectLightData, rectRecords, i, UNIFIED_RECT_SHIFT)
+        : &rectRecords[i];
+
+    // Rect falloff scales with the area, so it is folded into the colour
+    float scale = color.w * l->size.x * l->size.y;
+    ld->positionInvRadius = viewPosInvRadius(&l->viewPos);
+    ld->colorTangent = (Vec4){
+        color.x * scale,
+        color.y * scale,
+        color.z * scale,
+        packOctahedral(&l->viewTangent)
+    };
+    ld->sizeParams = (Vec4){
+        l->size.x,
+        l->size.y,
+        packOctahedral(&l->viewNormal),
+        packLightParams(l->decay, visible, l->lodLevel, l->layerMask)
+    };
+    ld->falloff = (Vec4){decayRate(l->decay), 0.0f, 0.0f, 0.0f};
+
+    trackVisibility(LIGHT_TYPE_RECT, i, &l->visState, rectVisibilityBits,
+                    visible && l->lodLevel != LOD_SKIP, l->lodLevel);
+    l->dirty = 0;
 }
 
-// Pack visibility and LOD for spot/rect lights
-ALWAYS_INLINE static float packVisibleLOD(uint8_t visible, uint8_t lod) {
-    return (float)(visible ? 10 : 0) + (float)lod;
+// Point the pack stage at this frame's record destinations. In unified mode
+// the row layout follows the light counts, growing the buffer as needed; if
+// that allocation fails the core falls back to the per-type buffers.
+static void bindLightRecords(void) {
+    if (unifiedLights) {
+        int pointRecordCount = pointLightCount + staticPointCount;
+        int spotRow = (pointRecordCount + (1 << UNIFIED_POINT_SHIFT) - 1) >> UNIFIED_POINT_SHIFT;
+        int rectRow = spotRow + ((spotLightCount + (1 << UNIFIED_SPOT_SHIFT) - 1) >> UNIFIED_SPOT_SHIFT);
+        int rows = rectRow + ((rectLightCount + (1 << UNIFIED_RECT_SHIFT) - 1) >> UNIFIED_RECT_SHIFT);
+
+        if (rows > unifiedRowCapacity) {
+            int capacity = unifiedRowCapacity ? unifiedRowCapacity : 16;
+            while (capacity < rows) capacity *= 2;
+            size_t bytes = sizeof(Vec4) * UNIFIED_ROW_TEXELS * (size_t)capacity;
+            Vec4 *grown = NULL;
+            if (posix_memalign((void**)&grown, 16, bytes) != 0) {
+                unifiedLights = 0;
+                memset(unifiedLayout, 0, sizeof(unifiedLayout));
+                bindLightRecords();
+                return;
+            }
+            memset(grown, 0, bytes);
+            free(unifiedLightTexture);
+            unifiedLightTexture = grown;
+            unifiedRowCapacity = capacity;
+        }
+
+        unifiedLayout[0] = UNIFIED_ROW_TEXELS;
+        unifiedLayout[1] = spotRow;
+        unifiedLayout[2] = rectRow;
+        unifiedLayout[3] = rows;
+        unifiedLayout[4] = UNIFIED_POINT_SHIFT;
+        unifiedLayout[5] = UNIFIED_SPOT_SHIFT;
+        unifiedLayout[6] = UNIFIED_RECT_SHIFT;
+        pointRecords = (PointLightDataOptimized*)unifiedLightTexture;
+        spotRecords = (SpotLightData*)(unifiedLightTexture + (size_t)spotRow * UNIFIED_ROW_TEXELS);
+        rectRecords = (RectLightData*)(unifiedLightTexture + (size_t)rectRow * UNIFIED_ROW_TEXELS);
+    } else {
+        pointRecords = pointLightTexture;
+        spotRecords = spotLightTexture;
+        rectRecords = rectLightTexture;
+    }
 }
 
 // ──────────────────────────────────────────────────────────────
@@ -509,6 +1137,7 @@ ALWAYS_INLINE static void processSpotLightAnimation(SpotLight *l, float time) {
     l->animOffset = (Vec4){0, 0, 0, 0};
     
     // Start from base values
+    l->color = l->baseColor;
     l->direction = l->baseDir;
     l->worldPos.w = l->baseWorldPos.w;
     
@@ -545,21 +1174,11 @@ ALWAYS_INLINE static void processSpotLightAnimation(SpotLight *l, float time) {
 
     // Rotation for direction AND position
     if (l->anim.flags & ANIM_ROTATE) {
-        Vec4 dir = l->baseDir;
-        Vec4 pos = l->worldPos;
-        float angle;
-
-        if (l->anim.rotation.mode == ROTATE_SWING) {
-            angle = sinf(time * l->anim.rotation.speed) * l->anim.rotation.angle;
-        } else {
-            // Normalize angle to prevent floating point precision issues
-            angle = fmodf(time * l->anim.rotation.speed, 2.0f * M_PI);
-        }
-
-        rotateAroundAxis(&dir, &l->anim.rotation.axis, angle);
-        rotateAroundAxis(&pos, &l->anim.rotation.axis, angle);
-        l->direction = dir;
-        l->worldPos = pos;
+        RotationMatrix r;
+        animRotation(&l->anim.rotation, time, &r);
+        l->direction = l->baseDir;
+        applyRotation(&r, &l->direction);
+        applyRotation(&r, &l->worldPos);
     }
     
     // Flickering
@@ -567,14 +1186,14 @@ ALWAYS_INLINE static void processSpotLightAnimation(SpotLight *l, float time) {
         float flicker = 1.0f + sinf(time * l->anim.flicker.speed + l->anim.flicker.seed) * 
                               cosf(time * l->anim.flicker.speed * 1.7f + l->anim.flicker.seed * 2.3f) * 
                               l->anim.flicker.intensity;
-        l->color.w = l->color.w * clampf(flicker, 0.1f, 2.0f);
+        l->color.w = l->baseColor.w * clampf(flicker, 0.1f, 2.0f);
     }
     
     // Pulsing
     if (l->anim.flags & ANIM_PULSE) {
         float pulse = 1.0f + sinf(time * l->anim.pulse.speed) * l->anim.pulse.amount;
         if (l->anim.pulse.target & PULSE_INTENSITY) {
-            l->color.w = l->color.w * pulse;
+            l->color.w = l->baseColor.w * pulse;
         }
         if (l->anim.pulse.target & PULSE_RADIUS) {
             l->worldPos.w = l->baseWorldPos.w * pulse;
@@ -587,6 +1206,7 @@ ALWAYS_INLINE static void processRectLightAnimation(RectLight *l, float time) {
     l->animOffset = (Vec4){0, 0, 0, 0};
     
     // Start from base values
+    l->color = l->baseColor;
     l->normal = l->baseNormal;
     l->worldPos.w = l->baseWorldPos.w;
     
@@ -623,24 +1243,14 @@ ALWAYS_INLINE static void processRectLightAnimation(RectLight *l, float time) {
 
     // Rotation for normal, tangent, and bitangent
     if (l->anim.flags & ANIM_ROTATE) {
-        Vec4 norm = l->baseNormal;
-        Vec4 tang = l->baseTangent;
-        Vec4 bitang = l->baseBitangent;
-        float angle;
-
-        if (l->anim.rotation.mode == ROTATE_SWING) {
-            angle = sinf(time * l->anim.rotation.speed) * l->anim.rotation.angle;
-        } else {
-            // Normalize angle to prevent floating point precision issues
-            angle = fmodf(time * l->anim.rotation.speed, 2.0f * M_PI);
-        }
-
-        rotateAroundAxis(&norm, &l->anim.rotation.axis, angle);
-        rotateAroundAxis(&tang, &l->anim.rotation.axis, angle);
-        rotateAroundAxis(&bitang, &l->anim.rotation.axis, angle);
-        l->normal = norm;
-        l->tangent = tang;
-        l->bitangent = bitang;
+        RotationMatrix r;
+        animRotation(&l->anim.rotation, time, &r);
+        l->normal = l->baseNormal;
+        l->tangent = l->baseTangent;
+        l->bitangent = l->baseBitangent;
+        applyRotation(&r, &l->normal);
+        applyRotation(&r, &l->tangent);
+        applyRotation(&r, &l->bitangent);
     }
     
     // Flickering
@@ -648,24 +1258,90 @@ ALWAYS_INLINE static void processRectLightAnimation(RectLight *l, float time) {
         float flicker = 1.0f + sinf(time * l->anim.flicker.speed + l->anim.flicker.seed) * 
                               cosf(time * l->anim.flicker.speed * 1.7f + l->anim.flicker.seed * 2.3f) * 
                               l->anim.flicker.intensity;
-        l->color.w = l->color.w * clampf(flicker, 0.1f, 2.0f);
+        l->color.w = l->baseColor.w * clampf(flicker, 0.1f, 2.0f);
     }
     
     // Pulsing
     if (l->anim.flags & ANIM_PULSE) {
         float pulse = 1.0f + sinf(time * l->anim.pulse.speed) * l->anim.pulse.amount;
         if (l->anim.pulse.target & PULSE_INTENSITY) {
-            l->color.w = l->color.w * pulse;
+            l->color.w = l->baseColor.w * pulse;
         }
     }
 }
 
+// ──────────────────────────────────────────────────────────────
+//                   PER-LIGHT UPDATE STEPS
+// ──────────────────────────────────────────────────────────────
+// Animate, transform, classify and pack one light. Returns 1 if animated.
+ALWAYS_INLINE static int stepPointLight(int i, float time) {
+    PointLight *l = &pointLights[i];
+    int animated = 0;
+
+    if (l->anim.flags != ANIM_NONE) {
+        processPointLightAnimation(l, time);
+        animated = 1;
+    } else {
+        l->worldPos = l->baseWorldPos;
+    }
+
+    worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
+    l->lodLevel = calculateLOD(l->viewPos.z, l->worldPos.w);
+    packPointLight(i, l, isDepthCulled(l->viewPos.z, l->worldPos.w));
+    return animated;
+}
+
+ALWAYS_INLINE static int stepSpotLight(int i, float time) {
+    SpotLight *l = &spotLights[i];
+    int animated = 0;
+
+    if (l->anim.flags != ANIM_NONE) {
+        processSpotLightAnimation(l, time);
+        animated = 1;
+    } else {
+        l->worldPos = l->baseWorldPos;
+    }
+
+    worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
+    worldDirToView(&l->direction, &l->viewDir);
+    l->lodLevel = calculateLOD(l->viewPos.z, l->worldPos.w);
+    packSpotLight(i, l, isDepthCulled(l->viewPos.z, l->worldPos.w));
+    return animated;
+}
+
+ALWAYS_INLINE static int stepRectLight(int i, float time) {
+    RectLight *l = &rectLights[i];
+    int animated = 0;
+
+    if (l->anim.flags != ANIM_NONE) {
+        processRectLightAnimation(l, time);
+        animated = 1;
+    } else {
+        l->worldPos = l->baseWorldPos;
+    }
+
+    worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
+    // Rect frames are stored unit length; only rotation animation (whose axis
+    // is not normalised) can change that, so a rigid view can skip the sqrt
+    if (viewRigid && !(l->anim.flags & ANIM_ROTATE)) {
+        rotateDirToView(&l->normal, &l->viewNormal);
+        rotateDirToView(&l->tangent, &l->viewTangent);
+    } else {
+        worldDirToView(&l->normal, &l->viewNormal);
+        worldDirToView(&l->tangent, &l->viewTangent);
+    }
+    l->lodLevel = calculateLOD(l->viewPos.z, l->worldPos.w);
+    packRectLight(i, l, isDepthCulled(l->viewPos.z, l->worldPos.w));
+    return animated;
+}
+
 // ──────────────────────────────────────────────────────────────
 //                    SIMD BATCH PROCESSING
 // ──────────────────────────────────────────────────────────────
 #ifdef __wasm_simd128__
-static void updatePointLightsSIMD(float time) {
+static int updatePointLightsSIMD(float time) {
     int i = 0;
+    int animated = 0;
     
     // Cache view matrix elements for SIMD
     e0v = wasm_f32x4_splat(e0);
@@ -695,6 +1371,7 @@ static void updatePointLightsSIMD(float time) {
             processPointLightAnimation(l1, time);
             processPointLightAnimation(l2, time);
             processPointLightAnimation(l3, time);
+            animated = 1;
         } else {
             // No animations - just copy base positions
             l0->worldPos = l0->baseWorldPos;
@@ -708,12 +1385,9 @@ static void updatePointLightsSIMD(float time) {
         v128_t wy = wasm_f32x4_make(l0->worldPos.y, l1->worldPos.y, l2->worldPos.y, l3->worldPos.y);
         v128_t wz = wasm_f32x4_make(l0->worldPos.z, l1->worldPos.z, l2->worldPos.z, l3->worldPos.z);
         
-        v128_t vx = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(e0v, wx), wasm_f32x4_mul(e4v, wy)), 
-                                   wasm_f32x4_add(wasm_f32x4_mul(e8v, wz), e12v));
-        v128_t vy = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(e1v, wx), wasm_f32x4_mul(e5v, wy)), 
-                                   wasm_f32x4_add(wasm_f32x4_mul(e9v, wz), e13v));
-        v128_t vz = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(e2v, wx), wasm_f32x4_mul(e6v, wy)), 
-                                   wasm_f32x4_add(wasm_f32x4_mul(e10v, wz), e14v));
+        v128_t vx = transformRowSIMD(e0v, e4v, e8v, e12v, wx, wy, wz);
+        v128_t vy = transformRowSIMD(e1v, e5v, e9v, e13v, wx, wy, wz);
+        v128_t vz = transformRowSIMD(e2v, e6v, e10v, e14v, wx, wy, wz);
         
         // Extract and store results
         l0->viewPos.x = wasm_f32x4_extract_lane(vx, 0);
@@ -745,92 +1419,19 @@ static void updatePointLightsSIMD(float time) {
             &l0->lodLevel, &l1->lodLevel, &l2->lodLevel, &l3->lodLevel
         );
         
-        // Visibility culling
-        uint8_t culled0 = (l0->viewPos.z > l0->worldPos.w - viewNear || l0->viewPos.z < -viewFar - l0->worldPos.w) ? 1 : 0;
-        uint8_t culled1 = (l1->viewPos.z > l1->worldPos.w - viewNear || l1->viewPos.z < -viewFar - l1->worldPos.w) ? 1 : 0;
-        uint8_t culled2 = (l2->viewPos.z > l2->worldPos.w - viewNear || l2->viewPos.z < -viewFar - l2->worldPos.w) ? 1 : 0;
-        uint8_t culled3 = (l3->viewPos.z > l3->worldPos.w - viewNear || l3->viewPos.z < -viewFar - l3->worldPos.w) ? 1 : 0;
-        
-        // Update optimized texture data
-        PointLightDataOptimized *ld0 = &pointLightTexture[i];
-        PointLightDataOptimized *ld1 = &pointLightTexture[i+1];
-        PointLightDataOptimized *ld2 = &pointLightTexture[i+2];
-        PointLightDataOptimized *ld3 = &pointLightTexture[i+3];
-        
-        // Pack data into optimized format with LOD
-        ld0->positionRadius = l0->viewPos;
-        ld0->colorDecayVisible = (Vec4){
-            l0->color.x * l0->color.w,
-            l0->color.y * l0->color.w,
-            l0->color.z * l0->color.w,
-            packLightParams(l0->decay, l0->visible && !culled0, l0->lodLevel)
-        };
-        
-        ld1->positionRadius = l1->viewPos;
-        ld1->colorDecayVisible = (Vec4){
-            l1->color.x * l1->color.w,
-            l1->color.y * l1->color.w,
-            l1->color.z * l1->color.w,
-            packLightParams(l1->decay, l1->visible && !culled1, l1->lodLevel)
-        };
-        
-        ld2->positionRadius = l2->viewPos;
-        ld2->colorDecayVisible = (Vec4){
-            l2->color.x * l2->color.w,
-            l2->color.y * l2->color.w,
-            l2->color.z * l2->color.w,
-            packLightParams(l2->decay, l2->visible && !culled2, l2->lodLevel)
-        };
-        
-        ld3->positionRadius = l3->viewPos;
-        ld3->colorDecayVisible = (Vec4){
-            l3->color.x * l3->color.w,
-            l3->color.y * l3->color.w,
-            l3->color.z * l3->color.w,
-            packLightParams(l3->decay, l3->visible && !culled3, l3->lodLevel)
-        };
-        
-        l0->dirty = 0;
-        l1->dirty = 0;
-        l2->dirty = 0;
-        l3->dirty = 0;
+        // Visibility culling and texture packing
+        packPointLight(i,     l0, isDepthCulled(l0->viewPos.z, l0->worldPos.w));
+        packPointLight(i + 1, l1, isDepthCulled(l1->viewPos.z, l1->worldPos.w));
+        packPointLight(i + 2, l2, isDepthCulled(l2->viewPos.z, l2->worldPos.w));
+        packPointLight(i + 3, l3, isDepthCulled(l3->viewPos.z, l3->worldPos.w));
     }
     
     // Handle remaining lights
     for (; i < pointLightCount; i++) {
-        PointLight *l = &pointLights[i];
-        PointLightDataOptimized *ld = &pointLightTexture[i];
-        
-        // Process animation
-        if (l->anim.flags != ANIM_NONE) {
-            processPointLightAnimation(l, time);
-        } else {
-            l->worldPos = l->baseWorldPos;
-        }
-        
-        // Transform to view space
-        worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
-        
-        // Calculate LOD level
-        l->lodLevel = calculateLOD(l->viewPos.z, l->worldPos.w);
-        
-        // Visibility culling
-        uint8_t culled = 0;
-        if (l->viewPos.z > l->worldPos.w - viewNear || l->viewPos.z < -viewFar - l->worldPos.w) {
-            culled = 1;
-        }
-        
-        // Update texture data
-        ld->positionRadius = l->viewPos;
-        ld->colorDecayVisible = (Vec4){
-            l->color.x * l->color.w,
-            l->color.y * l->color.w,
-            l->color.z * l->color.w,
-            packLightParams(l->decay, l->visible && !culled, l->lodLevel)
-        };
-        
-        l->dirty = 0;
+        animated |= stepPointLight(i, time);
     }
+
+    return animated;
 }
 
 // Fast path for mass point lights without LOD
@@ -888,18 +1489,9 @@ static void updatePointLightsFast(float time) {
         );
 
         // Transform to view space using SIMD
-        v128_t vx = wasm_f32x4_add(
-            wasm_f32x4_add(wasm_f32x4_mul(e0v, wx), wasm_f32x4_mul(e4v, wy)),
-            wasm_f32x4_add(wasm_f32x4_mul(e8v, wz), e12v)
-        );
-        v128_t vy = wasm_f32x4_add(
-            wasm_f32x4_add(wasm_f32x4_mul(e1v, wx), wasm_f32x4_mul(e5v, wy)),
-            wasm_f32x4_add(wasm_f32x4_mul(e9v, wz), e13v)
-        );
-        v128_t vz = wasm_f32x4_add(
-            wasm_f32x4_add(wasm_f32x4_mul(e2v, wx), wasm_f32x4_mul(e6v, wy)),
-            wasm_f32x4_add(wasm_f32x4_mul(e10v, wz), e14v)
-        );
+        v128_t vx = transformRowSIMD(e0v, e4v, e8v, e12v, wx, wy, wz);
+        v128_t vy = transformRowSIMD(e1v, e5v, e9v, e13v, wx, wy, wz);
+        v128_t vz = transformRowSIMD(e2v, e6v, e10v, e14v, wx, wy, wz);
 
         // Extract and write results - must be unrolled for compile-time lane access
         PointLight *l0 = &pointLights[i];
@@ -928,28 +1520,32 @@ static void updatePointLightsFast(float time) {
         l3->viewPos.w = l3->worldPos.w;
 
         // Write to texture data
-        PointLightDataOptimized *ld0 = &pointLightTexture[i];
-        PointLightDataOptimized *ld1 = &pointLightTexture[i + 1];
-        PointLightDataOptimized *ld2 = &pointLightTexture[i + 2];
-        PointLightDataOptimized *ld3 = &pointLightTexture[i + 3];
+        PointLightDataOptimized *ld0 = POINT_RECORD(i);
+        PointLightDataOptimized *ld1 = POINT_RECORD(i + 1);
+        PointLightDataOptimized *ld2 = POINT_RECORD(i + 2);
+        PointLightDataOptimized *ld3 = POINT_RECORD(i + 3);
 
-        ld0->positionRadius = l0->viewPos;
+        ld0->positionInvRadius = viewPosInvRadius(&l0->viewPos);
         ld0->colorDecayVisible = (Vec4){l0->color.x * l0->color.w, l0->color.y * l0->color.w, l0->color.z * l0->color.w, 1.0f};
+        ld0->falloff = (Vec4){decayRate(l0->decay), 0.0f, 0.0f, 0.0f};
 
-        ld1->positionRadius = l1->viewPos;
+        ld1->positionInvRadius = viewPosInvRadius(&l1->viewPos);
         ld1->colorDecayVisible = (Vec4){l1->color.x * l1->color.w, l1->color.y * l1->color.w, l1->color.z * l1->color.w, 1.0f};
+        ld1->falloff = (Vec4){decayRate(l1->decay), 0.0f, 0.0f, 0.0f};
 
-        ld2->positionRadius = l2->viewPos;
+        ld2->positionInvRadius = viewPosInvRadius(&l2->viewPos);
         ld2->colorDecayVisible = (Vec4){l2->color.x * l2->color.w, l2->color.y * l2->color.w, l2->color.z * l2->color.w, 1.0f};
+        ld2->falloff = (Vec4){decayRate(l2->decay), 0.0f, 0.0f, 0.0f};
 
-        ld3->positionRadius = l3->viewPos;
+        ld3->positionInvRadius = viewPosInvRadius(&l3->viewPos);
         ld3->colorDecayVisible = (Vec4){l3->color.x * l3->color.w, l3->color.y * l3->color.w, l3->color.z * l3->color.w, 1.0f};
+        ld3->falloff = (Vec4){decayRate(l3->decay), 0.0f, 0.0f, 0.0f};
     }
 
     // Handle remainder with scalar path
     for (; i < pointLightCount; i++) {
         PointLight *l = &pointLights[i];
-        PointLightDataOptimized *ld = &pointLightTexture[i];
+        PointLightDataOptimized *ld = POINT_RECORD(i);
 
         if (hasAnimatedLights && (l->anim.flags & ANIM_CIRCULAR)) {
             float phase = time * l->anim.circular.speed;
@@ -961,13 +1557,14 @@ static void updatePointLightsFast(float time) {
 
         worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
 
-        ld->positionRadius = l->viewPos;
+        ld->positionInvRadius = viewPosInvRadius(&l->viewPos);
         ld->colorDecayVisible = (Vec4){
             l->color.x * l->color.w,
             l->color.y * l->color.w,
             l->color.z * l->color.w,
             1.0f
         };
+        ld->falloff = (Vec4){decayRate(l->decay), 0.0f, 0.0f, 0.0f};
     }
 }
 #endif
@@ -975,41 +1572,164 @@ static void updatePointLightsFast(float time) {
 // ──────────────────────────────────────────────────────────────
 //                     GENERIC RADIX SORT
 // ──────────────────────────────────────────────────────────────
-// Generic radix sort that works with any light type
-// Assumes morton code is at the same offset in all structs
+// LSD radix sort of (morton << 32 | index) keys on the morton bytes, then a
+// single gather of the light records into that order. Moving 8-byte keys
+// four times and each record once beats moving records four times. Each
+// scatter walks its input in order, so the sort is stable. Passes whose
+// byte is the same for every key are skipped.
+#define SORT_RADIX 256
+
+// Sort `n` records of `stride` bytes in `records` by sortKeys[0, n), using
+// `scratch` (n records) for the gather
+static void sortRecordsByKeys(void *records, void *scratch, size_t stride, int n) {
+    if (n < 2) return;
+
+    uint64_t *src = sortKeys, *dst = sortKeys + n;
+    uint32_t offset[SORT_RADIX];
+    for (int shift = 32; shift < 64; shift += 8) {
+        memset(offset, 0, sizeof(offset));
+        for (int i = 0; i < n; i++) offset[(src[i] >> shift) & 0xFFu]++;
+
+        uint32_t sum = 0;
+        int uniform = 0;
+        for (int b = 0; b < SORT_RADIX; b++) {
+            uint32_t c = offset[b];
+            if (c == (uint32_t)n) uniform = 1;
+            offset[b] = sum;
+            sum += c;
+        }
+        if (uniform) continue;
+
+        for (int i = 0; i < n; i++) {
+            uint64_t key = src[i];
+            dst[offset[(key >> shift) & 0xFFu]++] = key;
+        }
+        uint64_t *tmp = src; src = dst; dst = tmp;
+    }
+
+    const uint8_t *in = (const uint8_t*)records;
+    uint8_t *out = (uint8_t*)scratch;
+    for (int i = 0; i < n; i++) {
+        memcpy(out + (size_t)i * stride, in + (size_t)(uint32_t)src[i] * stride, stride);
+    }
+    memcpy(records, scratch, stride * (size_t)n);
+}
+
+// Sort src_array by morton, using dst_array as scratch (count records)
 #define RADIX_SORT_IMPL(TYPE, src_array, dst_array, count) \
     do { \
-        static const int R = 256; \
-        uint32_t hist[R]; \
-        TYPE *src = src_array; \
-        TYPE *dst = dst_array; \
-        \
-        for (int pass = 0, shift = 0; pass < 4; ++pass, shift += 8) { \
-            memset(hist, 0, sizeof(hist)); \
-            for (int i = 0; i < count; ++i) hist[(src[i].morton >> shift) & 0xFFu]++; \
-            int sum = 0; \
-            for (int i = 0; i < R; ++i) { int c = hist[i]; hist[i] = sum; sum += c; } \
-            for (int i = 0; i < count; ++i) { \
-                uint32_t b = (src[i].morton >> shift) & 0xFFu; \
-                dst[hist[b]++] = src[i]; \
+        TYPE *src_ = (src_array); \
+        int n_ = (count); \
+        for (int i_ = 0; i_ < n_; i_++) sortKeys[i_] = ((uint64_t)src_[i_].morton << 32) | (uint32_t)i_; \
+        sortRecordsByKeys(src_, (dst_array), sizeof(TYPE), n_); \
+    } while (0)
+
+// Sort only the unsorted tail [sorted, count) and merge it into the sorted
+// prefix from the back. A handful of new or moved lights then costs one
+// pass of moves instead of four full radix passes. Equal keys keep the
+// prefix first. Needs 2 * tail records of scratch.
+#define MERGE_SORTED_TAIL_IMPL(TYPE, array, scratch, sorted, count) \
+    do { \
+        int k = (count) - (sorted); \
+        TYPE *tail = scratch; \
+        memcpy(tail, &array[sorted], (size_t)k * sizeof(TYPE)); \
+        RADIX_SORT_IMPL(TYPE, tail, (scratch + k), k); \
+        int i = (sorted) - 1, j = k - 1, o = (count) - 1; \
+        while (j >= 0) { \
+            if (i >= 0 && array[i].morton > tail[j].morton) array[o--] = array[i--]; \
+            else array[o--] = tail[j--]; \
+        } \
+    } while (0)
+
+// Record the current index of lights appended since the last reorder, so
+// syncLightOrder can tell the host where every light moved from
+#define STAMP_ORDER(array, count, t) \
+    do { \
+        for (int i_ = orderStamped[t]; i_ < (count); i_++) array[i_].order = (uint32_t)i_; \
+        orderStamped[t] = (count); \
+    } while (0)
+
+// Pull the resort-flagged records out of the sorted prefix: the others
+// close up in order and the flagged ones follow them, joining the unsorted
+// tail. Moving a few lights then costs one pass over the prefix instead of
+// truncating it at the first moved index.
+#define EXTRACT_MOVED(TYPE, array, scratch, t) \
+    do { \
+        int sorted_ = sortedCount[t], kept_ = 0, moved_ = 0; \
+        for (int i_ = 0; i_ < sorted_; i_++) { \
+            if (array[i_].resort) { \
+                array[i_].resort = 0; \
+                scratch[moved_++] = array[i_]; \
+            } else if (moved_) { \
+                array[kept_++] = array[i_]; \
+            } else { \
+                kept_++; \
             } \
-            TYPE *tmp = src; src = dst; dst = tmp; \
         } \
-        if (src != src_array) memcpy(src_array, src, (count) * sizeof(TYPE)); \
-    } while(0)
+        memcpy(&array[kept_], scratch, (size_t)moved_ * sizeof(TYPE)); \
+        sortedCount[t] = kept_; \
+        prefixMoved &= ~(1u << (t)); \
+    } while (0)
+
+// Full radix sort when most of the array is unsorted, tail merge otherwise
+#define SORT_LIGHTS(TYPE, array, scratch, count, t, bits) \
+    if (prefixMoved & (1u << (t))) { \
+        STAMP_ORDER(array, count, t); \
+        EXTRACT_MOVED(TYPE, array, scratch, t); \
+    } \
+    if (sortedCount[t] < (count)) { \
+        STAMP_ORDER(array, count, t); \
+        if (((count) - sortedCount[t]) * 8 > (count)) { \
+            RADIX_SORT_IMPL(TYPE, array, scratch, count); \
+        } else { \
+            MERGE_SORTED_TAIL_IMPL(TYPE, array, scratch, sortedCount[t], count); \
+        } \
+        sortedCount[t] = (count); \
+        orderChanged |= 1u << (t); \
+        REBUILD_VISIBILITY_BITS(array, count, bits); \
+    }
+
+// ──────────────────────────────────────────────────────────────
+//                   LIGHT GROUPS
+// ──────────────────────────────────────────────────────────────
+// Keep the scaled bit in sync so identity groups cost nothing at pack time
+ALWAYS_INLINE static void refreshGroupScaled(int group) {
+    const Vec4 *g = &groupScale[group];
+    uint32_t bit = 1u << group;
+    if (g->x == 1.0f && g->y == 1.0f && g->z == 1.0f && g->w == 1.0f) scaledGroups &= ~bit;
+    else scaledGroups |= bit;
+}
+
+EMSCRIPTEN_KEEPALIVE void setLightGroupEnabled(int group, int enabled) {
+    if (group < 0 || group >= MAX_LIGHT_GROUPS) return;
+    if (enabled) disabledGroups &= ~(1u << group);
+    else disabledGroups |= 1u << group;
+}
 
-static void radixSortPointLights(int n) {
-    RADIX_SORT_IMPL(PointLight, pointLights, pointLightsScratch, n);
+EMSCRIPTEN_KEEPALIVE void setLightGroupIntensity(int group, float intensity) {
+    if (group < 0 || group >= MAX_LIGHT_GROUPS) return;
+    groupScale[group].w = intensity;
+    refreshGroupScaled(group);
 }
 
-static void radixSortSpotLights(int n) {
-    RADIX_SORT_IMPL(SpotLight, spotLights, spotLightsScratch, n);
+EMSCRIPTEN_KEEPALIVE void setLightGroupTint(int group, float r, float g, float b) {
+    if (group < 0 || group >= MAX_LIGHT_GROUPS) return;
+    groupScale[group].x = r;
+    groupScale[group].y = g;
+    groupScale[group].z = b;
+    refreshGroupScaled(group);
 }
 
-static void radixSortRectLights(int n) {
-    RADIX_SORT_IMPL(RectLight, rectLights, rectLightsScratch, n);
+EMSCRIPTEN_KEEPALIVE void resetLightGroups(void) {
+    for (int g = 0; g < MAX_LIGHT_GROUPS; g++) {
+        groupScale[g] = (Vec4){1.0f, 1.0f, 1.0f, 1.0f};
+    }
+    disabledGroups = 0;
+    scaledGroups = 0;
 }
 
+EMSCRIPTEN_KEEPALIVE uint32_t getDisabledLightGroups(void) { return disabledGroups; }
+
 // ──────────────────────────────────────────────────────────────
 //                     INITIALISATION / CLEANUP
 // ──────────────────────────────────────────────────────────────
@@ -1028,20 +1748,49 @@ EMSCRIPTEN_KEEPALIVE void init(int count) {
     posix_memalign((void**)&pointLightsScratch, 16, pointBytes);
     posix_memalign((void**)&spotLightsScratch, 16, spotBytes);
     posix_memalign((void**)&rectLightsScratch, 16, rectBytes);
+    posix_memalign((void**)&sortKeys, 16, sizeof(uint64_t) * 2 * (size_t)count);
     
-    posix_memalign((void**)&pointLightTexture, 16, sizeof(PointLightDataOptimized) * (size_t)count);
-    posix_memalign((void**)&spotLightTexture, 16, sizeof(SpotLightData) * (size_t)count);
-    posix_memalign((void**)&rectLightTexture, 16, sizeof(RectLightData) * (size_t)count);
+    // Zeroed so the padding past the last light reads as invisible
+    lightTextureCapacity = (count + LIGHT_TEXTURE_ROW_ALIGN - 1) & ~(LIGHT_TEXTURE_ROW_ALIGN - 1);
+    posix_memalign((void**)&pointLightTexture, 16, sizeof(PointLightDataOptimized) * (size_t)lightTextureCapacity);
+    posix_memalign((void**)&spotLightTexture, 16, sizeof(SpotLightData) * (size_t)lightTextureCapacity);
+    posix_memalign((void**)&rectLightTexture, 16, sizeof(RectLightData) * (size_t)lightTextureCapacity);
+    memset(pointLightTexture, 0, sizeof(PointLightDataOptimized) * (size_t)lightTextureCapacity);
+    memset(spotLightTexture, 0, sizeof(SpotLightData) * (size_t)lightTextureCapacity);
+    memset(rectLightTexture, 0, sizeof(RectLightData) * (size_t)lightTextureCapacity);
+    pointRecords = pointLightTexture;
+    spotRecords = spotLightTexture;
+    rectRecords = rectLightTexture;
+
+    visibilityWords = (count + 31) / 32;
+    pointVisibilityBits = (uint32_t*)calloc((size_t)visibilityWords, sizeof(uint32_t));
+    spotVisibilityBits = (uint32_t*)calloc((size_t)visibilityWords, sizeof(uint32_t));
+    rectVisibilityBits = (uint32_t*)calloc((size_t)visibilityWords, sizeof(uint32_t));
+    // Every light can change at most once per update
+    posix_memalign((void**)&visibilityChanges, 16, sizeof(VisibilityChange) * (size_t)count * 3);
+    visibilityChangeCount = 0;
+    posix_memalign((void**)&pointVisibleList, 16, sizeof(uint32_t) * (size_t)count);
+    posix_memalign((void**)&spotVisibleList, 16, sizeof(uint32_t) * (size_t)count);
+    posix_memalign((void**)&rectVisibleList, 16, sizeof(uint32_t) * (size_t)count);
+    posix_memalign((void**)&lightOrder, 16, sizeof(uint32_t) * (size_t)count);
+    posix_memalign((void**)&patchIndices, 16, sizeof(uint32_t) * (size_t)count);
+    posix_memalign((void**)&patchVectors, 16, sizeof(float) * 3 * (size_t)count);
+    memset(sortedCount, 0, sizeof(sortedCount));
+    prefixMoved = 0;
+    memset(orderStamped, 0, sizeof(orderStamped));
+    orderChanged = 0;
 
     pointLightCount = 0;
     spotLightCount = 0;
     rectLightCount = 0;
     maxLights = count;
+    pointLightLimit = count;
     needsSort = 0;
     hasAnimatedLights = 0;
     hasPointLights = 0;
     hasSpotLights = 0;
     hasRectLights = 0;
+    resetLightGroups();
 }
 
 EMSCRIPTEN_KEEPALIVE void cleanup(void) {
@@ -1049,22 +1798,77 @@ EMSCRIPTEN_KEEPALIVE void cleanup(void) {
     free(pointLightsScratch);
     free(spotLightsScratch);
     free(rectLightsScratch);
+    free(sortKeys);
     free(pointLights);
     free(spotLights);
     free(rectLights);
     free(pointLightTexture);
+    free(staticPointLights);
+    free(staticCells);
     free(spotLightTexture);
     free(rectLightTexture);
+    free(unifiedLightTexture);
+    free(pointVisibilityBits);
+    free(spotVisibilityBits);
+    free(rectVisibilityBits);
+    free(visibilityChanges);
+    free(pointVisibleList);
+    free(spotVisibleList);
+    free(rectVisibleList);
+    free(lightOrder);
+    free(patchIndices);
+    free(patchVectors);
+    free(commandQueue);
+    free(commandScratch);
+    for (int t = 0; t < 3; t++) {
+        free(deltaSnapshots[t]);
+        deltaSnapshots[t] = NULL;
+    }
+    free(deltaBuffer);
+    free(deltaInput);
+    deltaBuffer = deltaInput = NULL;
+    deltaCapacity = deltaInputCapacity = deltaSize = 0;
+    free(genInput);
+    genInput = NULL;
+    genInputCapacity = 0;
+    free(genIndexInput);
+    genIndexInput = NULL;
+    genIndexCapacity = 0;
     
     cameraMatrix = NULL;
     pointLights = NULL;
     spotLights = NULL;
     rectLights = NULL;
+    sortKeys = NULL;
     pointLightTexture = NULL;
+    staticPointLights = NULL;
+    staticCells = NULL;
+    staticPointCount = staticPointCapacity = 0;
+    staticCellCount = staticCellCapacity = 0;
     spotLightTexture = NULL;
     rectLightTexture = NULL;
+    pointRecords = NULL;
+    spotRecords = NULL;
+    rectRecords = NULL;
+    unifiedLightTexture = NULL;
+    unifiedRowCapacity = 0;
+    memset(unifiedLayout, 0, sizeof(unifiedLayout));
+    pointVisibilityBits = NULL;
+    spotVisibilityBits = NULL;
+    rectVisibilityBits = NULL;
+    visibilityChanges = NULL;
+    pointVisibleList = NULL;
+    spotVisibleList = NULL;
+    rectVisibleList = NULL;
+    lightOrder = NULL;
+    patchIndices = NULL;
+    patchVectors = NULL;
+    commandQueue = NULL;
+    commandScratch = NULL;
     
-    pointLightCount = spotLightCount = rectLightCount = maxLights = 0;
+    pointLightCount = spotLightCount = rectLightCount = maxLights = pointLightLimit = 0;
+    lightTextureCapacity = 0;
+    visibilityWords = visibilityChangeCount = 0;
     needsSort = hasAnimatedLights = 0;
 }
 
@@ -1093,7 +1897,7 @@ EMSCRIPTEN_KEEPALIVE float getLODBias(void) {
 EMSCRIPTEN_KEEPALIVE int add(float px, float py, float pz, float radius,
                              float r, float g, float b,
                              float decay, float speed, float animRadius, float intensity) {
-    if (pointLightCount >= maxLights) return -1;
+    if (pointLightCount >= pointLightLimit) return -1;
     
     PointLight *l = &pointLights[pointLightCount];
     l->baseWorldPos = (Vec4){px, py, pz, radius};
@@ -1106,8 +1910,14 @@ EMSCRIPTEN_KEEPALIVE int add(float px, float py, float pz, float radius,
     l->dirty = DIRTY_ALL;
     l->visible = 1;
     l->lodLevel = LOD_FULL;
+    l->visState = 0;
+    l->groupMask = 0;
+    l->layerMask = PACK_LAYER_DEFAULT;
     l->castsShadow = 0;           // Default: no shadows
     l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+    l->shadowSelected = 0;
+    l->resort = 0;
+    memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
 
     // Initialize animation
     l->anim.flags = ANIM_NONE;
@@ -1127,7 +1937,7 @@ EMSCRIPTEN_KEEPALIVE int add(float px, float py, float pz, float radius,
 // Fast add for mass lights
 EMSCRIPTEN_KEEPALIVE int addFast(float px, float py, float pz, float radius,
                                  float r, float g, float b, float intensity) {
-    if (pointLightCount >= maxLights) return -1;
+    if (pointLightCount >= pointLightLimit) return -1;
     
     PointLight *l = &pointLights[pointLightCount];
     l->baseWorldPos = (Vec4){px, py, pz, radius};
@@ -1138,8 +1948,14 @@ EMSCRIPTEN_KEEPALIVE int addFast(float px, float py, float pz, float radius,
     l->morton = computeMorton(px, pz);
     l->visible = 1;
     l->lodLevel = LOD_FULL;
+    l->visState = 0;
+    l->groupMask = 0;
+    l->layerMask = PACK_LAYER_DEFAULT;
     l->castsShadow = 0;           // Default: no shadows
     l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+    l->shadowSelected = 0;
+    l->resort = 0;
+    memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
     l->anim.flags = ANIM_NONE;
     
     needsSort = 1;
@@ -1164,7 +1980,7 @@ EMSCRIPTEN_KEEPALIVE int addPointWithAnimation(
     // Pulse params
     float pulseSpeed, float pulseAmount, uint8_t pulseTarget
 ) {
-    if (pointLightCount >= maxLights) return -1;
+    if (pointLightCount >= pointLightLimit) return -1;
     
     PointLight *l = &pointLights[pointLightCount];
     l->baseWorldPos = (Vec4){px, py, pz, radius};
@@ -1177,6 +1993,14 @@ EMSCRIPTEN_KEEPALIVE int addPointWithAnimation(
     l->dirty = DIRTY_ALL;
     l->visible = 1;
     l->lodLevel = LOD_FULL;
+    l->visState = 0;
+    l->groupMask = 0;
+    l->layerMask = PACK_LAYER_DEFAULT;
+    l->castsShadow = 0;           // Default: no shadows
+    l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+    l->shadowSelected = 0;
+    l->resort = 0;
+    memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
     
     // Setup animation
     l->anim.flags = animFlags;
@@ -1241,7 +2065,8 @@ EMSCRIPTEN_KEEPALIVE int addSpot(float px, float py, float pz, float radius,
     l->baseWorldPos = (Vec4){px, py, pz, radius};
     l->animOffset = (Vec4){0, 0, 0, 0};
     l->worldPos = l->baseWorldPos;
-    l->color = (Vec4){r, g, b, intensity};
+    l->baseColor = (Vec4){r, g, b, intensity};
+    l->color = l->baseColor;
     
     float len = sqrtf(dx*dx + dy*dy + dz*dz);
     float inv = len > 0.f ? 1.f/len : 0.f;
@@ -1255,8 +2080,14 @@ EMSCRIPTEN_KEEPALIVE int addSpot(float px, float py, float pz, float radius,
     l->dirty = DIRTY_ALL;
     l->visible = 1;
     l->lodLevel = LOD_FULL;
+    l->visState = 0;
+    l->groupMask = 0;
+    l->layerMask = PACK_LAYER_DEFAULT;
     l->castsShadow = 0;           // Default: no shadows
     l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+    l->shadowSelected = 0;
+    l->resort = 0;
+    memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
     l->anim.flags = ANIM_NONE;
     
     needsSort = 1;
@@ -1288,7 +2119,8 @@ EMSCRIPTEN_KEEPALIVE int addSpotWithAnimation(
     l->baseWorldPos = (Vec4){px, py, pz, radius};
     l->animOffset = (Vec4){0, 0, 0, 0};
     l->worldPos = l->baseWorldPos;
-    l->color = (Vec4){r, g, b, intensity};
+    l->baseColor = (Vec4){r, g, b, intensity};
+    l->color = l->baseColor;
     
     float len = sqrtf(dx*dx + dy*dy + dz*dz);
     float inv = len > 0.f ? 1.f/len : 0.f;
@@ -1302,6 +2134,14 @@ EMSCRIPTEN_KEEPALIVE int addSpotWithAnimation(
     l->dirty = DIRTY_ALL;
     l->visible = 1;
     l->lodLevel = LOD_FULL;
+    l->visState = 0;
+    l->groupMask = 0;
+    l->layerMask = PACK_LAYER_DEFAULT;
+    l->castsShadow = 0;           // Default: no shadows
+    l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+    l->shadowSelected = 0;
+    l->resort = 0;
+    memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
     
     // Setup animation
     l->anim.flags = animFlags;
@@ -1360,7 +2200,8 @@ EMSCRIPTEN_KEEPALIVE int addRect(float px, float py, float pz,
     l->baseWorldPos = (Vec4){px, py, pz, radius};
     l->animOffset = (Vec4){0, 0, 0, 0};
     l->worldPos = l->baseWorldPos;
-    l->color = (Vec4){r, g, b, intensity};
+    l->baseColor = (Vec4){r, g, b, intensity};
+    l->color = l->baseColor;
     l->size = (Vec4){width, height, 0.f, 0.f};
     
     float len = sqrtf(nx*nx + ny*ny + nz*nz);
@@ -1369,17 +2210,21 @@ EMSCRIPTEN_KEEPALIVE int addRect(float px, float py, float pz,
     l->baseNormal = l->normal;
 
     // Initialize tangent and bitangent basis vectors
-    buildOrthonormalBasis(&l->normal, &l->tangent, &l->bitangent);
-    l->baseTangent = l->tangent;
-    l->baseBitangent = l->bitangent;
+    buildRectFrame(l);
 
     l->decay = decay;
     l->morton = computeMorton(px, pz);
     l->dirty = DIRTY_ALL;
     l->visible = 1;
     l->lodLevel = LOD_FULL;
+    l->visState = 0;
+    l->groupMask = 0;
+    l->layerMask = PACK_LAYER_DEFAULT;
     l->castsShadow = 0;           // Default: no shadows
     l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+    l->shadowSelected = 0;
+    l->resort = 0;
+    memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
     l->anim.flags = ANIM_NONE;
 
     needsSort = 1;
@@ -1411,7 +2256,8 @@ EMSCRIPTEN_KEEPALIVE int addRectWithAnimation(
     l->baseWorldPos = (Vec4){px, py, pz, radius};
     l->animOffset = (Vec4){0, 0, 0, 0};
     l->worldPos = l->baseWorldPos;
-    l->color = (Vec4){r, g, b, intensity};
+    l->baseColor = (Vec4){r, g, b, intensity};
+    l->color = l->baseColor;
     l->size = (Vec4){width, height, 0.f, 0.f};
     
     float len = sqrtf(nx*nx + ny*ny + nz*nz);
@@ -1420,15 +2266,21 @@ EMSCRIPTEN_KEEPALIVE int addRectWithAnimation(
     l->baseNormal = l->normal;
 
     // Initialize tangent and bitangent basis vectors
-    buildOrthonormalBasis(&l->normal, &l->tangent, &l->bitangent);
-    l->baseTangent = l->tangent;
-    l->baseBitangent = l->bitangent;
+    buildRectFrame(l);
 
     l->decay = decay;
     l->morton = computeMorton(px, pz);
     l->dirty = DIRTY_ALL;
     l->visible = 1;
     l->lodLevel = LOD_FULL;
+    l->visState = 0;
+    l->groupMask = 0;
+    l->layerMask = PACK_LAYER_DEFAULT;
+    l->castsShadow = 0;           // Default: no shadows
+    l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+    l->shadowSelected = 0;
+    l->resort = 0;
+    memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
     
     // Setup animation
     l->anim.flags = animFlags;
@@ -1489,8 +2341,8 @@ EMSCRIPTEN_KEEPALIVE int bulkAddPointLights(
     uint32_t* animFlags,   // animation flags per light
     float* animParams      // all anim params packed: [circular(2), wave(6), flicker(3), pulse(3)] = 14 floats per light
 ) {
-    if (pointLightCount + count > maxLights) {
-        count = maxLights - pointLightCount; // Clamp to available space
+    if (pointLightCount + count > pointLightLimit) {
+        count = pointLightLimit - pointLightCount; // Clamp to available space
     }
 
     int added = 0;
@@ -1517,6 +2369,14 @@ EMSCRIPTEN_KEEPALIVE int bulkAddPointLights(
         l->dirty = DIRTY_ALL;
         l->visible = 1;
         l->lodLevel = LOD_FULL;
+        l->visState = 0;
+        l->groupMask = 0;
+        l->layerMask = PACK_LAYER_DEFAULT;
+        l->castsShadow = 0;           // Default: no shadows
+        l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+        l->shadowSelected = 0;
+        l->resort = 0;
+        memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
 
         // Animation - packed format: [circular(2), wave(6), flicker(3), pulse(3)]
         l->anim.flags = animFlags ? animFlags[i] : ANIM_NONE;
@@ -1599,13 +2459,14 @@ EMSCRIPTEN_KEEPALIVE int bulkAddLights(
 ) {
     int pointAdded = 0, spotAdded = 0, rectAdded = 0;
     int spotIdx = 0, rectIdx = 0;
+    int firstRect = rectLightCount;
 
     for (int i = 0; i < count; i++) {
         uint8_t type = types[i];
         int pi = i * 4;  // Position index
 
         if (type == 0) {  // Point light
-            if (pointLightCount >= maxLights) continue;
+            if (pointLightCount >= pointLightLimit) continue;
 
             PointLight *l = &pointLights[pointLightCount];
 
@@ -1628,6 +2489,14 @@ EMSCRIPTEN_KEEPALIVE int bulkAddLights(
             l->dirty = DIRTY_ALL;
             l->visible = 1;
             l->lodLevel = LOD_FULL;
+            l->visState = 0;
+            l->groupMask = 0;
+            l->layerMask = PACK_LAYER_DEFAULT;
+            l->castsShadow = 0;           // Default: no shadows
+            l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+            l->shadowSelected = 0;
+            l->resort = 0;
+            memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
 
             // Animation
             l->anim.flags = animFlags ? animFlags[i] : ANIM_NONE;
@@ -1685,7 +2554,8 @@ EMSCRIPTEN_KEEPALIVE int bulkAddLights(
             l->worldPos = l->baseWorldPos;
 
             // Color and intensity
-            l->color = (Vec4){colors[pi], colors[pi+1], colors[pi+2], colors[pi+3]};
+            l->baseColor = (Vec4){colors[pi], colors[pi+1], colors[pi+2], colors[pi+3]};
+            l->color = l->baseColor;
 
             // Direction, angle, penumbra
             l->direction = (Vec4){spotParams[si], spotParams[si+1], spotParams[si+2], 0};
@@ -1703,6 +2573,14 @@ EMSCRIPTEN_KEEPALIVE int bulkAddLights(
             l->dirty = DIRTY_ALL;
             l->visible = 1;
             l->lodLevel = LOD_FULL;
+            l->visState = 0;
+            l->groupMask = 0;
+            l->layerMask = PACK_LAYER_DEFAULT;
+            l->castsShadow = 0;           // Default: no shadows
+            l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+            l->shadowSelected = 0;
+            l->resort = 0;
+            memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
 
             // Animation
             l->anim.flags = animFlags ? animFlags[i] : ANIM_NONE;
@@ -1751,7 +2629,8 @@ EMSCRIPTEN_KEEPALIVE int bulkAddLights(
             l->worldPos = l->baseWorldPos;
 
             // Color and intensity
-            l->color = (Vec4){colors[pi], colors[pi+1], colors[pi+2], colors[pi+3]};
+            l->baseColor = (Vec4){colors[pi], colors[pi+1], colors[pi+2], colors[pi+3]};
+            l->color = l->baseColor;
 
             // Size and normal
             l->size = (Vec4){rectParams[ri], rectParams[ri+1], 0, 0};
@@ -1764,11 +2643,7 @@ EMSCRIPTEN_KEEPALIVE int bulkAddLights(
             float ninv = nlen > 0.f ? 1.f/nlen : 0.f;
             l->normal = (Vec4){nx*ninv, ny*ninv, nz*ninv, 0.f};
             l->baseNormal = l->normal;
-
-            // Build orthonormal basis (tangent/bitangent) from normal
-            buildOrthonormalBasis(&l->normal, &l->tangent, &l->bitangent);
-            l->baseTangent = l->tangent;
-            l->baseBitangent = l->bitangent;
+            // Tangent frames are built in one batch after the loop
 
             // Decay
             l->decay = decays[i];
@@ -1780,6 +2655,14 @@ EMSCRIPTEN_KEEPALIVE int bulkAddLights(
             l->dirty = DIRTY_ALL;
             l->visible = 1;
             l->lodLevel = LOD_FULL;
+            l->visState = 0;
+            l->groupMask = 0;
+            l->layerMask = PACK_LAYER_DEFAULT;
+            l->castsShadow = 0;           // Default: no shadows
+            l->shadowIntensity = 0.3f;    // Default: moderate shadow darkness
+            l->shadowSelected = 0;
+            l->resort = 0;
+            memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
 
             // Animation
             l->anim.flags = animFlags ? animFlags[i] : ANIM_NONE;
@@ -1818,27 +2701,532 @@ EMSCRIPTEN_KEEPALIVE int bulkAddLights(
         }
     }
 
+    buildRectFrames(firstRect, NULL, rectLightCount - firstRect);
+
     needsSort = 1;
     return pointAdded + spotAdded + rectAdded;
 }
 
 // ──────────────────────────────────────────────────────────────
-//                   LIGHT REMOVAL
+//                   LIGHT GENERATORS
 // ──────────────────────────────────────────────────────────────
-EMSCRIPTEN_KEEPALIVE void removePointLight(int idx) {
-    if (idx >= 0 && idx < pointLightCount) {
-        if (pointLights[idx].anim.flags != ANIM_NONE) {
-            // Check if this was the last animated light
-            hasAnimatedLights = 0;
-            for (int i = 0; i < pointLightCount; i++) {
-                if (i != idx && pointLights[i].anim.flags != ANIM_NONE) {
-                    hasAnimatedLights = 1;
-                    break;
-                }
-            }
-            if (!hasAnimatedLights) {
-                for (int i = 0; i < spotLightCount; i++) {
-                    if (spotLights[i].anim.flags != ANIM_NONE) {
+// Procedural point-light fields written straight into the light array, so
+// large scenes need neither host loops nor a packed staging copy. The same
+// seed always produces the same field. Lights are styled from genStyle
+// (getLightGeneratorStyle); the palette and any shape data are read from
+// getLightGeneratorInput(). Generators return the number of lights added,
+// clamped to the free capacity, or -1 on invalid input.
+static LightGenStyle genStyle = {
+    {2.0f, 6.0f}, {1.0f, 4.0f}, 2.0f, {1.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {0.5f, 1.5f}, {0.5f, 2.0f}, {0.5f, 1.5f}, {0.5f, 2.0f}, {0.0f, 1.0f, 0.0f},
+    {2.0f, 8.0f}, {0.2f, 0.5f}, {0.5f, 2.0f}, {0.2f, 0.5f}, PULSE_INTENSITY,
+    0.0f, 0, 0, PACK_LAYER_DEFAULT
+};
+
+#define GEN_MAX_POISSON_CELLS (1 << 24)
+
+// xorshift32 seeded through an integer hash (seed 0 is valid)
+ALWAYS_INLINE static uint32_t genSeed(uint32_t seed) {
+    seed ^= seed >> 16; seed *= 0x7feb352du;
+    seed ^= seed >> 15; seed *= 0x846ca68bu;
+    seed ^= seed >> 16;
+    return seed ? seed : 0x9e3779b9u;
+}
+
+ALWAYS_INLINE static float genRandom(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    *s = x;
+    return (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+ALWAYS_INLINE static float genRange(uint32_t *s, const float range[2]) {
+    return range[0] + (range[1] - range[0]) * genRandom(s);
+}
+
+// Random unit vector over the axes whose `mask` bit is set (x = 1, y = 2, z = 4)
+static void genDirection(uint32_t *s, int mask, float d[3]) {
+    for (;;) {
+        float len2 = 0.0f;
+        for (int a = 0; a < 3; a++) {
+            d[a] = (mask >> a) & 1 ? genRandom(s) * 2.0f - 1.0f : 0.0f;
+            len2 += d[a] * d[a];
+        }
+        if (len2 > 1e-6f && len2 <= 1.0f) {
+            float inv = 1.0f / sqrtf(len2);
+            d[0] *= inv; d[1] *= inv; d[2] *= inv;
+            return;
+        }
+    }
+}
+
+ALWAYS_INLINE static int genAvailable(int requested) {
+    int free = pointLightLimit - pointLightCount;
+    return requested < free ? requested : free;
+}
+
+// Palette entry or blend; white without a palette, or if the palette does
+// not fit in the generator input
+static void genColor(uint32_t *s, float *r, float *g, float *b) {
+    int n = genStyle.paletteCount;
+    if (n <= 0 || !genInput || n > genInputCapacity / 3) { *r = *g = *b = 1.0f; return; }
+
+    const float *p = genInput;
+    if (genStyle.paletteBlend > 0.0f && n > 1) {
+        float u = genRandom(s) * (float)(n - 1);
+        int i = (int)u;
+        if (i > n - 2) i = n - 2;
+        float f = (u - (float)i) * genStyle.paletteBlend;
+        const float *a = p + i * 3, *c = a + 3;
+        *r = a[0] + (c[0] - a[0]) * f;
+        *g = a[1] + (c[1] - a[1]) * f;
+        *b = a[2] + (c[2] - a[2]) * f;
+    } else {
+        int i = (int)(genRandom(s) * (float)n);
+        if (i >= n) i = n - 1;
+        *r = p[i * 3]; *g = p[i * 3 + 1]; *b = p[i * 3 + 2];
+    }
+}
+
+// Initialise point light `idx` at (x, y, z) the way bulkAddPointLights does,
+// drawing radius, intensity, colour and animation from genStyle.
+// Returns 1 when the light is animated.
+static int genWriteLight(int idx, float x, float y, float z, uint32_t *s) {
+    PointLight *l = &pointLights[idx];
+    float r, g, b;
+    genColor(s, &r, &g, &b);
+
+    l->baseWorldPos = (Vec4){x, y, z, genRange(s, genStyle.radius)};
+    l->animOffset = (Vec4){0, 0, 0, 0};
+    l->worldPos = l->baseWorldPos;
+    l->baseColor = (Vec4){r, g, b, genRange(s, genStyle.intensity)};
+    l->color = l->baseColor;
+    l->decay = genStyle.decay;
+    l->morton = computeMorton(x, z);
+    l->dirty = DIRTY_ALL;
+    l->visible = 1;
+    l->lodLevel = LOD_FULL;
+    l->visState = 0;
+    l->groupMask = genStyle.groupMask;
+    l->layerMask = (uint8_t)genStyle.layerMask;
+    l->castsShadow = 0;
+    l->shadowIntensity = 0.3f;
+    l->shadowSelected = 0;
+    l->resort = 0;
+    memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
+    memset(&l->anim, 0, sizeof(l->anim));
+
+    const float *w = genStyle.animWeights;
+    float total = w[0] + w[1] + w[2] + w[3] + w[4];
+    if (total <= 0.0f) return 0;
+
+    float pick = genRandom(s) * total;
+    int kind = 0;
+    while (kind < 4 && pick >= w[kind]) pick -= w[kind++];
+    if (w[kind] <= 0.0f) return 0;  // Rounding walked past the last non-zero weight
+
+    switch (kind) {
+        case 1:
+            l->anim.flags = ANIM_CIRCULAR;
+            l->anim.circular.speed = genRange(s, genStyle.circularSpeed);
+            l->anim.circular.radius = genRange(s, genStyle.circularRadius);
+            break;
+        case 2: {
+            float ax = genStyle.waveAxis[0], ay = genStyle.waveAxis[1], az = genStyle.waveAxis[2];
+            float len = sqrtf(ax * ax + ay * ay + az * az);
+            if (len > 0.0f) { ax /= len; ay /= len; az /= len; }
+            else { float d[3]; genDirection(s, 7, d); ax = d[0]; ay = d[1]; az = d[2]; }
+            l->anim.flags = ANIM_WAVE;
+            l->anim.wave.axis = (Vec4){ax, ay, az, 0.0f};
+            l->anim.wave.speed = genRange(s, genStyle.waveSpeed);
+            l->anim.wave.amplitude = genRange(s, genStyle.waveAmplitude);
+            l->anim.wave.phase = genRandom(s) * 6.2831853f;
+            break;
+        }
+        case 3:
+            l->anim.flags = ANIM_FLICKER;
+            l->anim.flicker.speed = genRange(s, genStyle.flickerSpeed);
+            l->anim.flicker.intensity = genRange(s, genStyle.flickerIntensity);
+            l->anim.flicker.seed = genRandom(s) * 100.0f;
+            break;
+        case 4:
+            l->anim.flags = ANIM_PULSE;
+            l->anim.pulse.speed = genRange(s, genStyle.pulseSpeed);
+            l->anim.pulse.amount = genRange(s, genStyle.pulseAmount);
+            l->anim.pulse.target = (uint8_t)genStyle.pulseTarget;
+            break;
+        default:
+            return 0;
+    }
+    return 1;
+}
+
+static int genFinish(int added, int animated) {
+    pointLightCount += added;
+    if (added > 0) {
+        needsSort = 1;
+        hasPointLights = 1;
+    }
+    if (animated) hasAnimatedLights = 1;
+    return added;
+}
+
+// Shape data follows the palette in the generator input. Sizes are 64-bit
+// so host-supplied counts cannot wrap past the capacity check.
+ALWAYS_INLINE static const float* genShape(int64_t floats) {
+    int64_t offset = (int64_t)genStyle.paletteCount * 3;
+    if (!genInput || offset < 0 || floats < 0 || offset + floats > genInputCapacity) return NULL;
+    return genInput + offset;
+}
+
+EMSCRIPTEN_KEEPALIVE LightGenStyle* getLightGeneratorStyle(void) { return &genStyle; }
+
+// Input buffer of at least `floats` floats: palette rgb triples, then shape
+// data (NULL on OOM). Growing it may move it, so take views afterwards.
+EMSCRIPTEN_KEEPALIVE float* getLightGeneratorInput(int floats) {
+    if (floats > genInputCapacity) {
+        float *grown = (float*)realloc(genInput, sizeof(float) * (size_t)floats);
+        if (!grown) return NULL;
+        genInput = grown;
+        genInputCapacity = floats;
+    }
+    return genInput;
+}
+
+// Input buffer of at least `count` uint32 mesh indices for generateMeshLights
+// (NULL on OOM). Growing it may move it, so take views afterwards.
+EMSCRIPTEN_KEEPALIVE uint32_t* getLightGeneratorIndexInput(int count) {
+    if (count > genIndexCapacity) {
+        uint32_t *grown = (uint32_t*)realloc(genIndexInput, sizeof(uint32_t) * (size_t)count);
+        if (!grown) return NULL;
+        genIndexInput = grown;
+        genIndexCapacity = count;
+    }
+    return genIndexInput;
+}
+
+// nx * ny * nz lights at the cell centres of a box, each displaced by up to
+// `jitter` (0..1) of a cell for a jittered grid
+EMSCRIPTEN_KEEPALIVE int generateGridLights(int nx, int ny, int nz,
+                                            float minX, float minY, float minZ,
+                                            float maxX, float maxY, float maxZ,
+                                            float jitter, uint32_t seed) {
+    if (nx <= 0 || ny <= 0 || nz <= 0 || !pointLights) return -1;
+
+    int avail = genAvailable((int)fminf((float)nx * (float)ny * (float)nz, (float)INT32_MAX));
+    float cx = (maxX - minX) / (float)nx;
+    float cy = (maxY - minY) / (float)ny;
+    float cz = (maxZ - minZ) / (float)nz;
+    uint32_t s = genSeed(seed);
+    int base = pointLightCount, added = 0, animated = 0;
+
+    for (int y = 0; y < ny && added < avail; y++) {
+        for (int z = 0; z < nz && added < avail; z++) {
+            for (int x = 0; x < nx && added < avail; x++) {
+                float px = minX + ((float)x + 0.5f) * cx;
+                float py = minY + ((float)y + 0.5f) * cy;
+                float pz = minZ + ((float)z + 0.5f) * cz;
+                if (jitter > 0.0f) {
+                    px += (genRandom(&s) - 0.5f) * jitter * cx;
+                    py += (genRandom(&s) - 0.5f) * jitter * cy;
+                    pz += (genRandom(&s) - 0.5f) * jitter * cz;
+                }
+                animated |= genWriteLight(base + added, px, py, pz, &s);
+                added++;
+            }
+        }
+    }
+    return genFinish(added, animated);
+}
+
+// Poisson-disc field (Bridson): up to maxCount lights in a box, no two closer
+// than minDist. Axes thinner than minDist are sampled uniformly, so a flat
+// box gives a 2D distribution. `attempts` candidates per active light (30).
+EMSCRIPTEN_KEEPALIVE int generatePoissonLights(int maxCount, float minDist,
+                                               float minX, float minY, float minZ,
+                                               float maxX, float maxY, float maxZ,
+                                               int attempts, uint32_t seed) {
+    if (maxCount <= 0 || !(minDist > 0.0f) || !pointLights) return -1;
+    if (attempts <= 0) attempts = 30;
+
+    float lo[3] = {minX, minY, minZ};
+    float ext[3] = {maxX - minX, maxY - minY, maxZ - minZ};
+    int flat[3], dims = 0, axes = 0;
+    for (int a = 0; a < 3; a++) {
+        if (ext[a] < 0.0f) return -1;
+        flat[a] = ext[a] < minDist;
+        dims += !flat[a];
+        if (!flat[a]) axes |= 1 << a;
+    }
+
+    int avail = genAvailable(maxCount);
+    uint32_t s = genSeed(seed);
+    int base = pointLightCount;
+    if (avail <= 0) return 0;
+    if (dims == 0) {
+        // The whole box fits in one disc
+        int animated = genWriteLight(base, minX + genRandom(&s) * ext[0],
+                                     minY + genRandom(&s) * ext[1],
+                                     minZ + genRandom(&s) * ext[2], &s);
+        return genFinish(1, animated);
+    }
+
+    // One light per background cell: the cell diagonal over the sampled axes
+    // is minDist. Sampled axes get a 2-cell border so neighbour lookups need
+    // no bounds checks.
+    float cell = minDist / sqrtf((float)dims);
+    float invCell = 1.0f / cell;
+    int g[3], pad[3];
+    size_t cells = 1;
+    for (int a = 0; a < 3; a++) {
+        g[a] = flat[a] ? 1 : (int)ceilf(ext[a] * invCell);
+        if (g[a] < 1) g[a] = 1;
+        pad[a] = flat[a] ? 0 : 2;
+        cells *= (size_t)(g[a] + pad[a] * 2);
+        if (cells > GEN_MAX_POISSON_CELLS) return -1;
+    }
+    const ptrdiff_t strideZ = g[0] + pad[0] * 2;
+    const ptrdiff_t strideY = strideZ * (g[2] + pad[2] * 2);
+
+    // Neighbour cells that can hold a light closer than minDist
+    ptrdiff_t neighbours[125];
+    int neighbourCount = 0;
+    for (int y = -pad[1]; y <= pad[1]; y++) {
+        for (int z = -pad[2]; z <= pad[2]; z++) {
+            for (int x = -pad[0]; x <= pad[0]; x++) {
+                int gap = (abs(x) > 1) + (abs(y) > 1) + (abs(z) > 1);
+                if (gap < dims) neighbours[neighbourCount++] = y * strideY + z * strideZ + x;
+            }
+        }
+    }
+
+    int32_t *grid = (int32_t*)calloc(cells, sizeof(int32_t));   // light index + 1
+    int32_t *active = (int32_t*)malloc(sizeof(int32_t) * (size_t)avail);
+    Vec4 *pos = (Vec4*)malloc(sizeof(Vec4) * (size_t)avail);    // Compact copy for neighbour tests
+    if (!grid || !active || !pos) {
+        free(grid);
+        free(active);
+        free(pos);
+        return -1;
+    }
+
+    const float minDist2 = minDist * minDist;
+    int added = 0, animated = 0, activeCount = 0;
+
+#define GEN_CELL(p, a) (flat[a] ? 0 : (int)fminf(((p) - lo[a]) * invCell, (float)(g[a] - 1)) + 2)
+#define GEN_CELL_INDEX(p) ((ptrdiff_t)GEN_CELL((p)[1], 1) * strideY + \
+                           (ptrdiff_t)GEN_CELL((p)[2], 2) * strideZ + GEN_CELL((p)[0], 0))
+
+    float p[3];
+    for (int a = 0; a < 3; a++) p[a] = lo[a] + genRandom(&s) * ext[a];
+    animated |= genWriteLight(base, p[0], p[1], p[2], &s);
+    pos[0] = (Vec4){p[0], p[1], p[2], 0.0f};
+    grid[GEN_CELL_INDEX(p)] = 1;
+    active[activeCount++] = 0;
+    added = 1;
+
+    while (activeCount > 0 && added < avail) {
+        int slot = (int)(genRandom(&s) * (float)activeCount);
+        if (slot >= activeCount) slot = activeCount - 1;
+        const Vec4 o = pos[active[slot]];
+        int placed = 0;
+
+        for (int k = 0; k < attempts && !placed; k++) {
+            float d[3];
+            genDirection(&s, axes, d);
+            float dist = minDist * (1.0f + genRandom(&s));
+            p[0] = flat[0] ? lo[0] + genRandom(&s) * ext[0] : o.x + d[0] * dist;
+            p[1] = flat[1] ? lo[1] + genRandom(&s) * ext[1] : o.y + d[1] * dist;
+            p[2] = flat[2] ? lo[2] + genRandom(&s) * ext[2] : o.z + d[2] * dist;
+            if (p[0] < lo[0] || p[0] > lo[0] + ext[0] ||
+                p[1] < lo[1] || p[1] > lo[1] + ext[1] ||
+                p[2] < lo[2] || p[2] > lo[2] + ext[2]) continue;
+
+            const ptrdiff_t c = GEN_CELL_INDEX(p);
+            // An occupied own cell always rejects, even across a flat axis
+            if (grid[c]) continue;
+
+            int clear = 1;
+            for (int n = 0; n < neighbourCount; n++) {
+                int32_t other = grid[c + neighbours[n]];
+                if (!other) continue;
+                const Vec4 *q = &pos[other - 1];
+                float dx = q->x - p[0], dy = q->y - p[1], dz = q->z - p[2];
+                if (dx * dx + dy * dy + dz * dz < minDist2) {
+                    clear = 0;
+                    break;
+                }
+            }
+            if (!clear) continue;
+
+            animated |= genWriteLight(base + added, p[0], p[1], p[2], &s);
+            pos[added] = (Vec4){p[0], p[1], p[2], 0.0f};
+            grid[c] = added + 1;
+            active[activeCount++] = added;
+            added++;
+            placed = 1;
+        }
+
+        if (!placed) active[slot] = active[--activeCount];
+    }
+
+#undef GEN_CELL_INDEX
+#undef GEN_CELL
+
+    free(grid);
+    free(active);
+    free(pos);
+    return genFinish(added, animated);
+}
+
+// Lights every `spacing` units along a polyline of pointCount xyz points
+// (shape data), starting at the first point. `closed` adds the segment back
+// to the start; `jitter` displaces each light randomly by up to that distance.
+EMSCRIPTEN_KEEPALIVE int generatePolylineLights(int pointCount, float spacing, int closed,
+                                                float jitter, uint32_t seed) {
+    const float *pts = genShape((int64_t)pointCount * 3);
+    if (!pts || pointCount <= 0 || !(spacing > 0.0f) || !pointLights) return -1;
+
+    int avail = genAvailable(maxLights);
+    int segments = closed && pointCount > 2 ? pointCount : pointCount - 1;
+    uint32_t s = genSeed(seed);
+    int base = pointLightCount, added = 0, animated = 0;
+    float carry = 0.0f;  // Distance into the current segment of the next light
+
+#define GEN_EMIT(px, py, pz) do { \
+    float j_[3] = {0.0f, 0.0f, 0.0f}; \
+    if (jitter > 0.0f) { \
+        genDirection(&s, 7, j_); \
+        float r_ = jitter * cbrtf(genRandom(&s)); \
+        j_[0] *= r_; j_[1] *= r_; j_[2] *= r_; \
+    } \
+    animated |= genWriteLight(base + added, (px) + j_[0], (py) + j_[1], (pz) + j_[2], &s); \
+    added++; \
+} while (0)
+
+    if (segments <= 0) {
+        if (avail > 0) GEN_EMIT(pts[0], pts[1], pts[2]);
+        return genFinish(added, animated);
+    }
+
+    for (int i = 0; i < segments && added < avail; i++) {
+        const float *a = pts + i * 3;
+        const float *b = pts + ((i + 1) % pointCount) * 3;
+        float dx = b[0] - a[0], dy = b[1] - a[1], dz = b[2] - a[2];
+        float len = sqrtf(dx * dx + dy * dy + dz * dz);
+        // A light landing on the end of an open path is kept
+        int last = !closed && i == segments - 1;
+        while (added < avail && (carry < len || (last && carry <= len + spacing * 1e-3f))) {
+            float t = len > 0.0f ? fminf(carry / len, 1.0f) : 0.0f;
+            GEN_EMIT(a[0] + dx * t, a[1] + dy * t, a[2] + dz * t);
+            carry += spacing;
+        }
+        carry -= len;
+    }
+
+#undef GEN_EMIT
+
+    return genFinish(added, animated);
+}
+
+// `count` lights sampled uniformly by area over a triangle mesh: vertexCount
+// xyz positions (shape data) and indexCount indices from
+// getLightGeneratorIndexInput(), or unindexed triangles when indexCount is 0.
+// Lights sit `offset` units off the surface along the face normal.
+EMSCRIPTEN_KEEPALIVE int generateMeshLights(int count, int vertexCount, int indexCount,
+                                            float offset, uint32_t seed) {
+    const float *verts = genShape((int64_t)vertexCount * 3);
+    if (!verts || count <= 0 || vertexCount <= 0 || indexCount < 0 || !pointLights) return -1;
+    if (indexCount > genIndexCapacity) return -1;
+
+    const uint32_t *indices = indexCount ? genIndexInput : NULL;
+    int triCount = (indexCount ? indexCount : vertexCount) / 3;
+    if (triCount <= 0) return -1;
+    if (indices) {
+        for (int i = 0; i < triCount * 3; i++) {
+            if (indices[i] >= (uint32_t)vertexCount) return -1;
+        }
+    }
+
+    // Cumulative area for area-weighted triangle selection
+    float *cdf = (float*)malloc(sizeof(float) * (size_t)triCount);
+    if (!cdf) return -1;
+    double total = 0.0;
+    for (int t = 0; t < triCount; t++) {
+        const float *a = verts + (indices ? indices[t * 3] : (uint32_t)t * 3) * 3;
+        const float *b = verts + (indices ? indices[t * 3 + 1] : (uint32_t)t * 3 + 1) * 3;
+        const float *c = verts + (indices ? indices[t * 3 + 2] : (uint32_t)t * 3 + 2) * 3;
+        float ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+        float vx = c[0] - a[0], vy = c[1] - a[1], vz = c[2] - a[2];
+        float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+        total += 0.5 * sqrt((double)(nx * nx + ny * ny + nz * nz));
+        cdf[t] = (float)total;
+    }
+    if (!(total > 0.0)) {
+        free(cdf);
+        return -1;
+    }
+
+    int avail = genAvailable(count);
+    uint32_t s = genSeed(seed);
+    int base = pointLightCount, animated = 0;
+
+    for (int i = 0; i < avail; i++) {
+        float target = genRandom(&s) * (float)total;
+        int lo = 0, hi = triCount - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (cdf[mid] <= target) lo = mid + 1; else hi = mid;
+        }
+
+        const float *a = verts + (indices ? indices[lo * 3] : (uint32_t)lo * 3) * 3;
+        const float *b = verts + (indices ? indices[lo * 3 + 1] : (uint32_t)lo * 3 + 1) * 3;
+        const float *c = verts + (indices ? indices[lo * 3 + 2] : (uint32_t)lo * 3 + 2) * 3;
+
+        // Uniform barycentrics
+        float r1 = sqrtf(genRandom(&s)), r2 = genRandom(&s);
+        float wa = 1.0f - r1, wb = r1 * (1.0f - r2), wc = r1 * r2;
+        float px = a[0] * wa + b[0] * wb + c[0] * wc;
+        float py = a[1] * wa + b[1] * wb + c[1] * wc;
+        float pz = a[2] * wa + b[2] * wb + c[2] * wc;
+
+        if (offset != 0.0f) {
+            float ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+            float vx = c[0] - a[0], vy = c[1] - a[1], vz = c[2] - a[2];
+            float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+            float len = sqrtf(nx * nx + ny * ny + nz * nz);
+            if (len > 0.0f) {
+                float k = offset / len;
+                px += nx * k; py += ny * k; pz += nz * k;
+            }
+        }
+
+        animated |= genWriteLight(base + i, px, py, pz, &s);
+    }
+
+    free(cdf);
+    return genFinish(avail > 0 ? avail : 0, animated);
+}
+
+// ──────────────────────────────────────────────────────────────
+//                   LIGHT REMOVAL
+// ──────────────────────────────────────────────────────────────
+EMSCRIPTEN_KEEPALIVE void removePointLight(int idx) {
+    // Queued commands address lights by their index before the removal
+    if (commandQueue) drainLightCommands();
+    if (idx >= 0 && idx < pointLightCount) {
+        if (pointLights[idx].anim.flags != ANIM_NONE) {
+            // Check if this was the last animated light
+            hasAnimatedLights = 0;
+            for (int i = 0; i < pointLightCount; i++) {
+                if (i != idx && pointLights[i].anim.flags != ANIM_NONE) {
+                    hasAnimatedLights = 1;
+                    break;
+                }
+            }
+            if (!hasAnimatedLights) {
+                for (int i = 0; i < spotLightCount; i++) {
+                    if (spotLights[i].anim.flags != ANIM_NONE) {
                         hasAnimatedLights = 1;
                         break;
                     }
@@ -1854,15 +3242,22 @@ EMSCRIPTEN_KEEPALIVE void removePointLight(int idx) {
             }
         }
         
+        STAMP_ORDER(pointLights, pointLightCount, LIGHT_TYPE_POINT);
         memmove(&pointLights[idx], &pointLights[idx+1], 
                 (size_t)(pointLightCount - idx - 1) * sizeof(PointLight));
         pointLightCount--;
+        orderStamped[LIGHT_TYPE_POINT] = pointLightCount;
+        if (idx < sortedCount[LIGHT_TYPE_POINT]) sortedCount[LIGHT_TYPE_POINT]--;
+        orderChanged |= 1u << LIGHT_TYPE_POINT;
+        REBUILD_VISIBILITY_BITS(pointLights, pointLightCount, pointVisibilityBits);
         needsSort = 1;
         hasPointLights = pointLightCount > 0;
     }
 }
 
 EMSCRIPTEN_KEEPALIVE void removeSpotLight(int idx) {
+    // Queued commands address lights by their index before the removal
+    if (commandQueue) drainLightCommands();
     if (idx >= 0 && idx < spotLightCount) {
         if (spotLights[idx].anim.flags != ANIM_NONE) {
             // Check if this was the last animated light
@@ -1891,15 +3286,22 @@ EMSCRIPTEN_KEEPALIVE void removeSpotLight(int idx) {
             }
         }
         
+        STAMP_ORDER(spotLights, spotLightCount, LIGHT_TYPE_SPOT);
         memmove(&spotLights[idx], &spotLights[idx+1], 
                 (size_t)(spotLightCount - idx - 1) * sizeof(SpotLight));
         spotLightCount--;
+        orderStamped[LIGHT_TYPE_SPOT] = spotLightCount;
+        if (idx < sortedCount[LIGHT_TYPE_SPOT]) sortedCount[LIGHT_TYPE_SPOT]--;
+        orderChanged |= 1u << LIGHT_TYPE_SPOT;
+        REBUILD_VISIBILITY_BITS(spotLights, spotLightCount, spotVisibilityBits);
         needsSort = 1;
         hasSpotLights = spotLightCount > 0;
     }
 }
 
 EMSCRIPTEN_KEEPALIVE void removeRectLight(int idx) {
+    // Queued commands address lights by their index before the removal
+    if (commandQueue) drainLightCommands();
     if (idx >= 0 && idx < rectLightCount) {
         if (rectLights[idx].anim.flags != ANIM_NONE) {
             // Check if this was the last animated light
@@ -1928,285 +3330,1298 @@ EMSCRIPTEN_KEEPALIVE void removeRectLight(int idx) {
             }
         }
         
+        STAMP_ORDER(rectLights, rectLightCount, LIGHT_TYPE_RECT);
         memmove(&rectLights[idx], &rectLights[idx+1], 
                 (size_t)(rectLightCount - idx - 1) * sizeof(RectLight));
         rectLightCount--;
+        orderStamped[LIGHT_TYPE_RECT] = rectLightCount;
+        if (idx < sortedCount[LIGHT_TYPE_RECT]) sortedCount[LIGHT_TYPE_RECT]--;
+        orderChanged |= 1u << LIGHT_TYPE_RECT;
+        REBUILD_VISIBILITY_BITS(rectLights, rectLightCount, rectVisibilityBits);
         needsSort = 1;
         hasRectLights = rectLightCount > 0;
     }
 }
 
+static int compareIndices(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int anyLightAnimated(void) {
+    for (int i = 0; i < pointLightCount; i++) if (pointLights[i].anim.flags != ANIM_NONE) return 1;
+    for (int i = 0; i < spotLightCount; i++) if (spotLights[i].anim.flags != ANIM_NONE) return 1;
+    for (int i = 0; i < rectLightCount; i++) if (rectLights[i].anim.flags != ANIM_NONE) return 1;
+    return 0;
+}
+
+// Remove `count` lights of one type whose indices the host wrote to
+// getPatchIndices(). Survivors keep their relative (Morton) order, so the
+// sorted prefix stays valid; the host picks up new indices via syncLightOrder.
+#define REMOVE_LIGHTS_IMPL(TYPE, array, total, t, bits, hasFlag) \
+    do { \
+        STAMP_ORDER(array, total, t); \
+        int out = indices[0], sortedLost = 0; \
+        for (int r = 0; r < n; r++) { \
+            animated |= array[indices[r]].anim.flags != ANIM_NONE; \
+            sortedLost += (int)indices[r] < sortedCount[t]; \
+            int next = r + 1 < n ? (int)indices[r + 1] : (total); \
+            int run = next - (int)indices[r] - 1; \
+            if (run > 0) memmove(&array[out], &array[indices[r] + 1], (size_t)run * sizeof(TYPE)); \
+            out += run; \
+        } \
+        total = out; \
+        orderStamped[t] = out; \
+        sortedCount[t] -= sortedLost; \
+        orderChanged |= 1u << (t); \
+        REBUILD_VISIBILITY_BITS(array, total, bits); \
+        hasFlag = total > 0; \
+    } while (0)
+
+EMSCRIPTEN_KEEPALIVE int removeLights(int type, int count) {
+    if (commandQueue) drainLightCommands();
+    int total = type == LIGHT_TYPE_SPOT ? spotLightCount :
+                type == LIGHT_TYPE_RECT ? rectLightCount : pointLightCount;
+    uint32_t *indices = patchIndices;
+    int animated = 0;
+
+    // Sort, then drop duplicates and out-of-range entries
+    qsort(indices, (size_t)count, sizeof(uint32_t), compareIndices);
+    int n = 0;
+    for (int r = 0; r < count; r++) {
+        if ((int)indices[r] >= total) break;
+        if (n == 0 || indices[r] != indices[n - 1]) indices[n++] = indices[r];
+    }
+    if (n == 0) return 0;
+
+    if (type == LIGHT_TYPE_SPOT) {
+        REMOVE_LIGHTS_IMPL(SpotLight, spotLights, spotLightCount, LIGHT_TYPE_SPOT, spotVisibilityBits, hasSpotLights);
+    } else if (type == LIGHT_TYPE_RECT) {
+        REMOVE_LIGHTS_IMPL(RectLight, rectLights, rectLightCount, LIGHT_TYPE_RECT, rectVisibilityBits, hasRectLights);
+    } else {
+        REMOVE_LIGHTS_IMPL(PointLight, pointLights, pointLightCount, LIGHT_TYPE_POINT, pointVisibilityBits, hasPointLights);
+    }
+
+    if (animated) hasAnimatedLights = anyLightAnimated();
+    return n;
+}
+
+EMSCRIPTEN_KEEPALIVE uint32_t* getPatchIndices(void) { return patchIndices; }
+EMSCRIPTEN_KEEPALIVE float* getPatchVectors(void) { return patchVectors; }
+
 // ──────────────────────────────────────────────────────────────
 //                            SORT
 // ──────────────────────────────────────────────────────────────
 EMSCRIPTEN_KEEPALIVE void sort(void) {
     // Only sort during initialization or when base positions change
     if (needsSort) {
-        if (pointLightCount > 1) radixSortPointLights(pointLightCount);
-        if (spotLightCount > 1) radixSortSpotLights(spotLightCount);
-        if (rectLightCount > 1) radixSortRectLights(rectLightCount);
+        // Queued commands address lights by their current index
+        if (commandQueue) drainLightCommands();
+        SORT_LIGHTS(PointLight, pointLights, pointLightsScratch, pointLightCount,
+                    LIGHT_TYPE_POINT, pointVisibilityBits)
+        SORT_LIGHTS(SpotLight, spotLights, spotLightsScratch, spotLightCount,
+                    LIGHT_TYPE_SPOT, spotVisibilityBits)
+        SORT_LIGHTS(RectLight, rectLights, rectLightsScratch, rectLightCount,
+                    LIGHT_TYPE_RECT, rectVisibilityBits)
         needsSort = 0;
     }
 }
 
+// Report where lights moved since the last sync: fills getLightOrder() with
+// the previous index of each current light (removed lights are gone) and
+// makes the current order the new baseline. Returns 0 when nothing moved.
+EMSCRIPTEN_KEEPALIVE int syncLightOrder(int type) {
+    int moved = 0;
+    orderChanged &= ~(1u << type);
+
+    #define SYNC_ORDER_IMPL(array, count, t) \
+        do { \
+            STAMP_ORDER(array, count, t); \
+            for (int i = 0; i < (count); i++) { \
+                lightOrder[i] = array[i].order; \
+                moved |= array[i].order != (uint32_t)i; \
+                array[i].order = (uint32_t)i; \
+            } \
+        } while (0)
+
+    if (type == LIGHT_TYPE_SPOT) SYNC_ORDER_IMPL(spotLights, spotLightCount, LIGHT_TYPE_SPOT);
+    else if (type == LIGHT_TYPE_RECT) SYNC_ORDER_IMPL(rectLights, rectLightCount, LIGHT_TYPE_RECT);
+    else SYNC_ORDER_IMPL(pointLights, pointLightCount, LIGHT_TYPE_POINT);
+
+    #undef SYNC_ORDER_IMPL
+    return moved;
+}
+
+EMSCRIPTEN_KEEPALIVE uint32_t getLightOrderChanges(void) { return orderChanged; }
+EMSCRIPTEN_KEEPALIVE uint32_t* getLightOrder(void) { return lightOrder; }
+
 // ──────────────────────────────────────────────────────────────
-//                   UPDATE FUNCTIONS WITH FAST PATHS
+//                   LIGHT STATE DELTAS
 // ──────────────────────────────────────────────────────────────
-EMSCRIPTEN_KEEPALIVE int update(float time) {
-    // Cache view matrix elements
-    float *e = cameraMatrix->te;
-    e0 = e[0];  e1 = e[1];  e2 = e[2];
-    e4 = e[4];  e5 = e[5];  e6 = e[6];
-    e8 = e[8];  e9 = e[9];  e10= e[10];
-    e12= e[12]; e13= e[13]; e14= e[14];
+// Replication stream between cores. Each light's authored state is
+// quantised into DELTA_FIELDS integers. encodeLightDelta() compares them
+// with the values last sent and writes only the changed fields, as zigzag
+// varint differences, so bandwidth scales with the edits, not the scene.
+//
+// Stream: varint flags (DELTA_KEYFRAME), varint count per type, then per
+// type a list of {varint index gap (>= 1), varint field mask, fields...}
+// ended by a zero gap. DELTA_ANIM carries varint flags followed by the
+// canonical payload of the kinds they enable (writeAnim).
+//
+// Lights are keyed by index. A receiver takes the sender's order as-is and
+// never re-sorts it; lights the sender's sort moves are simply resent.
+#define DELTA_POS_X            0
+#define DELTA_POS_Y            1
+#define DELTA_POS_Z            2
+#define DELTA_RADIUS           3
+#define DELTA_COLOR_R          4
+#define DELTA_COLOR_G          5
+#define DELTA_COLOR_B          6
+#define DELTA_INTENSITY        7
+#define DELTA_DECAY            8
+#define DELTA_FLAGS            9   // visible | castsShadow << 1 | layerMask << 8
+#define DELTA_GROUPS           10
+#define DELTA_SHADOW_INTENSITY 11
+#define DELTA_ANIM             12  // Hash of AnimationParams (payload: see above)
+#define DELTA_DIR_X            13  // Spot direction / rect normal
+#define DELTA_DIR_Y            14
+#define DELTA_DIR_Z            15
+#define DELTA_PARAM_A          16  // Spot angle / rect width
+#define DELTA_PARAM_B          17  // Spot penumbra / rect height
+#define DELTA_FIELDS           18
+
+#define DELTA_KEYFRAME         0x1u
+
+#define DELTA_DISTANCE_STEPS   1024.0f   // Positions, radius, rect size
+#define DELTA_COLOR_STEPS      1024.0f
+#define DELTA_INTENSITY_STEPS  256.0f
+#define DELTA_UNIT_STEPS       32767.0f  // Directions, shadow intensity
+#define DELTA_ANGLE_STEPS      4096.0f   // Radians
+
+#define ANIM_ALL               0x3Fu
+#define ANIM_WIRE_MAX          95        // Payload with every kind active
+
+// Worst case for one light: gap + mask + every field + animation payload
+#define DELTA_MAX_LIGHT_BYTES  (10 + DELTA_FIELDS * 5 + ANIM_WIRE_MAX)
+
+ALWAYS_INLINE static int32_t quantize(float v, float steps) {
+    return (int32_t)lrintf(v * steps);
+}
 
-    int animated = 0;
+ALWAYS_INLINE static float dequantize(int32_t q, float steps) {
+    return (float)q / steps;
+}
 
-    // Fast path: Only point lights
-    if (hasPointLights && !hasSpotLights && !hasRectLights) {
-        #ifdef __wasm_simd128__
-        updatePointLightsSIMD(time);
-        #else
-        for (int i = 0; i < pointLightCount; i++) {
-            PointLight *l = &pointLights[i];
-            PointLightDataOptimized *ld = &pointLightTexture[i];
-            
-            // Process animation
-            if (l->anim.flags != ANIM_NONE) {
-                processPointLightAnimation(l, time);
-                animated = 1;
-            } else {
-                l->worldPos = l->baseWorldPos;
-            }
-            
-            // Transform to view space
-            worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
-            
-            // Calculate LOD level
-            l->lodLevel = calculateLOD(l->viewPos.z, l->worldPos.w);
-            
-            // Visibility culling
-            uint8_t culled = 0;
-            if (l->viewPos.z > l->worldPos.w - viewNear || l->viewPos.z < -viewFar - l->worldPos.w) {
-                culled = 1;
-            }
-            
-            // Update texture data
-            ld->positionRadius = l->viewPos;
-            ld->colorDecayVisible = (Vec4){
-                l->color.x * l->color.w,
-                l->color.y * l->color.w,
-                l->color.z * l->color.w,
-                packLightParams(l->decay, l->visible && !culled, l->lodLevel)
-            };
-            
-            l->dirty = 0;
+// Canonical animation wire form: for each active kind in flag order, its
+// fields as little-endian float bits (modes as one byte). Inactive kinds,
+// padding and the unused w lanes never reach the stream or the hash.
+
+ALWAYS_INLINE static int putAnimFloat(uint8_t *out, int n, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    out[n] = (uint8_t)bits;
+    out[n + 1] = (uint8_t)(bits >> 8);
+    out[n + 2] = (uint8_t)(bits >> 16);
+    out[n + 3] = (uint8_t)(bits >> 24);
+    return n + 4;
+}
+
+ALWAYS_INLINE static float getAnimFloat(const uint8_t *in) {
+    uint32_t bits = (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// Payload bytes carried for `flags`
+static int animWireSize(uint32_t flags) {
+    int n = 0;
+    if (flags & ANIM_CIRCULAR) n += 8;
+    if (flags & ANIM_LINEAR) n += 21;
+    if (flags & ANIM_WAVE) n += 24;
+    if (flags & ANIM_FLICKER) n += 12;
+    if (flags & ANIM_PULSE) n += 9;
+    if (flags & ANIM_ROTATE) n += 21;
+    return n;
+}
+
+// Write the payload of `a` to `out` (ANIM_WIRE_MAX bytes); returns its length
+static int writeAnim(const AnimationParams *a, uint8_t *out) {
+    int n = 0;
+    if (a->flags & ANIM_CIRCULAR) {
+        n = putAnimFloat(out, n, a->circular.speed);
+        n = putAnimFloat(out, n, a->circular.radius);
+    }
+    if (a->flags & ANIM_LINEAR) {
+        n = putAnimFloat(out, n, a->linear.targetPos.x);
+        n = putAnimFloat(out, n, a->linear.targetPos.y);
+        n = putAnimFloat(out, n, a->linear.targetPos.z);
+        n = putAnimFloat(out, n, a->linear.duration);
+        n = putAnimFloat(out, n, a->linear.delay);
+        out[n++] = a->linear.mode;
+    }
+    if (a->flags & ANIM_WAVE) {
+        n = putAnimFloat(out, n, a->wave.axis.x);
+        n = putAnimFloat(out, n, a->wave.axis.y);
+        n = putAnimFloat(out, n, a->wave.axis.z);
+        n = putAnimFloat(out, n, a->wave.speed);
+        n = putAnimFloat(out, n, a->wave.amplitude);
+        n = putAnimFloat(out, n, a->wave.phase);
+    }
+    if (a->flags & ANIM_FLICKER) {
+        n = putAnimFloat(out, n, a->flicker.speed);
+        n = putAnimFloat(out, n, a->flicker.intensity);
+        n = putAnimFloat(out, n, a->flicker.seed);
+    }
+    if (a->flags & ANIM_PULSE) {
+        n = putAnimFloat(out, n, a->pulse.speed);
+        n = putAnimFloat(out, n, a->pulse.amount);
+        out[n++] = a->pulse.target;
+    }
+    if (a->flags & ANIM_ROTATE) {
+        n = putAnimFloat(out, n, a->rotation.axis.x);
+        n = putAnimFloat(out, n, a->rotation.axis.y);
+        n = putAnimFloat(out, n, a->rotation.axis.z);
+        n = putAnimFloat(out, n, a->rotation.speed);
+        n = putAnimFloat(out, n, a->rotation.angle);
+        out[n++] = a->rotation.mode;
+    }
+    return n;
+}
+
+// Inverse of writeAnim; the caller has checked animWireSize(flags) bytes remain
+static void readAnim(AnimationParams *a, uint32_t flags, const uint8_t *in) {
+    memset(a, 0, sizeof(*a));
+    a->flags = flags;
+    if (flags & ANIM_CIRCULAR) {
+        a->circular.speed = getAnimFloat(in);
+        a->circular.radius = getAnimFloat(in + 4);
+        in += 8;
+    }
+    if (flags & ANIM_LINEAR) {
+        a->linear.targetPos = (Vec4){getAnimFloat(in), getAnimFloat(in + 4), getAnimFloat(in + 8), 0.f};
+        a->linear.duration = getAnimFloat(in + 12);
+        a->linear.delay = getAnimFloat(in + 16);
+        a->linear.mode = in[20];
+        in += 21;
+    }
+    if (flags & ANIM_WAVE) {
+        a->wave.axis = (Vec4){getAnimFloat(in), getAnimFloat(in + 4), getAnimFloat(in + 8), 0.f};
+        a->wave.speed = getAnimFloat(in + 12);
+        a->wave.amplitude = getAnimFloat(in + 16);
+        a->wave.phase = getAnimFloat(in + 20);
+        in += 24;
+    }
+    if (flags & ANIM_FLICKER) {
+        a->flicker.speed = getAnimFloat(in);
+        a->flicker.intensity = getAnimFloat(in + 4);
+        a->flicker.seed = getAnimFloat(in + 8);
+        in += 12;
+    }
+    if (flags & ANIM_PULSE) {
+        a->pulse.speed = getAnimFloat(in);
+        a->pulse.amount = getAnimFloat(in + 4);
+        a->pulse.target = in[8];
+        in += 9;
+    }
+    if (flags & ANIM_ROTATE) {
+        a->rotation.axis = (Vec4){getAnimFloat(in), getAnimFloat(in + 4), getAnimFloat(in + 8), 0.f};
+        a->rotation.speed = getAnimFloat(in + 12);
+        a->rotation.angle = getAnimFloat(in + 16);
+        a->rotation.mode = in[20];
+    }
+}
+
+// FNV-1a over the flags and canonical payload; 0 is reserved for "no animation"
+static uint32_t animHash(const AnimationParams *a) {
+    if (a->flags == ANIM_NONE) return 0;
+    uint8_t wire[ANIM_WIRE_MAX];
+    int n = writeAnim(a, wire);
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 4; i++) h = (h ^ (uint8_t)(a->flags >> (i * 8))) * 16777619u;
+    for (int i = 0; i < n; i++) h = (h ^ wire[i]) * 16777619u;
+    return h ? h : 1;
+}
+
+static int ensureDeltaState(void) {
+    for (int t = 0; t < 3; t++) {
+        if (!deltaSnapshots[t]) {
+            deltaSnapshots[t] = (int32_t*)calloc((size_t)maxLights * DELTA_FIELDS, sizeof(int32_t));
+            if (!deltaSnapshots[t]) return 0;
+            deltaCounts[t] = 0;
         }
-        #endif
-        return animated || hasAnimatedLights;
     }
+    return 1;
+}
 
-    // Fast path: Only spot lights
-    if (!hasPointLights && hasSpotLights && !hasRectLights) {
-        for (int i = 0; i < spotLightCount; i++) {
-            SpotLight *l = &spotLights[i];
-            SpotLightData *ld = &spotLightTexture[i];
-            
-            // Process animation
-            if (l->anim.flags != ANIM_NONE) {
-                processSpotLightAnimation(l, time);
-                animated = 1;
-            } else {
-                l->worldPos = l->baseWorldPos;
-            }
-            
-            // Transform position and direction to view space
-            worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
-            worldDirToView(&l->direction, &l->viewDir);
-            
-            // Calculate LOD level
-            l->lodLevel = calculateLOD(l->viewPos.z, l->worldPos.w);
-            
-            // Visibility culling
-            uint8_t culled = 0;
-            if (l->viewPos.z > l->worldPos.w - viewNear || l->viewPos.z < -viewFar - l->worldPos.w) {
-                culled = 1;
-            }
-            
-            ld->positionRadius = l->viewPos;
-            ld->colorIntensity = l->color;
-            ld->direction = l->viewDir;
-            ld->angleParams = (Vec4){
-                cosf(l->angle), 
-                cosf(l->angle - l->penumbra), 
-                l->decay, 
-                packVisibleLOD(l->visible && !culled, l->lodLevel)
-            };
-            
-            l->dirty = 0;
+static int ensureDeltaCapacity(int extra) {
+    if (deltaSize + extra <= deltaCapacity) return 1;
+    int capacity = deltaCapacity ? deltaCapacity : 4096;
+    while (capacity < deltaSize + extra) capacity *= 2;
+    uint8_t *grown = (uint8_t*)realloc(deltaBuffer, (size_t)capacity);
+    if (!grown) return 0;
+    deltaBuffer = grown;
+    deltaCapacity = capacity;
+    return 1;
+}
+
+ALWAYS_INLINE static void putVarint(uint32_t v) {
+    while (v >= 0x80) {
+        deltaBuffer[deltaSize++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    deltaBuffer[deltaSize++] = (uint8_t)v;
+}
+
+ALWAYS_INLINE static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+ALWAYS_INLINE static int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Returns 0 on truncated input
+ALWAYS_INLINE static int getVarint(const uint8_t *data, int size, int *pos, uint32_t *out) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*pos >= size) return 0;
+        uint8_t b = data[(*pos)++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *out = v;
+            return 1;
         }
-        return animated || hasAnimatedLights;
     }
+    return 0;
+}
 
-    // Fast path: Only rect lights
-    if (!hasPointLights && !hasSpotLights && hasRectLights) {
-        for (int i = 0; i < rectLightCount; i++) {
-            RectLight *l = &rectLights[i];
-            RectLightData *ld = &rectLightTexture[i];
-            
-            // Process animation
-            if (l->anim.flags != ANIM_NONE) {
-                processRectLightAnimation(l, time);
-                animated = 1;
-            } else {
-                l->worldPos = l->baseWorldPos;
+// Fields shared by all types; colour and intensity are the authored values,
+// not the animated ones flicker and pulse write each frame
+#define QUANTIZE_COMMON(l, q) \
+    do { \
+        q[DELTA_POS_X] = quantize(l->baseWorldPos.x, DELTA_DISTANCE_STEPS); \
+        q[DELTA_POS_Y] = quantize(l->baseWorldPos.y, DELTA_DISTANCE_STEPS); \
+        q[DELTA_POS_Z] = quantize(l->baseWorldPos.z, DELTA_DISTANCE_STEPS); \
+        q[DELTA_RADIUS] = quantize(l->baseWorldPos.w, DELTA_DISTANCE_STEPS); \
+        q[DELTA_COLOR_R] = quantize(l->baseColor.x, DELTA_COLOR_STEPS); \
+        q[DELTA_COLOR_G] = quantize(l->baseColor.y, DELTA_COLOR_STEPS); \
+        q[DELTA_COLOR_B] = quantize(l->baseColor.z, DELTA_COLOR_STEPS); \
+        q[DELTA_INTENSITY] = quantize(l->baseColor.w, DELTA_INTENSITY_STEPS); \
+        q[DELTA_DECAY] = quantize(l->decay, PACK_DECAY_STEPS); \
+        q[DELTA_FLAGS] = (l->visible ? 1 : 0) | (l->castsShadow ? 2 : 0) | ((int32_t)l->layerMask << 8); \
+        q[DELTA_GROUPS] = (int32_t)l->groupMask; \
+        q[DELTA_SHADOW_INTENSITY] = quantize(l->shadowIntensity, DELTA_UNIT_STEPS); \
+        q[DELTA_ANIM] = (int32_t)animHash(&l->anim); \
+    } while (0)
+
+static void quantizeLight(int type, int idx, int32_t *q) {
+    if (type == LIGHT_TYPE_SPOT) {
+        const SpotLight *l = &spotLights[idx];
+        QUANTIZE_COMMON(l, q);
+        q[DELTA_DIR_X] = quantize(l->baseDir.x, DELTA_UNIT_STEPS);
+        q[DELTA_DIR_Y] = quantize(l->baseDir.y, DELTA_UNIT_STEPS);
+        q[DELTA_DIR_Z] = quantize(l->baseDir.z, DELTA_UNIT_STEPS);
+        q[DELTA_PARAM_A] = quantize(l->angle, DELTA_ANGLE_STEPS);
+        q[DELTA_PARAM_B] = quantize(l->penumbra, DELTA_ANGLE_STEPS);
+    } else if (type == LIGHT_TYPE_RECT) {
+        const RectLight *l = &rectLights[idx];
+        QUANTIZE_COMMON(l, q);
+        q[DELTA_DIR_X] = quantize(l->baseNormal.x, DELTA_UNIT_STEPS);
+        q[DELTA_DIR_Y] = quantize(l->baseNormal.y, DELTA_UNIT_STEPS);
+        q[DELTA_DIR_Z] = quantize(l->baseNormal.z, DELTA_UNIT_STEPS);
+        q[DELTA_PARAM_A] = quantize(l->size.x, DELTA_DISTANCE_STEPS);
+        q[DELTA_PARAM_B] = quantize(l->size.y, DELTA_DISTANCE_STEPS);
+    } else {
+        const PointLight *l = &pointLights[idx];
+        QUANTIZE_COMMON(l, q);
+        q[DELTA_DIR_X] = q[DELTA_DIR_Y] = q[DELTA_DIR_Z] = 0;
+        q[DELTA_PARAM_A] = q[DELTA_PARAM_B] = 0;
+    }
+}
+
+static AnimationParams* lightAnim(int type, int idx) {
+    if (type == LIGHT_TYPE_SPOT) return &spotLights[idx].anim;
+    if (type == LIGHT_TYPE_RECT) return &rectLights[idx].anim;
+    return &pointLights[idx].anim;
+}
+
+// Blank record for a light that first appears in a delta; every field that
+// differs from zero arrives with it
+#define INIT_DELTA_LIGHT(l, i) \
+    do { \
+        memset(l, 0, sizeof(*l)); \
+        memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes)); \
+        l->lodLevel = LOD_FULL; \
+        l->dirty = DIRTY_ALL; \
+        l->order = (uint32_t)(i); \
+    } while (0)
+
+#define DEQUANTIZE_COMMON(l, q) \
+    do { \
+        l->baseWorldPos = (Vec4){dequantize(q[DELTA_POS_X], DELTA_DISTANCE_STEPS), \
+                                 dequantize(q[DELTA_POS_Y], DELTA_DISTANCE_STEPS), \
+                                 dequantize(q[DELTA_POS_Z], DELTA_DISTANCE_STEPS), \
+                                 dequantize(q[DELTA_RADIUS], DELTA_DISTANCE_STEPS)}; \
+        l->worldPos = l->baseWorldPos; \
+        l->baseColor = (Vec4){dequantize(q[DELTA_COLOR_R], DELTA_COLOR_STEPS), \
+                              dequantize(q[DELTA_COLOR_G], DELTA_COLOR_STEPS), \
+                              dequantize(q[DELTA_COLOR_B], DELTA_COLOR_STEPS), \
+                              dequantize(q[DELTA_INTENSITY], DELTA_INTENSITY_STEPS)}; \
+        l->color = l->baseColor; \
+        l->decay = dequantize(q[DELTA_DECAY], PACK_DECAY_STEPS); \
+        l->visible = (uint8_t)(q[DELTA_FLAGS] & 1); \
+        l->castsShadow = (uint8_t)((q[DELTA_FLAGS] >> 1) & 1); \
+        l->layerMask = (uint8_t)(q[DELTA_FLAGS] >> 8); \
+        l->groupMask = (uint32_t)q[DELTA_GROUPS]; \
+        l->shadowIntensity = dequantize(q[DELTA_SHADOW_INTENSITY], DELTA_UNIT_STEPS); \
+        if (!l->castsShadow) l->shadowSelected = 0; \
+        l->morton = computeMorton(l->baseWorldPos.x, l->baseWorldPos.z); \
+        l->resort = 0; \
+        l->dirty = DIRTY_ALL; \
+    } while (0)
+
+static void dequantizeLight(int type, int idx, const int32_t *q) {
+    if (type == LIGHT_TYPE_SPOT) {
+        SpotLight *l = &spotLights[idx];
+        DEQUANTIZE_COMMON(l, q);
+        l->baseDir = (Vec4){dequantize(q[DELTA_DIR_X], DELTA_UNIT_STEPS),
+                            dequantize(q[DELTA_DIR_Y], DELTA_UNIT_STEPS),
+                            dequantize(q[DELTA_DIR_Z], DELTA_UNIT_STEPS), 0.f};
+        l->direction = l->baseDir;
+        l->angle = dequantize(q[DELTA_PARAM_A], DELTA_ANGLE_STEPS);
+        l->penumbra = dequantize(q[DELTA_PARAM_B], DELTA_ANGLE_STEPS);
+    } else if (type == LIGHT_TYPE_RECT) {
+        RectLight *l = &rectLights[idx];
+        DEQUANTIZE_COMMON(l, q);
+        l->baseNormal = (Vec4){dequantize(q[DELTA_DIR_X], DELTA_UNIT_STEPS),
+                               dequantize(q[DELTA_DIR_Y], DELTA_UNIT_STEPS),
+                               dequantize(q[DELTA_DIR_Z], DELTA_UNIT_STEPS), 0.f};
+        // Quantised components are only nearly unit; frames are kept unit
+        float len = sqrtf(l->baseNormal.x * l->baseNormal.x + l->baseNormal.y * l->baseNormal.y +
+                          l->baseNormal.z * l->baseNormal.z);
+        if (len > 0.0f) {
+            float inv = 1.0f / len;
+            l->baseNormal.x *= inv;
+            l->baseNormal.y *= inv;
+            l->baseNormal.z *= inv;
+        }
+        l->normal = l->baseNormal;
+        buildRectFrame(l);
+        l->size = (Vec4){dequantize(q[DELTA_PARAM_A], DELTA_DISTANCE_STEPS),
+                         dequantize(q[DELTA_PARAM_B], DELTA_DISTANCE_STEPS), 0.f, 0.f};
+    } else {
+        PointLight *l = &pointLights[idx];
+        DEQUANTIZE_COMMON(l, q);
+    }
+}
+
+// Next encode diffs against an empty scene (for a newly joined receiver)
+EMSCRIPTEN_KEEPALIVE void resetLightDelta(void) {
+    deltaKeyframe = 1;
+}
+
+// Encode changes since the previous encode into getLightDeltaBuffer().
+// Returns the byte length, or -1 when out of memory.
+EMSCRIPTEN_KEEPALIVE int encodeLightDelta(void) {
+    if (!ensureDeltaState()) return -1;
+
+    const int counts[3] = { pointLightCount, spotLightCount, rectLightCount };
+    int keyframe = deltaKeyframe;
+    deltaKeyframe = 0;
+    deltaSize = 0;
+
+    if (!ensureDeltaCapacity(16)) return -1;
+    putVarint(keyframe ? DELTA_KEYFRAME : 0);
+    for (int t = 0; t < 3; t++) putVarint((uint32_t)counts[t]);
+
+    for (int t = 0; t < 3; t++) {
+        int32_t *snap = deltaSnapshots[t];
+        int known = keyframe ? 0 : deltaCounts[t];
+        if (counts[t] > known) {
+            memset(snap + (size_t)known * DELTA_FIELDS, 0,
+                   (size_t)(counts[t] - known) * DELTA_FIELDS * sizeof(int32_t));
+        }
+        deltaCounts[t] = counts[t];
+
+        int prev = -1;
+        for (int i = 0; i < counts[t]; i++) {
+            int32_t q[DELTA_FIELDS];
+            int32_t *s = snap + (size_t)i * DELTA_FIELDS;
+            quantizeLight(t, i, q);
+
+            uint32_t mask = 0;
+            for (int f = 0; f < DELTA_FIELDS; f++) {
+                if (q[f] != s[f]) mask |= 1u << f;
             }
-            
-            // Transform position and normal to view space
-            worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
-            worldDirToView(&l->normal, &l->viewNormal);
-            worldDirToView(&l->tangent, &l->viewTangent);
-            
-            // Calculate LOD level
-            l->lodLevel = calculateLOD(l->viewPos.z, l->worldPos.w);
-            
-            // Visibility culling
-            uint8_t culled = 0;
-            if (l->viewPos.z > l->worldPos.w - viewNear || l->viewPos.z < -viewFar - l->worldPos.w) {
-                culled = 1;
+            if (!mask) continue;
+            if (!ensureDeltaCapacity(DELTA_MAX_LIGHT_BYTES + 1)) return -1;
+
+            putVarint((uint32_t)(i - prev));
+            putVarint(mask);
+            prev = i;
+
+            for (int f = 0; f < DELTA_FIELDS; f++) {
+                if (!(mask & (1u << f))) continue;
+                if (f == DELTA_ANIM) {
+                    const AnimationParams *a = lightAnim(t, i);
+                    putVarint(a->flags);
+                    deltaSize += writeAnim(a, deltaBuffer + deltaSize);
+                } else {
+                    putVarint(zigzag(q[f] - s[f]));
+                }
             }
-            
-            ld->positionRadius = l->viewPos;
-            ld->colorIntensity = l->color;
-            ld->sizeParams = (Vec4){
-                l->size.x,
-                l->size.y,
-                l->decay,
-                packVisibleLOD(l->visible && !culled, l->lodLevel)
-            };
-            ld->normal = l->viewNormal;
-            ld->tangent = l->viewTangent;
-            
-            l->dirty = 0;
+            memcpy(s, q, sizeof(q));
         }
-        return animated || hasAnimatedLights;
+        if (!ensureDeltaCapacity(1)) return -1;
+        putVarint(0);
     }
+    return deltaSize;
+}
 
-    // General path: Mixed light types
-    if (hasPointLights) {
-        #ifdef __wasm_simd128__
-        updatePointLightsSIMD(time);
-        animated = animated || (hasAnimatedLights && pointLightCount > 0);
-        #else
-        for (int i = 0; i < pointLightCount; i++) {
-            PointLight *l = &pointLights[i];
-            PointLightDataOptimized *ld = &pointLightTexture[i];
-            
-            if (l->anim.flags != ANIM_NONE) {
-                processPointLightAnimation(l, time);
-                animated = 1;
-            } else {
-                l->worldPos = l->baseWorldPos;
+EMSCRIPTEN_KEEPALIVE uint8_t* getLightDeltaBuffer(void) { return deltaBuffer; }
+
+// Input buffer of at least `size` bytes for applyLightDelta (NULL on OOM)
+EMSCRIPTEN_KEEPALIVE uint8_t* getLightDeltaInput(int size) {
+    if (size > deltaInputCapacity) {
+        uint8_t *grown = (uint8_t*)realloc(deltaInput, (size_t)size);
+        if (!grown) return NULL;
+        deltaInput = grown;
+        deltaInputCapacity = size;
+    }
+    return deltaInput;
+}
+
+// Walk a whole packet without touching any state. Returns 0 when it is
+// truncated or malformed, so applyLightDelta never stops half-way.
+static int validateLightDelta(const uint8_t *data, int size, int pos, const uint32_t *counts) {
+    for (int t = 0; t < 3; t++) {
+        int idx = -1;
+        for (;;) {
+            uint32_t gap, mask;
+            if (!getVarint(data, size, &pos, &gap)) return 0;
+            if (gap == 0) break;
+            if (gap > counts[t] || idx + (int)gap >= (int)counts[t]) return 0;
+            idx += (int)gap;
+            if (!getVarint(data, size, &pos, &mask) || mask == 0 || (mask >> DELTA_FIELDS)) return 0;
+            for (int f = 0; f < DELTA_FIELDS; f++) {
+                if (!(mask & (1u << f))) continue;
+                uint32_t v;
+                if (!getVarint(data, size, &pos, &v)) return 0;
+                if (f == DELTA_ANIM) {
+                    if (v & ~ANIM_ALL) return 0;
+                    int bytes = animWireSize(v);
+                    if (bytes > size - pos) return 0;
+                    pos += bytes;
+                }
             }
-            
-            worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
-            
-            // Calculate LOD level
-            l->lodLevel = calculateLOD(l->viewPos.z, l->worldPos.w);
-            
-            uint8_t culled = 0;
-            if (l->viewPos.z > l->worldPos.w - viewNear || l->viewPos.z < -viewFar - l->worldPos.w) {
-                culled = 1;
+        }
+    }
+    return pos == size;
+}
+
+// Apply `size` bytes from getLightDeltaInput(). The receiver's arrays follow
+// the sender's order, so they are marked sorted. Returns 0, or -1 on
+// malformed input, in which case nothing is applied.
+EMSCRIPTEN_KEEPALIVE int applyLightDelta(int size) {
+    if (!ensureDeltaState() || !deltaInput || size < 0 || size > deltaInputCapacity) return -1;
+
+    const uint8_t *data = deltaInput;
+    int pos = 0;
+    uint32_t flags, counts[3];
+    if (!getVarint(data, size, &pos, &flags)) return -1;
+    for (int t = 0; t < 3; t++) {
+        uint32_t limit = (uint32_t)(t == LIGHT_TYPE_POINT ? pointLightLimit : maxLights);
+        if (!getVarint(data, size, &pos, &counts[t]) || counts[t] > limit) return -1;
+    }
+    if (!validateLightDelta(data, size, pos, counts)) return -1;
+
+    int animCleared = 0;
+    for (int t = 0; t < 3; t++) {
+        int32_t *snap = deltaSnapshots[t];
+        int count = (int)counts[t];
+        int known = (flags & DELTA_KEYFRAME) ? 0 : deltaCounts[t];
+        if (known > count) known = count;
+        if (count != deltaCounts[t]) orderChanged |= 1u << t;
+
+        // Lights new to this receiver start blank, matching the sender's zeroed snapshot
+        for (int i = known; i < count; i++) {
+            if (t == LIGHT_TYPE_SPOT) INIT_DELTA_LIGHT((&spotLights[i]), i);
+            else if (t == LIGHT_TYPE_RECT) INIT_DELTA_LIGHT((&rectLights[i]), i);
+            else INIT_DELTA_LIGHT((&pointLights[i]), i);
+        }
+        if (count > known) {
+            memset(snap + (size_t)known * DELTA_FIELDS, 0,
+                   (size_t)(count - known) * DELTA_FIELDS * sizeof(int32_t));
+        }
+        deltaCounts[t] = count;
+
+        if (t == LIGHT_TYPE_SPOT) spotLightCount = count;
+        else if (t == LIGHT_TYPE_RECT) rectLightCount = count;
+        else pointLightCount = count;
+
+        // Validated above, so the reads below cannot fail
+        int idx = -1;
+        for (;;) {
+            uint32_t gap = 0, mask = 0;
+            getVarint(data, size, &pos, &gap);
+            if (gap == 0) break;
+            idx += (int)gap;
+            getVarint(data, size, &pos, &mask);
+            orderChanged |= 1u << t;
+
+            int32_t *s = snap + (size_t)idx * DELTA_FIELDS;
+            for (int f = 0; f < DELTA_FIELDS; f++) {
+                if (!(mask & (1u << f))) continue;
+                uint32_t v = 0;
+                getVarint(data, size, &pos, &v);
+                if (f == DELTA_ANIM) {
+                    AnimationParams *a = lightAnim(t, idx);
+                    if (v != ANIM_NONE) hasAnimatedLights = 1;
+                    else if (a->flags != ANIM_NONE) animCleared = 1;
+                    readAnim(a, v, data + pos);
+                    pos += animWireSize(v);
+                    s[f] = (int32_t)animHash(a);
+                } else {
+                    s[f] += unzigzag(v);
+                }
             }
-            
-            ld->positionRadius = l->viewPos;
-            ld->colorDecayVisible = (Vec4){
-                l->color.x * l->color.w,
-                l->color.y * l->color.w,
-                l->color.z * l->color.w,
-                packLightParams(l->decay, l->visible && !culled, l->lodLevel)
-            };
-            
-            l->dirty = 0;
+            dequantizeLight(t, idx, s);
         }
-        #endif
     }
 
-    if (hasSpotLights) {
-        for (int i = 0; i < spotLightCount; i++) {
-            SpotLight *l = &spotLights[i];
-            SpotLightData *ld = &spotLightTexture[i];
-            
-            if (l->anim.flags != ANIM_NONE) {
-                processSpotLightAnimation(l, time);
-                animated = 1;
-            } else {
-                l->worldPos = l->baseWorldPos;
+    REBUILD_VISIBILITY_BITS(pointLights, pointLightCount, pointVisibilityBits);
+    REBUILD_VISIBILITY_BITS(spotLights, spotLightCount, spotVisibilityBits);
+    REBUILD_VISIBILITY_BITS(rectLights, rectLightCount, rectVisibilityBits);
+    for (int t = 0; t < 3; t++) {
+        sortedCount[t] = orderStamped[t] = deltaCounts[t];
+    }
+    hasPointLights = pointLightCount > 0;
+    hasSpotLights = spotLightCount > 0;
+    hasRectLights = rectLightCount > 0;
+    if (animCleared) hasAnimatedLights = anyLightAnimated();
+    return 0;
+}
+
+// ──────────────────────────────────────────────────────────────
+//                   STATIC POINT LIGHTS
+// ──────────────────────────────────────────────────────────────
+// Lights added here are not individually addressable: they have no
+// animation, groups, shadows, visibility events or replication deltas, and
+// are only cleared as a whole. Their texture records follow the dynamic
+// point records (getPointRecordCount), so shaders treat them as points.
+
+// Reserve the pool. Static lights share the point budget with dynamic ones
+// (maxLights, the count the list and master targets are sized for), so the
+// capacity is clamped to the slots dynamic lights leave free and dynamic adds
+// stop at maxLights - capacity. Clears any static lights. Returns the
+// capacity, or -1 on OOM (pool left empty).
+EMSCRIPTEN_KEEPALIVE int reserveStaticPointLights(int capacity) {
+    if (capacity < 0 || !pointLightTexture) return -1;
+    if (capacity > maxLights - pointLightCount) capacity = maxLights - pointLightCount;
+
+    free(staticPointLights);
+    free(staticCells);
+    staticPointLights = NULL;
+    staticCells = NULL;
+    staticPointCount = staticPointCapacity = 0;
+    staticCellCount = staticCellCapacity = 0;
+    pointLightLimit = maxLights;
+    if (capacity == 0) return 0;
+
+    // Each add starts a new cell, so leave room for partial cells
+    int cells = (capacity + STATIC_CELL_LIGHTS - 1) / STATIC_CELL_LIGHTS + 64;
+    if (cells > STATIC_MAX_CELLS) cells = STATIC_MAX_CELLS;
+    if (posix_memalign((void**)&staticPointLights, 16, sizeof(StaticPointLight) * (size_t)capacity) != 0 ||
+        posix_memalign((void**)&staticCells, 16, sizeof(StaticCell) * (size_t)cells) != 0) {
+        free(staticPointLights);
+        staticPointLights = NULL;
+        return -1;
+    }
+    staticPointCapacity = capacity;
+    staticCellCapacity = cells;
+    pointLightLimit = maxLights - capacity;
+    return capacity;
+}
+
+// Input for addStaticPointLights: STATIC_INPUT_FLOATS per light. Shares the
+// generator input buffer; growing it may move it, so take views afterwards.
+EMSCRIPTEN_KEEPALIVE float* getStaticPointInput(int count) {
+    if (count < 0 || count > INT32_MAX / STATIC_INPUT_FLOATS) return NULL;
+    return getLightGeneratorInput(count * STATIC_INPUT_FLOATS);
+}
+
+static int compareKeys64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Quantise `count` lights from getStaticPointInput() into the pool. Lights
+// are Morton-ordered on x/z first so each cell covers a small area. Returns
+// the number added (clamped to the free capacity), or -1 on OOM.
+EMSCRIPTEN_KEEPALIVE int addStaticPointLights(int count) {
+    const float *in = genInput;
+    if (count > staticPointCapacity - staticPointCount) count = staticPointCapacity - staticPointCount;
+    int cellsNeeded = (count + STATIC_CELL_LIGHTS - 1) / STATIC_CELL_LIGHTS;
+    if (cellsNeeded > staticCellCapacity - staticCellCount) {
+        count = (staticCellCapacity - staticCellCount) * STATIC_CELL_LIGHTS;
+        if (count > staticPointCapacity - staticPointCount) count = staticPointCapacity - staticPointCount;
+    }
+    if (count <= 0 || !in || count > genInputCapacity / STATIC_INPUT_FLOATS) return 0;
+
+    uint64_t *order = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)count);
+    if (!order) return -1;
+
+    float minX = in[0], maxX = in[0], minZ = in[2], maxZ = in[2];
+    for (int i = 1; i < count; i++) {
+        const float *p = in + (size_t)i * STATIC_INPUT_FLOATS;
+        minX = fminf(minX, p[0]); maxX = fmaxf(maxX, p[0]);
+        minZ = fminf(minZ, p[2]); maxZ = fmaxf(maxZ, p[2]);
+    }
+    float kx = maxX > minX ? 65535.0f / (maxX - minX) : 0.0f;
+    float kz = maxZ > minZ ? 65535.0f / (maxZ - minZ) : 0.0f;
+    for (int i = 0; i < count; i++) {
+        const float *p = in + (size_t)i * STATIC_INPUT_FLOATS;
+        uint32_t key = computeMorton((p[0] - minX) * kx, (p[2] - minZ) * kz);
+        order[i] = ((uint64_t)key << 32) | (uint32_t)i;
+    }
+    qsort(order, (size_t)count, sizeof(uint64_t), compareKeys64);
+
+    for (int first = 0; first < count; first += STATIC_CELL_LIGHTS) {
+        int n = count - first < STATIC_CELL_LIGHTS ? count - first : STATIC_CELL_LIGHTS;
+
+        // Cell origin at the bounds centre, step from the largest half-extent
+        float lo[3], hi[3];
+        const float *p0 = in + (size_t)(uint32_t)order[first] * STATIC_INPUT_FLOATS;
+        for (int a = 0; a < 3; a++) lo[a] = hi[a] = p0[a];
+        for (int k = 1; k < n; k++) {
+            const float *p = in + (size_t)(uint32_t)order[first + k] * STATIC_INPUT_FLOATS;
+            for (int a = 0; a < 3; a++) {
+                lo[a] = fminf(lo[a], p[a]);
+                hi[a] = fmaxf(hi[a], p[a]);
             }
-            
-            worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
-            worldDirToView(&l->direction, &l->viewDir);
-            
-            // Calculate LOD level
-            l->lodLevel = calculateLOD(l->viewPos.z, l->worldPos.w);
-            
-            uint8_t culled = 0;
-            if (l->viewPos.z > l->worldPos.w - viewNear || l->viewPos.z < -viewFar - l->worldPos.w) {
-                culled = 1;
+        }
+        float extent = fmaxf(fmaxf(hi[0] - lo[0], hi[1] - lo[1]), hi[2] - lo[2]) * 0.5f;
+        float step = extent > 0.0f ? extent / (float)STATIC_QUANT_MAX : 1.0f;
+        float inv = 1.0f / step;
+
+        StaticCell *cell = &staticCells[staticCellCount++];
+        cell->origin = (Vec4){(lo[0] + hi[0]) * 0.5f, (lo[1] + hi[1]) * 0.5f, (lo[2] + hi[2]) * 0.5f, step};
+        cell->first = (uint32_t)staticPointCount;
+        cell->count = (uint32_t)n;
+
+        for (int k = 0; k < n; k++) {
+            const float *p = in + (size_t)(uint32_t)order[first + k] * STATIC_INPUT_FLOATS;
+            StaticPointLight *l = &staticPointLights[staticPointCount++];
+            for (int a = 0; a < 3; a++) {
+                float q = roundf((p[a] - (&cell->origin.x)[a]) * inv);
+                l->pos[a] = (int16_t)clampf(q, -STATIC_QUANT_MAX, STATIC_QUANT_MAX);
             }
-            
-            ld->positionRadius = l->viewPos;
-            ld->colorIntensity = l->color;
-            ld->direction = l->viewDir;
-            ld->angleParams = (Vec4){
-                cosf(l->angle), 
-                cosf(l->angle - l->penumbra), 
-                l->decay, 
-                packVisibleLOD(l->visible && !culled, l->lodLevel)
-            };
-            
-            l->dirty = 0;
+            l->pad = 0;
+            l->radius = p[3];
+            l->color[0] = p[4];
+            l->color[1] = p[5];
+            l->color[2] = p[6];
+            l->params = packLightParams(p[7], 1, LOD_SKIP, PACK_LAYER_DEFAULT);
         }
     }
 
-    if (hasRectLights) {
-        for (int i = 0; i < rectLightCount; i++) {
-            RectLight *l = &rectLights[i];
-            RectLightData *ld = &rectLightTexture[i];
-            
-            if (l->anim.flags != ANIM_NONE) {
-                processRectLightAnimation(l, time);
-                animated = 1;
-            } else {
-                l->worldPos = l->baseWorldPos;
+    free(order);
+    return count;
+}
+
+EMSCRIPTEN_KEEPALIVE void clearStaticPointLights(void) {
+    staticPointCount = 0;
+    staticCellCount = 0;
+}
+
+EMSCRIPTEN_KEEPALIVE int getStaticPointLightCount(void) { return staticPointCount; }
+EMSCRIPTEN_KEEPALIVE int getStaticPointLightCapacity(void) { return staticPointCapacity; }
+
+// Point texture records in use (dynamic then static) and the buffer size;
+// both stay within maxLights
+EMSCRIPTEN_KEEPALIVE int getPointRecordCount(void) { return pointLightCount + staticPointCount; }
+EMSCRIPTEN_KEEPALIVE int getPointTextureCapacity(void) { return lightTextureCapacity; }
+
+// LOD, culling and the visible bit folded into the stored parameter word; the
+// decay rate comes from the word's decay bits
+ALWAYS_INLINE static void packStaticPointLight(int i, const StaticPointLight *l,
+                                               float vx, float vy, float vz, uint8_t lod) {
+    PointLightDataOptimized *ld = POINT_RECORD(i);
+    float hidden = isDepthCulled(vz, l->radius) ? (float)PACK_VISIBLE : 0.0f;
+    float decay = (float)((uint32_t)l->params >> PACK_DECAY_SHIFT) * (1.0f / PACK_DECAY_STEPS);
+    ld->positionInvRadius = (Vec4){vx, vy, vz, l->radius > 0.0f ? 1.0f / l->radius : 0.0f};
+    ld->colorDecayVisible = (Vec4){l->color[0], l->color[1], l->color[2], l->params + (float)lod - hidden};
+    ld->falloff = (Vec4){decayRate(decay), 0.0f, 0.0f, 0.0f};
+}
+
+// Decode, transform, LOD and pack every static light, a cell at a time
+static void updateStaticPointLights(void) {
+#ifdef __wasm_simd128__
+    v128_t e0v = wasm_f32x4_splat(e0), e1v = wasm_f32x4_splat(e1), e2v = wasm_f32x4_splat(e2);
+    v128_t e4v = wasm_f32x4_splat(e4), e5v = wasm_f32x4_splat(e5), e6v = wasm_f32x4_splat(e6);
+    v128_t e8v = wasm_f32x4_splat(e8), e9v = wasm_f32x4_splat(e9), e10v = wasm_f32x4_splat(e10);
+    v128_t e12v = wasm_f32x4_splat(e12), e13v = wasm_f32x4_splat(e13), e14v = wasm_f32x4_splat(e14);
+#endif
+
+    for (int c = 0; c < staticCellCount; c++) {
+        const StaticCell *cell = &staticCells[c];
+        const StaticPointLight *l = &staticPointLights[cell->first];
+        int base = pointLightCount + (int)cell->first;
+        int n = (int)cell->count;
+        int i = 0;
+#ifdef __wasm_simd128__
+        v128_t ox = wasm_f32x4_splat(cell->origin.x);
+        v128_t oy = wasm_f32x4_splat(cell->origin.y);
+        v128_t oz = wasm_f32x4_splat(cell->origin.z);
+        v128_t step = wasm_f32x4_splat(cell->origin.w);
+        for (; i + 3 < n; i += 4) {
+            const StaticPointLight *q = &l[i];
+            v128_t wx = wasm_f32x4_add(ox, wasm_f32x4_mul(step, wasm_f32x4_convert_i32x4(
+                wasm_i32x4_make(q[0].pos[0], q[1].pos[0], q[2].pos[0], q[3].pos[0]))));
+            v128_t wy = wasm_f32x4_add(oy, wasm_f32x4_mul(step, wasm_f32x4_convert_i32x4(
+                wasm_i32x4_make(q[0].pos[1], q[1].pos[1], q[2].pos[1], q[3].pos[1]))));
+            v128_t wz = wasm_f32x4_add(oz, wasm_f32x4_mul(step, wasm_f32x4_convert_i32x4(
+                wasm_i32x4_make(q[0].pos[2], q[1].pos[2], q[2].pos[2], q[3].pos[2]))));
+
+            float vx[4], vy[4], vz[4];
+            wasm_v128_store(vx, transformRowSIMD(e0v, e4v, e8v, e12v, wx, wy, wz));
+            wasm_v128_store(vy, transformRowSIMD(e1v, e5v, e9v, e13v, wx, wy, wz));
+            wasm_v128_store(vz, transformRowSIMD(e2v, e6v, e10v, e14v, wx, wy, wz));
+
+            uint8_t lod[4];
+            calculateLOD_SIMD(vz[0], q[0].radius, vz[1], q[1].radius,
+                              vz[2], q[2].radius, vz[3], q[3].radius,
+                              &lod[0], &lod[1], &lod[2], &lod[3]);
+            for (int j = 0; j < 4; j++) {
+                packStaticPointLight(base + i + j, &q[j], vx[j], vy[j], vz[j], lod[j]);
             }
-            
-            worldToView(l->worldPos.x, l->worldPos.y, l->worldPos.z, l->worldPos.w, &l->viewPos);
-            worldDirToView(&l->normal, &l->viewNormal);
-            worldDirToView(&l->tangent, &l->viewTangent);
-            
-            // Calculate LOD level
-            l->lodLevel = calculateLOD(l->viewPos.z, l->worldPos.w);
-            
-            uint8_t culled = 0;
-            if (l->viewPos.z > l->worldPos.w - viewNear || l->viewPos.z < -viewFar - l->worldPos.w) {
-                culled = 1;
+        }
+#endif
+        for (; i < n; i++) {
+            Vec4 vp;
+            worldToView(cell->origin.x + cell->origin.w * (float)l[i].pos[0],
+                        cell->origin.y + cell->origin.w * (float)l[i].pos[1],
+                        cell->origin.z + cell->origin.w * (float)l[i].pos[2],
+                        l[i].radius, &vp);
+            packStaticPointLight(base + i, &l[i], vp.x, vp.y, vp.z, calculateLOD(vp.z, l[i].radius));
+        }
+    }
+}
+
+// ──────────────────────────────────────────────────────────────
+//                   UPDATE FUNCTIONS WITH FAST PATHS
+// ──────────────────────────────────────────────────────────────
+static int updatePointLights(float time) {
+    #ifdef __wasm_simd128__
+    return updatePointLightsSIMD(time);
+    #else
+    int animated = 0;
+    for (int i = 0; i < pointLightCount; i++) {
+        animated |= stepPointLight(i, time);
+    }
+    return animated;
+    #endif
+}
+
+static int updateSpotLights(float time) {
+    int animated = 0;
+    for (int i = 0; i < spotLightCount; i++) {
+        animated |= stepSpotLight(i, time);
+    }
+    return animated;
+}
+
+static int updateRectLights(float time) {
+    int animated = 0;
+    for (int i = 0; i < rectLightCount; i++) {
+        animated |= stepRectLight(i, time);
+    }
+    return animated;
+}
+
+// ──────────────────────────────────────────────────────────────
+//                   SHADOW CASTER SELECTION
+// ──────────────────────────────────────────────────────────────
+// Screen importance ~ intensity * projected area (radius^2 / distance^2)
+ALWAYS_INLINE static float shadowScore(const Vec4 *viewPos, float intensity, uint8_t wasSelected) {
+    float d2 = viewPos->x * viewPos->x + viewPos->y * viewPos->y + viewPos->z * viewPos->z;
+    float minD2 = viewNear * viewNear;
+    if (d2 < minD2) d2 = minD2;
+    float score = intensity * viewPos->w * viewPos->w / d2;
+    return wasSelected ? score * shadowHysteresis : score;
+}
+
+// Min-heap on score holding the best shadowBudget candidates seen so far
+ALWAYS_INLINE static void shadowHeapSiftDown(int i) {
+    for (;;) {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < shadowCasterCount && shadowCasters[left].score < shadowCasters[smallest].score) smallest = left;
+        if (right < shadowCasterCount && shadowCasters[right].score < shadowCasters[smallest].score) smallest = right;
+        if (smallest == i) return;
+        ShadowCaster tmp = shadowCasters[i];
+        shadowCasters[i] = shadowCasters[smallest];
+        shadowCasters[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+static void offerShadowCaster(float score, uint8_t type, int index,
+                              const Vec4 *viewPos, const Vec4 *viewDir, float shadowIntensity) {
+    ShadowCaster *c;
+    if (shadowCasterCount < shadowBudget) {
+        // Heap not full: append and sift up
+        int i = shadowCasterCount++;
+        while (i > 0) {
+            int parent = (i - 1) >> 1;
+            if (shadowCasters[parent].score <= score) break;
+            shadowCasters[i] = shadowCasters[parent];
+            i = parent;
+        }
+        c = &shadowCasters[i];
+    } else if (score > shadowCasters[0].score) {
+        // Replace the weakest caster
+        c = &shadowCasters[0];
+    } else {
+        return;
+    }
+
+    c->viewPos = *viewPos;
+    c->viewDir = *viewDir;
+    c->score = score;
+    c->shadowIntensity = shadowIntensity;
+    c->index = (uint32_t)index;
+    c->type = type;
+    if (c == &shadowCasters[0] && shadowCasterCount == shadowBudget) shadowHeapSiftDown(0);
+}
+
+// Pick the top-N shadow casters among lights rendered this frame. Selection
+// flags travel with the light structs, so sorting never resets hysteresis.
+static void selectShadowCasters(void) {
+    shadowCasterCount = 0;
+    if (shadowBudget <= 0) return;
+
+    const Vec4 noDir = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    for (int i = 0; i < pointLightCount; i++) {
+        PointLight *l = &pointLights[i];
+        if (!l->castsShadow) continue;
+        uint8_t was = l->shadowSelected;
+        l->shadowSelected = 0;
+        if (!was) memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
+        if (!(l->visState & VIS_STATE_RENDERED)) continue;
+        offerShadowCaster(shadowScore(&l->viewPos, l->color.w, was), LIGHT_TYPE_POINT, i,
+                          &l->viewPos, &noDir, l->shadowIntensity);
+    }
+
+    for (int i = 0; i < spotLightCount; i++) {
+        SpotLight *l = &spotLights[i];
+        if (!l->castsShadow) continue;
+        uint8_t was = l->shadowSelected;
+        l->shadowSelected = 0;
+        if (!was) memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
+        if (!(l->visState & VIS_STATE_RENDERED)) continue;
+        Vec4 dir = {l->viewDir.x, l->viewDir.y, l->viewDir.z, l->angle};
+        offerShadowCaster(shadowScore(&l->viewPos, l->color.w, was), LIGHT_TYPE_SPOT, i,
+                          &l->viewPos, &dir, l->shadowIntensity);
+    }
+
+    for (int i = 0; i < rectLightCount; i++) {
+        RectLight *l = &rectLights[i];
+        if (!l->castsShadow) continue;
+        uint8_t was = l->shadowSelected;
+        l->shadowSelected = 0;
+        if (!was) memset(l->shadowNodes, 0xFF, sizeof(l->shadowNodes));
+        if (!(l->visState & VIS_STATE_RENDERED)) continue;
+        Vec4 dir = {l->viewNormal.x, l->viewNormal.y, l->viewNormal.z, 0.0f};
+        offerShadowCaster(shadowScore(&l->viewPos, l->color.w, was), LIGHT_TYPE_RECT, i,
+                          &l->viewPos, &dir, l->shadowIntensity);
+    }
+
+    // Most important first (insertion sort, at most MAX_SHADOW_CASTERS entries)
+    for (int i = 1; i < shadowCasterCount; i++) {
+        ShadowCaster c = shadowCasters[i];
+        int j = i - 1;
+        while (j >= 0 && shadowCasters[j].score < c.score) {
+            shadowCasters[j + 1] = shadowCasters[j];
+            j--;
+        }
+        shadowCasters[j + 1] = c;
+    }
+
+    for (int i = 0; i < shadowCasterCount; i++) {
+        const ShadowCaster *c = &shadowCasters[i];
+        if (c->type == LIGHT_TYPE_POINT) pointLights[c->index].shadowSelected = 1;
+        else if (c->type == LIGHT_TYPE_SPOT) spotLights[c->index].shadowSelected = 1;
+        else rectLights[c->index].shadowSelected = 1;
+    }
+}
+
+// ──────────────────────────────────────────────────────────────
+//                   SHADOW ATLAS PLANNER
+// ──────────────────────────────────────────────────────────────
+ALWAYS_INLINE static uint32_t deinterleaveBits(uint32_t x) {
+    x &= 0x55555555u;
+    x = (x | (x >> 1)) & 0x33333333u;
+    x = (x | (x >> 2)) & 0x0F0F0F0Fu;
+    x = (x | (x >> 4)) & 0x00FF00FFu;
+    x = (x | (x >> 8)) & 0x0000FFFFu;
+    return x;
+}
+
+// First node id of a level: (4^level - 1) / 3
+ALWAYS_INLINE static int atlasLevelOffset(int level) {
+    return (int)(((1u << (2 * level)) - 1u) / 3u);
+}
+
+ALWAYS_INLINE static int atlasNodeLevel(int node) {
+    int level = 0;
+    while (level < ATLAS_MAX_DEPTH && node >= atlasLevelOffset(level + 1)) level++;
+    return level;
+}
+
+// Recompute an inner node from its children
+ALWAYS_INLINE static void atlasRefresh(int node) {
+    const uint8_t *c = &atlasState[4 * node + 1];
+    if (c[0] == ATLAS_FULL && c[1] == ATLAS_FULL && c[2] == ATLAS_FULL && c[3] == ATLAS_FULL) {
+        atlasState[node] = ATLAS_FULL;
+    } else if ((c[0] | c[1] | c[2] | c[3]) == ATLAS_FREE) {
+        atlasState[node] = ATLAS_FREE;
+    } else {
+        atlasState[node] = ATLAS_PARTIAL;
+    }
+}
+
+ALWAYS_INLINE static void atlasRefreshAncestors(int node) {
+    while (node > 0) {
+        node = (node - 1) >> 2;
+        atlasRefresh(node);
+    }
+}
+
+// Find a free tile at the target level. Partially used subtrees are tried
+// first so that large free regions stay intact for later requests.
+static int atlasAlloc(int node, int level, int target) {
+    if (level == target) {
+        if (atlasState[node] != ATLAS_FREE) return -1;
+        atlasState[node] = ATLAS_FULL;
+        return node;
+    }
+
+    int first = 4 * node + 1;
+    for (int pass = 0; pass < 2; pass++) {
+        uint8_t want = pass == 0 ? ATLAS_PARTIAL : ATLAS_FREE;
+        for (int c = 0; c < 4; c++) {
+            if (atlasState[first + c] != want) continue;
+            int found = atlasAlloc(first + c, level + 1, target);
+            if (found >= 0) {
+                atlasRefresh(node);
+                return found;
             }
-            
-            ld->positionRadius = l->viewPos;
-            ld->colorIntensity = l->color;
-            ld->sizeParams = (Vec4){
-                l->size.x,
-                l->size.y,
-                l->decay,
-                packVisibleLOD(l->visible && !culled, l->lodLevel)
-            };
-            ld->normal = l->viewNormal;
-            ld->tangent = l->viewTangent;
-            
-            l->dirty = 0;
         }
     }
+    return -1;
+}
+
+// Claim a specific tile (reuse from last frame). Fails if it or any
+// ancestor is already taken.
+static int atlasReserve(int node) {
+    if (atlasState[node] != ATLAS_FREE) return 0;
+    for (int a = node; a > 0; ) {
+        a = (a - 1) >> 2;
+        if (atlasState[a] == ATLAS_FULL) return 0;
+    }
+    atlasState[node] = ATLAS_FULL;
+    atlasRefreshAncestors(node);
+    return 1;
+}
+
+static void atlasRelease(int node) {
+    atlasState[node] = ATLAS_FREE;
+    atlasRefreshAncestors(node);
+}
+
+// Quadtree level whose tile best matches the caster's projected size
+static int shadowTargetLevel(const ShadowCaster *c, int minLevel) {
+    const Vec4 *v = &c->viewPos;
+    float d = sqrtf(v->x * v->x + v->y * v->y + v->z * v->z);
+    if (d < viewNear) d = viewNear;
+    float texels = shadowTileScale * v->w / d;
+
+    int level = 0;
+    float tile = (float)atlasSize;
+    while (level < atlasDepth && tile * 0.5f >= texels) {
+        tile *= 0.5f;
+        level++;
+    }
+    if (level < minLevel) level = minLevel;
+    return level > atlasDepth ? atlasDepth : level;
+}
+
+// Reuse last frame's tiles when the wanted size moved by at most one level
+static int shadowKeepTiles(uint16_t *nodes, int faces, int target) {
+    if (!atlasReuse || nodes[0] == SHADOW_NODE_NONE) return 0;
+
+    int level = atlasNodeLevel(nodes[0]);
+    if (level > atlasDepth || level < target - 1 || level > target + 1) return 0;
+
+    for (int f = 0; f < faces; f++) {
+        if (nodes[f] == SHADOW_NODE_NONE || !atlasReserve(nodes[f])) {
+            while (--f >= 0) atlasRelease(nodes[f]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Allocate all faces at one level, halving the tile size until they fit
+static int shadowAllocTiles(uint16_t *nodes, int faces, int target) {
+    for (int level = target; level <= atlasDepth; level++) {
+        int f = 0;
+        for (; f < faces; f++) {
+            int node = atlasAlloc(0, 0, level);
+            if (node < 0) break;
+            nodes[f] = (uint16_t)node;
+        }
+        if (f == faces) return 1;
+        while (--f >= 0) atlasRelease(nodes[f]);
+    }
+    return 0;
+}
+
+ALWAYS_INLINE static uint16_t* shadowCasterNodes(const ShadowCaster *c, int *faces) {
+    if (c->type == LIGHT_TYPE_POINT) {
+        *faces = SHADOW_CUBE_FACES;
+        return pointLights[c->index].shadowNodes;
+    }
+    *faces = 1;
+    return c->type == LIGHT_TYPE_SPOT ? spotLights[c->index].shadowNodes
+                                      : rectLights[c->index].shadowNodes;
+}
+
+// Place the selected casters in the atlas: cube faces for points, one tile
+// for spot/rect. Tiles kept from last frame are claimed first so stable
+// lights never move; the rest are allocated most important first.
+static void planShadowAtlas(void) {
+    shadowTileCount = 0;
+    memset(atlasState, ATLAS_FREE, (size_t)atlasLevelOffset(atlasDepth + 1));
+
+    uint8_t placed[MAX_SHADOW_CASTERS];
+    int targets[MAX_SHADOW_CASTERS];
+
+    for (int i = 0; i < shadowCasterCount; i++) {
+        int faces;
+        uint16_t *nodes = shadowCasterNodes(&shadowCasters[i], &faces);
+        // Six cube faces must fit, so points never take more than a quarter
+        targets[i] = shadowTargetLevel(&shadowCasters[i], faces > 1 ? 2 : 1);
+        placed[i] = (uint8_t)shadowKeepTiles(nodes, faces, targets[i]);
+    }
+
+    for (int i = 0; i < shadowCasterCount; i++) {
+        if (placed[i]) continue;
+        int faces;
+        uint16_t *nodes = shadowCasterNodes(&shadowCasters[i], &faces);
+        placed[i] = (uint8_t)shadowAllocTiles(nodes, faces, targets[i]);
+
+        // Out of space: evict kept tiles of less important casters (they are
+        // re-allocated later in this loop) rather than starve this one
+        for (int j = shadowCasterCount - 1; !placed[i] && j > i; j--) {
+            if (!placed[j]) continue;
+            int victimFaces;
+            uint16_t *victim = shadowCasterNodes(&shadowCasters[j], &victimFaces);
+            for (int f = 0; f < victimFaces; f++) atlasRelease(victim[f]);
+            placed[j] = 0;
+            placed[i] = (uint8_t)shadowAllocTiles(nodes, faces, targets[i]);
+        }
+
+        if (!placed[i]) memset(nodes, 0xFF, sizeof(uint16_t) * (size_t)faces);
+    }
+
+    for (int i = 0; i < shadowCasterCount; i++) {
+        if (!placed[i]) continue;
+        int faces;
+        uint16_t *nodes = shadowCasterNodes(&shadowCasters[i], &faces);
+        for (int f = 0; f < faces; f++) {
+            int level = atlasNodeLevel(nodes[f]);
+            uint32_t local = (uint32_t)(nodes[f] - atlasLevelOffset(level));
+            int size = atlasSize >> level;
+            ShadowTile *t = &shadowTiles[shadowTileCount++];
+            t->x = (uint16_t)(deinterleaveBits(local) * (uint32_t)size);
+            t->y = (uint16_t)(deinterleaveBits(local >> 1) * (uint32_t)size);
+            t->size = (uint16_t)size;
+            t->caster = (uint8_t)i;
+            t->face = (uint8_t)f;
+        }
+    }
+
+    atlasReuse = 1;
+}
+
+// size: atlas edge in texels, rounded down to a power of two (<= 16384) so
+// every level of the quadtree halves exactly; minTile: smallest tile
+EMSCRIPTEN_KEEPALIVE void setShadowAtlas(int size, int minTile) {
+    if (size < 1) size = 1;
+    if (size > 16384) size = 16384;
+    while (size & (size - 1)) size &= size - 1;
+    if (minTile < 1) minTile = 1;
+    int depth = 0;
+    while (depth < ATLAS_MAX_DEPTH && (size >> (depth + 1)) >= minTile) depth++;
+    atlasSize = size;
+    atlasDepth = depth;
+    atlasReuse = 0;
+}
+
+EMSCRIPTEN_KEEPALIVE void setShadowTileScale(float scale) {
+    shadowTileScale = scale;
+}
+
+EMSCRIPTEN_KEEPALIVE ShadowTile* getShadowTiles(void) { return shadowTiles; }
+EMSCRIPTEN_KEEPALIVE int getShadowTileCount(void) { return shadowTileCount; }
+
+EMSCRIPTEN_KEEPALIVE void setShadowBudget(int count) {
+    shadowBudget = count < 0 ? 0 : (count > MAX_SHADOW_CASTERS ? MAX_SHADOW_CASTERS : count);
+    if (shadowBudget == 0) shadowCasterCount = shadowTileCount = 0;
+}
+
+EMSCRIPTEN_KEEPALIVE int getShadowBudget(void) { return shadowBudget; }
+
+EMSCRIPTEN_KEEPALIVE void setShadowHysteresis(float factor) {
+    shadowHysteresis = factor < 1.0f ? 1.0f : factor;
+}
+
+EMSCRIPTEN_KEEPALIVE ShadowCaster* getShadowCasters(void) { return shadowCasters; }
+EMSCRIPTEN_KEEPALIVE int getShadowCasterCount(void) { return shadowCasterCount; }
+
+EMSCRIPTEN_KEEPALIVE int update(float time) {
+    // Cache view matrix elements
+    float *e = cameraMatrix->te;
+    e0 = e[0];  e1 = e[1];  e2 = e[2];
+    e4 = e[4];  e5 = e[5];  e6 = e[6];
+    e8 = e[8];  e9 = e[9];  e10= e[10];
+    e12= e[12]; e13= e[13]; e14= e[14];
+    viewRigid = viewRotationIsRigid();
+
+    // Change events only describe the current frame
+    visibilityChangeCount = 0;
+
+    if (commandQueue) drainLightCommands();
+
+    bindLightRecords();
+
+    int animated = 0;
+
+    // Each type runs its own tight loop; empty types are skipped entirely
+    if (hasPointLights) animated |= updatePointLights(time);
+    if (staticPointCount > 0) updateStaticPointLights();
+    if (hasSpotLights) animated |= updateSpotLights(time);
+    if (hasRectLights) animated |= updateRectLights(time);
+
+    if (shadowBudget > 0) {
+        selectShadowCasters();
+        planShadowAtlas();
+    }
 
     return animated;
 }
@@ -2268,7 +4683,7 @@ EMSCRIPTEN_KEEPALIVE void updateCircularFast(float time) {
 // Macros to generate update functions for all three light types
 // This eliminates ~500 lines of duplicated code
 
-#define UPDATE_POSITION(TYPE, array, count) \
+#define UPDATE_POSITION(TYPE, array, count, t) \
 EMSCRIPTEN_KEEPALIVE void update##TYPE##LightPosition(int idx, float x, float y, float z) { \
     if (idx >= 0 && idx < count) { \
         array[idx].baseWorldPos.x = x; \
@@ -2279,13 +4694,21 @@ EMSCRIPTEN_KEEPALIVE void update##TYPE##LightPosition(int idx, float x, float y,
         array[idx].worldPos.z = z; \
         array[idx].morton = computeMorton(x, z); \
         array[idx].dirty |= DIRTY_POSITION; \
+        if (idx < sortedCount[t]) { \
+            array[idx].resort = 1; \
+            prefixMoved |= 1u << (t); \
+        } \
         needsSort = 1; \
     } \
 }
 
+// Sets the base values the animation step restarts from each frame
 #define UPDATE_COLOR(TYPE, array, count) \
 EMSCRIPTEN_KEEPALIVE void update##TYPE##LightColor(int idx, float r, float g, float b) { \
     if (idx >= 0 && idx < count) { \
+        array[idx].baseColor.x = r; \
+        array[idx].baseColor.y = g; \
+        array[idx].baseColor.z = b; \
         array[idx].color.x = r; \
         array[idx].color.y = g; \
         array[idx].color.z = b; \
@@ -2296,6 +4719,7 @@ EMSCRIPTEN_KEEPALIVE void update##TYPE##LightColor(int idx, float r, float g, fl
 #define UPDATE_INTENSITY(TYPE, array, count) \
 EMSCRIPTEN_KEEPALIVE void update##TYPE##LightIntensity(int idx, float intensity) { \
     if (idx >= 0 && idx < count) { \
+        array[idx].baseColor.w = intensity; \
         array[idx].color.w = intensity; \
         array[idx].dirty |= DIRTY_COLOR; \
     } \
@@ -2326,29 +4750,63 @@ EMSCRIPTEN_KEEPALIVE void update##TYPE##LightVisibility(int idx, int visible) {
     } \
 }
 
+#define UPDATE_GROUP_MASK(TYPE, array, count) \
+EMSCRIPTEN_KEEPALIVE void update##TYPE##LightGroupMask(int idx, uint32_t mask) { \
+    if (idx >= 0 && idx < count) { \
+        array[idx].groupMask = mask; \
+        array[idx].dirty |= DIRTY_PARAMS; \
+    } \
+}
+
+#define UPDATE_LAYER_MASK(TYPE, array, count) \
+EMSCRIPTEN_KEEPALIVE void update##TYPE##LightLayers(int idx, uint32_t layers) { \
+    if (idx >= 0 && idx < count) { \
+        array[idx].layerMask = (uint8_t)layers; \
+        array[idx].dirty |= DIRTY_PARAMS; \
+    } \
+}
+
+#define UPDATE_SHADOW(TYPE, array, count) \
+EMSCRIPTEN_KEEPALIVE void update##TYPE##LightShadow(int idx, int castsShadow, float shadowIntensity) { \
+    if (idx >= 0 && idx < count) { \
+        array[idx].castsShadow = castsShadow ? 1 : 0; \
+        array[idx].shadowIntensity = shadowIntensity; \
+        if (!castsShadow) array[idx].shadowSelected = 0; \
+    } \
+}
+
 // Generate Point Light update functions
-UPDATE_POSITION(Point, pointLights, pointLightCount)
+UPDATE_POSITION(Point, pointLights, pointLightCount, LIGHT_TYPE_POINT)
 UPDATE_COLOR(Point, pointLights, pointLightCount)
 UPDATE_INTENSITY(Point, pointLights, pointLightCount)
 UPDATE_RADIUS(Point, pointLights, pointLightCount)
 UPDATE_DECAY(Point, pointLights, pointLightCount)
 UPDATE_VISIBILITY(Point, pointLights, pointLightCount)
+UPDATE_GROUP_MASK(Point, pointLights, pointLightCount)
+UPDATE_LAYER_MASK(Point, pointLights, pointLightCount)
+UPDATE_SHADOW(Point, pointLights, pointLightCount)
 
 // Generate Spot Light update functions
-UPDATE_POSITION(Spot, spotLights, spotLightCount)
+UPDATE_POSITION(Spot, spotLights, spotLightCount, LIGHT_TYPE_SPOT)
 UPDATE_COLOR(Spot, spotLights, spotLightCount)
 UPDATE_INTENSITY(Spot, spotLights, spotLightCount)
 UPDATE_RADIUS(Spot, spotLights, spotLightCount)
 UPDATE_DECAY(Spot, spotLights, spotLightCount)
 UPDATE_VISIBILITY(Spot, spotLights, spotLightCount)
+UPDATE_GROUP_MASK(Spot, spotLights, spotLightCount)
+UPDATE_LAYER_MASK(Spot, spotLights, spotLightCount)
+UPDATE_SHADOW(Spot, spotLights, spotLightCount)
 
 // Generate Rect Light update functions
-UPDATE_POSITION(Rect, rectLights, rectLightCount)
+UPDATE_POSITION(Rect, rectLights, rectLightCount, LIGHT_TYPE_RECT)
 UPDATE_COLOR(Rect, rectLights, rectLightCount)
 UPDATE_INTENSITY(Rect, rectLights, rectLightCount)
 UPDATE_RADIUS(Rect, rectLights, rectLightCount)
 UPDATE_DECAY(Rect, rectLights, rectLightCount)
 UPDATE_VISIBILITY(Rect, rectLights, rectLightCount)
+UPDATE_GROUP_MASK(Rect, rectLights, rectLightCount)
+UPDATE_LAYER_MASK(Rect, rectLights, rectLightCount)
+UPDATE_SHADOW(Rect, rectLights, rectLightCount)
 
 // Point Light specific: base color updates for animations
 EMSCRIPTEN_KEEPALIVE void updatePointLightAnimation(int idx, uint32_t animFlags,
@@ -2506,14 +4964,36 @@ EMSCRIPTEN_KEEPALIVE void updateRectLightNormal(int idx, float nx, float ny, flo
             l->baseNormal = l->normal;
 
             // Recompute tangent frame with consistent helper alignment
-            buildOrthonormalBasis(&l->normal, &l->tangent, &l->bitangent);
-            l->baseTangent = l->tangent;
-            l->baseBitangent = l->bitangent;
+            buildRectFrame(l);
             l->dirty |= DIRTY_PARAMS;
         }
     }
 }
 
+// Set the normals of `count` rect lights in one call: indices from
+// getPatchIndices(), xyz per index from getPatchVectors(). Frames are built
+// in one batch; invalid indices and near-zero normals are skipped.
+EMSCRIPTEN_KEEPALIVE int updateRectLightNormals(int count) {
+    int n = 0;
+    for (int k = 0; k < count; k++) {
+        int idx = (int)patchIndices[k];
+        if (idx < 0 || idx >= rectLightCount) continue;
+        const float *v = &patchVectors[k * 3];
+        float len = sqrtf(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+        if (len <= 0.0001f) continue;
+
+        RectLight *l = &rectLights[idx];
+        l->normal.x = v[0] / len;
+        l->normal.y = v[1] / len;
+        l->normal.z = v[2] / len;
+        l->baseNormal = l->normal;
+        l->dirty |= DIRTY_PARAMS;
+        patchIndices[n++] = (uint32_t)idx;
+    }
+    buildRectFrames(0, patchIndices, n);
+    return n;
+}
+
 EMSCRIPTEN_KEEPALIVE void updateRectLightAnimation(int idx, uint32_t animFlags,
     float circSpeed, float circRadius,
     float targetX, float targetY, float targetZ, float duration, float delay, uint8_t linearMode,
@@ -2574,13 +5054,171 @@ EMSCRIPTEN_KEEPALIVE void updateRectLightAnimation(int idx, uint32_t animFlags,
     }
 }
 
+// ──────────────────────────────────────────────────────────────
+//                    LIGHT COMMAND QUEUE
+// ──────────────────────────────────────────────────────────────
+// Bounded lock-free multi-producer, single-consumer ring in linear memory.
+// Producers (other threads, or workers sharing the memory through Atomics)
+// claim a position with a CAS on tail, fill the slot and publish it by
+// storing seq = position + 1. A full ring makes the push fail instead of
+// waiting. update() drains it before processing lights, then applies the
+// drained commands sorted by (producer, order), so the result does not
+// depend on how the producers interleaved.
+
+#define LIGHT_CMD_POSITION   0  // v.f = x, y, z
+#define LIGHT_CMD_COLOR      1  // v.f = r, g, b
+#define LIGHT_CMD_INTENSITY  2  // v.f[0]
+#define LIGHT_CMD_RADIUS     3  // v.f[0]
+#define LIGHT_CMD_DECAY      4  // v.f[0]
+#define LIGHT_CMD_VISIBILITY 5  // v.u[0] != 0
+#define LIGHT_CMD_DIRECTION  6  // v.f = x, y, z: spot direction or rect normal
+#define LIGHT_CMD_LAYERS     7  // v.u[0]
+#define LIGHT_CMD_GROUP_MASK 8  // v.u[0]
+
+// Allocate the queue with `capacity` slots (rounded up to a power of two).
+// Returns its address, which never changes, or NULL on OOM. Commands still
+// queued are dropped when the queue is replaced.
+EMSCRIPTEN_KEEPALIVE LightCommandQueue* initLightCommandQueue(int capacity) {
+    uint32_t slots = 64;
+    while (slots < (uint32_t)capacity && slots < (1u << 20)) slots <<= 1;
+
+    LightCommandQueue *queue = NULL;
+    LightCommand *scratch = NULL;
+    if (posix_memalign((void**)&queue, 64, sizeof(LightCommandQueue) + sizeof(LightCommand) * slots) != 0) return NULL;
+    if (posix_memalign((void**)&scratch, 16, sizeof(LightCommand) * slots) != 0) {
+        free(queue);
+        return NULL;
+    }
+    memset(queue, 0, sizeof(LightCommandQueue) + sizeof(LightCommand) * slots);
+    queue->mask = slots - 1;
+    for (uint32_t i = 0; i < slots; i++) queue->slots[i].seq = i;
+
+    free(commandQueue);
+    free(commandScratch);
+    commandQueue = queue;
+    commandScratch = scratch;
+    return queue;
+}
+
+EMSCRIPTEN_KEEPALIVE LightCommandQueue* getLightCommandQueue(void) { return commandQueue; }
+EMSCRIPTEN_KEEPALIVE int getLightCommandsApplied(void) { return commandQueue ? (int)commandQueue->applied : 0; }
+
+// Producer side for code running in the core's memory. Returns 0 when the
+// ring is full (or absent); never waits.
+EMSCRIPTEN_KEEPALIVE int pushLightCommand(int producer, uint32_t order, int op, int type, int index,
+                                          float a, float b, float c, float d) {
+    LightCommandQueue *queue = commandQueue;
+    if (!queue) return 0;
+
+    uint32_t pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    LightCommand *slot;
+    for (;;) {
+        slot = &queue->slots[pos & queue->mask];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&queue->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->index = index;
+    slot->op = (uint8_t)op;
+    slot->type = (uint8_t)type;
+    slot->producer = (uint8_t)producer;
+    slot->order = order;
+    slot->v.f[0] = a;
+    slot->v.f[1] = b;
+    slot->v.f[2] = c;
+    slot->v.f[3] = d;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static int compareLightCommands(const void *a, const void *b) {
+    const LightCommand *x = (const LightCommand*)a, *y = (const LightCommand*)b;
+    if (x->producer != y->producer) return (int)x->producer - (int)y->producer;
+    int32_t d = (int32_t)(x->order - y->order);
+    return d < 0 ? -1 : (d > 0 ? 1 : 0);
+}
+
+// Field setters shared by all three types
+#define APPLY_LIGHT_COMMAND(TYPE, c) \
+    switch ((c)->op) { \
+        case LIGHT_CMD_POSITION:   update##TYPE##LightPosition((c)->index, (c)->v.f[0], (c)->v.f[1], (c)->v.f[2]); break; \
+        case LIGHT_CMD_COLOR:      update##TYPE##LightColor((c)->index, (c)->v.f[0], (c)->v.f[1], (c)->v.f[2]); break; \
+        case LIGHT_CMD_INTENSITY:  update##TYPE##LightIntensity((c)->index, (c)->v.f[0]); break; \
+        case LIGHT_CMD_RADIUS:     update##TYPE##LightRadius((c)->index, (c)->v.f[0]); break; \
+        case LIGHT_CMD_DECAY:      update##TYPE##LightDecay((c)->index, (c)->v.f[0]); break; \
+        case LIGHT_CMD_VISIBILITY: update##TYPE##LightVisibility((c)->index, (c)->v.u[0] != 0); break; \
+        case LIGHT_CMD_LAYERS:     update##TYPE##LightLayers((c)->index, (c)->v.u[0]); break; \
+        case LIGHT_CMD_GROUP_MASK: update##TYPE##LightGroupMask((c)->index, (c)->v.u[0]); break; \
+    }
+
+static void applyLightCommand(const LightCommand *c) {
+    switch (c->type) {
+        case LIGHT_TYPE_POINT:
+            APPLY_LIGHT_COMMAND(Point, c)
+            break;
+        case LIGHT_TYPE_SPOT:
+            if (c->op == LIGHT_CMD_DIRECTION) updateSpotLightDirection(c->index, c->v.f[0], c->v.f[1], c->v.f[2]);
+            else APPLY_LIGHT_COMMAND(Spot, c)
+            break;
+        case LIGHT_TYPE_RECT:
+            if (c->op == LIGHT_CMD_DIRECTION) updateRectLightNormal(c->index, c->v.f[0], c->v.f[1], c->v.f[2]);
+            else APPLY_LIGHT_COMMAND(Rect, c)
+            break;
+    }
+}
+
+// Take every published command in ring order, freeing each slot as soon as
+// it is copied, then apply them. Stops at the first slot still being
+// written; its producer's commands wait for the next drain.
+static void drainLightCommands(void) {
+    LightCommandQueue *queue = commandQueue;
+    uint32_t head = queue->head;
+    uint32_t slots = queue->mask + 1;
+    int count = 0;
+
+    for (uint32_t n = 0; n < slots; n++, head++) {
+        LightCommand *slot = &queue->slots[head & queue->mask];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != head + 1) break;
+        commandScratch[count++] = *slot;
+        __atomic_store_n(&slot->seq, head + slots, __ATOMIC_RELEASE);
+    }
+    queue->head = head;
+    queue->applied = (uint32_t)count;
+    if (count == 0) return;
+
+    if (count > 1) qsort(commandScratch, (size_t)count, sizeof(LightCommand), compareLightCommands);
+    for (int i = 0; i < count; i++) applyLightCommand(&commandScratch[i]);
+}
+
 // ──────────────────────────────────────────────────────────────
 //                    STATE EXPOSURE TO JS
 // ──────────────────────────────────────────────────────────────
 EMSCRIPTEN_KEEPALIVE void reset(void) {
     pointLightCount = 0;
+    staticPointCount = 0;
+    staticCellCount = 0;
     spotLightCount = 0;
     rectLightCount = 0;
+    visibilityChangeCount = 0;
+    shadowCasterCount = 0;
+    shadowTileCount = 0;
+    atlasReuse = 0;
+    memset(sortedCount, 0, sizeof(sortedCount));
+    prefixMoved = 0;
+    memset(orderStamped, 0, sizeof(orderStamped));
+    orderChanged = 0;
+    if (visibilityWords > 0) {
+        memset(pointVisibilityBits, 0, (size_t)visibilityWords * sizeof(uint32_t));
+        memset(spotVisibilityBits, 0, (size_t)visibilityWords * sizeof(uint32_t));
+        memset(rectVisibilityBits, 0, (size_t)visibilityWords * sizeof(uint32_t));
+    }
     needsSort = 0;
     hasAnimatedLights = 0;
     hasPointLights = 0;
@@ -2590,8 +5228,11 @@ EMSCRIPTEN_KEEPALIVE void reset(void) {
 
 // Set light count directly (for reusing pre-allocated slots)
 EMSCRIPTEN_KEEPALIVE void setPointLightCount(int count) {
-    if (count >= 0 && count <= maxLights) {
+    if (count >= 0 && count <= pointLightLimit) {
         pointLightCount = count;
+        if (sortedCount[LIGHT_TYPE_POINT] > count) sortedCount[LIGHT_TYPE_POINT] = count;
+        if (orderStamped[LIGHT_TYPE_POINT] > count) orderStamped[LIGHT_TYPE_POINT] = count;
+        REBUILD_VISIBILITY_BITS(pointLights, pointLightCount, pointVisibilityBits);
         hasPointLights = (count > 0);
     }
 }
@@ -2599,6 +5240,9 @@ EMSCRIPTEN_KEEPALIVE void setPointLightCount(int count) {
 EMSCRIPTEN_KEEPALIVE void setSpotLightCount(int count) {
     if (count >= 0 && count <= maxLights) {
         spotLightCount = count;
+        if (sortedCount[LIGHT_TYPE_SPOT] > count) sortedCount[LIGHT_TYPE_SPOT] = count;
+        if (orderStamped[LIGHT_TYPE_SPOT] > count) orderStamped[LIGHT_TYPE_SPOT] = count;
+        REBUILD_VISIBILITY_BITS(spotLights, spotLightCount, spotVisibilityBits);
         hasSpotLights = (count > 0);
     }
 }
@@ -2606,6 +5250,9 @@ EMSCRIPTEN_KEEPALIVE void setSpotLightCount(int count) {
 EMSCRIPTEN_KEEPALIVE void setRectLightCount(int count) {
     if (count >= 0 && count <= maxLights) {
         rectLightCount = count;
+        if (sortedCount[LIGHT_TYPE_RECT] > count) sortedCount[LIGHT_TYPE_RECT] = count;
+        if (orderStamped[LIGHT_TYPE_RECT] > count) orderStamped[LIGHT_TYPE_RECT] = count;
+        REBUILD_VISIBILITY_BITS(rectLights, rectLightCount, rectVisibilityBits);
         hasRectLights = (count > 0);
     }
 }
@@ -2614,6 +5261,20 @@ EMSCRIPTEN_KEEPALIVE void* getCameraMatrix(void) { return (void*)cameraMatrix; }
 EMSCRIPTEN_KEEPALIVE void* getPointLightTexture(void) { return (void*)pointLightTexture; }
 EMSCRIPTEN_KEEPALIVE void* getSpotLightTexture(void) { return (void*)spotLightTexture; }
 EMSCRIPTEN_KEEPALIVE void* getRectLightTexture(void) { return (void*)rectLightTexture; }
+EMSCRIPTEN_KEEPALIVE int getLightTextureCapacity(void) { return lightTextureCapacity; }
+
+// Write every light type into one texture (see UNIFIED_ROW_TEXELS) instead of
+// one per type. The layout is refreshed by each update; returns the mode in use.
+EMSCRIPTEN_KEEPALIVE int setUnifiedLightTexture(int enabled) {
+    unifiedLights = enabled ? 1 : 0;
+    bindLightRecords();
+    return unifiedLights;
+}
+
+EMSCRIPTEN_KEEPALIVE void* getUnifiedLightTexture(void) { return (void*)unifiedLightTexture; }
+EMSCRIPTEN_KEEPALIVE int getUnifiedLightRowCapacity(void) { return unifiedRowCapacity; }
+// int32[4]: row width in texels, first spot row, first rect row, rows in use
+EMSCRIPTEN_KEEPALIVE int32_t* getUnifiedLightLayout(void) { return unifiedLayout; }
 EMSCRIPTEN_KEEPALIVE int getPointLightCount(void) { return pointLightCount; }
 EMSCRIPTEN_KEEPALIVE int getSpotLightCount(void) { return spotLightCount; }
 EMSCRIPTEN_KEEPALIVE int getRectLightCount(void) { return rectLightCount; }
@@ -2630,6 +5291,122 @@ EMSCRIPTEN_KEEPALIVE void* getPointLightsArrayPtr(void) { return (void*)&pointLi
 EMSCRIPTEN_KEEPALIVE void* getSpotLightsArrayPtr(void) { return (void*)&spotLights; }
 EMSCRIPTEN_KEEPALIVE void* getRectLightsArrayPtr(void) { return (void*)&rectLights; }
 
+// Byte layout of the light records, so hosts can read lights straight out of
+// the arrays above instead of keeping their own copies. One int32 per
+// LAYOUT_* slot; -1 marks a field the type does not have. Colour, direction
+// and normal point at the authored values, not the per-frame animated ones.
+#define LAYOUT_STRIDE           0
+#define LAYOUT_POSITION         1   // Vec4: xyz = position, w = radius
+#define LAYOUT_COLOR            2   // Vec4: rgb = color, w = intensity
+#define LAYOUT_DECAY            3   // float
+#define LAYOUT_VISIBLE          4   // uint8
+#define LAYOUT_GROUP_MASK       5   // uint32
+#define LAYOUT_LAYER_MASK       6   // uint8
+#define LAYOUT_CASTS_SHADOW     7   // uint8
+#define LAYOUT_SHADOW_INTENSITY 8   // float
+#define LAYOUT_ANIM             9   // AnimationParams
+#define LAYOUT_DIRECTION        10  // Vec4 (spot)
+#define LAYOUT_ANGLE            11  // float (spot)
+#define LAYOUT_PENUMBRA         12  // float (spot)
+#define LAYOUT_SIZE             13  // Vec4: x = width, y = height (rect)
+#define LAYOUT_NORMAL           14  // Vec4 (rect)
+#define LAYOUT_ANIM_CIRCULAR    15  // Offsets below are relative to LAYOUT_ANIM
+#define LAYOUT_ANIM_LINEAR      16
+#define LAYOUT_ANIM_WAVE        17
+#define LAYOUT_ANIM_FLICKER     18
+#define LAYOUT_ANIM_PULSE       19
+#define LAYOUT_ANIM_ROTATION    20
+#define LAYOUT_SLOTS            21
+
+#define LAYOUT_COMMON(T) \
+    [LAYOUT_STRIDE] = sizeof(T), \
+    [LAYOUT_POSITION] = offsetof(T, baseWorldPos), \
+    [LAYOUT_COLOR] = offsetof(T, baseColor), \
+    [LAYOUT_DECAY] = offsetof(T, decay), \
+    [LAYOUT_VISIBLE] = offsetof(T, visible), \
+    [LAYOUT_GROUP_MASK] = offsetof(T, groupMask), \
+    [LAYOUT_LAYER_MASK] = offsetof(T, layerMask), \
+    [LAYOUT_CASTS_SHADOW] = offsetof(T, castsShadow), \
+    [LAYOUT_SHADOW_INTENSITY] = offsetof(T, shadowIntensity), \
+    [LAYOUT_ANIM] = offsetof(T, anim), \
+    [LAYOUT_ANIM_CIRCULAR] = offsetof(AnimationParams, circular), \
+    [LAYOUT_ANIM_LINEAR] = offsetof(AnimationParams, linear), \
+    [LAYOUT_ANIM_WAVE] = offsetof(AnimationParams, wave), \
+    [LAYOUT_ANIM_FLICKER] = offsetof(AnimationParams, flicker), \
+    [LAYOUT_ANIM_PULSE] = offsetof(AnimationParams, pulse), \
+    [LAYOUT_ANIM_ROTATION] = offsetof(AnimationParams, rotation)
+
+static const int32_t pointLightLayout[LAYOUT_SLOTS] = {
+    LAYOUT_COMMON(PointLight),
+    [LAYOUT_DIRECTION] = -1, [LAYOUT_ANGLE] = -1, [LAYOUT_PENUMBRA] = -1,
+    [LAYOUT_SIZE] = -1, [LAYOUT_NORMAL] = -1
+};
+
+static const int32_t spotLightLayout[LAYOUT_SLOTS] = {
+    LAYOUT_COMMON(SpotLight),
+    [LAYOUT_DIRECTION] = offsetof(SpotLight, baseDir),
+    [LAYOUT_ANGLE] = offsetof(SpotLight, angle),
+    [LAYOUT_PENUMBRA] = offsetof(SpotLight, penumbra),
+    [LAYOUT_SIZE] = -1, [LAYOUT_NORMAL] = -1
+};
+
+static const int32_t rectLightLayout[LAYOUT_SLOTS] = {
+    LAYOUT_COMMON(RectLight),
+    [LAYOUT_DIRECTION] = -1, [LAYOUT_ANGLE] = -1, [LAYOUT_PENUMBRA] = -1,
+    [LAYOUT_SIZE] = offsetof(RectLight, size),
+    [LAYOUT_NORMAL] = offsetof(RectLight, baseNormal)
+};
+
+EMSCRIPTEN_KEEPALIVE const int32_t* getLightLayout(int type) {
+    if (type == LIGHT_TYPE_SPOT) return spotLightLayout;
+    if (type == LIGHT_TYPE_RECT) return rectLightLayout;
+    return pointLightLayout;
+}
+EMSCRIPTEN_KEEPALIVE int getLightLayoutSlots(void) { return LAYOUT_SLOTS; }
+EMSCRIPTEN_KEEPALIVE int getTextureLayoutVersion(void) { return TEXTURE_LAYOUT_VERSION; }
+
+// Visibility bitsets (one bit per light, 1 = rendered) and per-frame change events
+EMSCRIPTEN_KEEPALIVE uint32_t* getPointVisibilityBits(void) { return pointVisibilityBits; }
+EMSCRIPTEN_KEEPALIVE uint32_t* getSpotVisibilityBits(void) { return spotVisibilityBits; }
+EMSCRIPTEN_KEEPALIVE uint32_t* getRectVisibilityBits(void) { return rectVisibilityBits; }
+EMSCRIPTEN_KEEPALIVE int getVisibilityWordCount(void) { return visibilityWords; }
+EMSCRIPTEN_KEEPALIVE void* getVisibilityChanges(void) { return (void*)visibilityChanges; }
+EMSCRIPTEN_KEEPALIVE int getVisibilityChangeCount(void) { return visibilityChangeCount; }
+
+// Compact one type's bitset into its visible-index list. Cost is one pass over
+// the bitset words plus one write per rendered light. Returns the list length.
+EMSCRIPTEN_KEEPALIVE int buildVisibleLightList(int type) {
+    const uint32_t *bits;
+    uint32_t *out;
+    int count;
+
+    if (type == LIGHT_TYPE_SPOT) {
+        bits = spotVisibilityBits; out = spotVisibleList; count = spotLightCount;
+    } else if (type == LIGHT_TYPE_RECT) {
+        bits = rectVisibilityBits; out = rectVisibleList; count = rectLightCount;
+    } else {
+        bits = pointVisibilityBits; out = pointVisibleList; count = pointLightCount;
+    }
+    if (!bits || !out) return 0;
+
+    int n = 0;
+    int words = (count + 31) >> 5;
+    for (int w = 0; w < words; w++) {
+        uint32_t m = bits[w];
+        while (m) {
+            out[n++] = ((uint32_t)w << 5) | (uint32_t)__builtin_ctz(m);
+            m &= m - 1;
+        }
+    }
+    return n;
+}
+
+EMSCRIPTEN_KEEPALIVE uint32_t* getVisibleLightList(int type) {
+    if (type == LIGHT_TYPE_SPOT) return spotVisibleList;
+    if (type == LIGHT_TYPE_RECT) return rectVisibleList;
+    return pointVisibleList;
+}
+
 // Get animation flags for a specific light
 EMSCRIPTEN_KEEPALIVE uint32_t getPointLightAnimFlags(int idx) {
     if (idx >= 0 && idx < pointLightCount) {